@@ -0,0 +1,355 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QFile>
+#include <QDir>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QList>
+#include <QVector>
+#include <QDebug>
+#include <algorithm>
+
+#include "asynclogger.h"
+
+
+#define DRAIN_INTERVAL   50 // In msec
+#define FLUSH_INTERVAL 1000 // In msec
+
+
+/*!
+ * \brief The logEntry struct A message waiting to be written
+ */
+struct logEntry {
+    qint64  msecs;
+    QString sFunctionName;
+    QString sMessage;
+};
+
+
+/*!
+ * \brief The LogQueue class A single producer, single consumer ring of messages.
+ *
+ * Every thread that logs owns one of them: the thread pushes,
+ * the writer thread pops, and neither of them ever waits for the other.
+ */
+class LogQueue
+{
+public:
+    LogQueue()
+        : head(0)
+        , tail(0)
+        , dropped(0)
+        , bClosed(0)
+    {
+    }
+
+    // Called only by the owner thread.
+    // Returns the number of queued messages (0 if the queue was full)
+    quint32
+    push(qint64 msecs, const QString& sFunctionName, const QString& sMessage) {
+        quint32 t = tail.loadRelaxed();
+        quint32 nQueued = t - head.loadAcquire();
+        if(nQueued >= capacity) {
+            dropped.fetchAndAddRelaxed(1);
+            return 0;
+        }
+        logEntry& entry = entries[t & (capacity-1)];
+        entry.msecs         = msecs;
+        entry.sFunctionName = sFunctionName;
+        entry.sMessage      = sMessage;
+        tail.storeRelease(t+1);
+        return nQueued+1;
+    }
+
+    // Called only by the writer thread
+    bool
+    pop(logEntry& entry) {
+        quint32 h = head.loadRelaxed();
+        if(h == tail.loadAcquire())
+            return false;
+        logEntry& slot = entries[h & (capacity-1)];
+        entry = slot;
+        slot  = logEntry();// Release the strings in the writer thread
+        head.storeRelease(h+1);
+        return true;
+    }
+
+public:
+    static const quint32    capacity = 1024;// Must be a power of two
+    logEntry                entries[capacity];
+    QAtomicInteger<quint32> head;
+    QAtomicInteger<quint32> tail;
+    QAtomicInteger<quint32> dropped;
+    QAtomicInteger<int>     bClosed;
+};
+
+
+/*!
+ * \brief The queueHolder struct The queue of the calling thread.
+ *
+ * When the thread ends its queue is marked as closed:
+ * the writer will delete it after writing what is left.
+ */
+struct queueHolder {
+    queueHolder()
+        : pQueue(Q_NULLPTR)
+    {
+    }
+    ~queueHolder() {
+        if(pQueue)
+            pQueue->bClosed.storeRelease(1);
+    }
+    LogQueue *pQueue;
+};
+
+
+static thread_local queueHolder threadQueue;
+// The lock is taken only when a thread logs for the first time
+// and by the writer: never on the logging path.
+static QMutex           registryMutex;
+static QList<LogQueue*> registry;
+
+QAtomicPointer<AsyncLogger> AsyncLogger::pInstance(Q_NULLPTR);
+
+
+/*!
+ * \brief earlier Sorts the messages of the different threads by time
+ */
+static bool
+earlier(const logEntry& first, const logEntry& second) {
+    return first.msecs < second.msecs;
+}
+
+
+/*!
+ * \brief AsyncLogger::AsyncLogger The thread that writes the log file
+ * \param pFile The (already open) log file
+ * \param myMaxSize The size that triggers a rotation of the file
+ * \param myKeep How many old log files to keep
+ */
+AsyncLogger::AsyncLogger(QFile *pFile, qint64 myMaxSize, int myKeep)
+    : QThread(Q_NULLPTR)
+    , pLogFile(pFile)
+    , sFileName(pFile->fileName())
+    , maxSize(myMaxSize)
+    , nKeep(myKeep)
+    , fileSize(pFile->size())
+    , bStop(0)
+    , nPosting(0)
+{
+}
+
+
+/*!
+ * \brief AsyncLogger::startLogging From now on logMessage() on pFile only queues the messages
+ * \param pFile The (already open) log file: it will be written by the writer thread only
+ * \param maxSize The file is rotated when it grows beyond that size
+ * \param nKeep How many rotated files (pFile.1 ... pFile.nKeep) to keep
+ * \return false if the file is not open or a logger was already started
+ */
+bool
+AsyncLogger::startLogging(QFile *pFile, qint64 maxSize, int nKeep) {
+    if(!pFile || !pFile->isOpen() || pInstance.loadAcquire())
+        return false;
+    AsyncLogger *pLogger = new AsyncLogger(pFile, maxSize, nKeep);
+    pInstance.storeRelease(pLogger);
+    pLogger->start(QThread::LowPriority);
+    return true;
+}
+
+
+/*!
+ * \brief AsyncLogger::stopLogging Writes the pending messages and stops the writer thread.
+ *
+ * The log file is left open: later messages are written synchronously.
+ * The posts already past the bStop check are waited for, so that
+ * the last drain finds their messages.
+ * The logger is not deleted since other threads could still be posting.
+ */
+void
+AsyncLogger::stopLogging() {
+    AsyncLogger *pLogger = pInstance.loadAcquire();
+    if(!pLogger || pLogger->bStop.fetchAndStoreOrdered(1))
+        return;
+    pLogger->wakeUp.wakeOne();
+    while(pLogger->nPosting.fetchAndAddOrdered(0) != 0)
+        QThread::yieldCurrentThread();
+    pLogger->wait();
+    pLogger->drain();
+    pLogger->pLogFile->flush();
+}
+
+
+/*!
+ * \brief AsyncLogger::post Queues a message for the writer thread
+ * \param pFile The file the message is for
+ * \param sFunctionName The Function which requested to write the message
+ * \param sMessage The informative message
+ * \return false if the message has to be written by the caller
+ *
+ * Lock free: the message is copied in the queue of the calling thread.
+ * When the queue is full the message is dropped and counted.
+ * Once stopLogging() has begun the caller writes the message itself.
+ */
+bool
+AsyncLogger::post(QFile *pFile, const QString& sFunctionName, const QString& sMessage) {
+    AsyncLogger *pLogger = pInstance.loadAcquire();
+    if(!pLogger || !pFile || pLogger->pLogFile != pFile)
+        return false;
+    // Ordered on both sides: either stopLogging() sees this post
+    // in flight or we see bStop set
+    pLogger->nPosting.fetchAndAddOrdered(1);
+    if(pLogger->bStop.fetchAndAddOrdered(0)) {
+        pLogger->nPosting.fetchAndAddOrdered(-1);
+        return false;
+    }
+    if(!threadQueue.pQueue) {
+        LogQueue *pQueue = new LogQueue();
+        QMutexLocker locker(&registryMutex);
+        registry.append(pQueue);
+        threadQueue.pQueue = pQueue;
+    }
+    quint32 nQueued = threadQueue.pQueue->push(QDateTime::currentMSecsSinceEpoch(),
+                                               sFunctionName,
+                                               sMessage);
+    // Don't wait for the next drain when the queue is filling up
+    if(nQueued == 0 || nQueued > LogQueue::capacity/2)
+        pLogger->wakeUp.wakeOne();
+    pLogger->nPosting.fetchAndAddOrdered(-1);
+    return true;
+}
+
+
+/*!
+ * \brief AsyncLogger::rotate Shifts the old log files: name -> name.1 -> ... -> name.nKeep
+ * \param sFileName The log file name
+ * \param nKeep The number of old files to keep (the oldest one is removed)
+ */
+void
+AsyncLogger::rotate(const QString& sFileName, int nKeep) {
+    QDir renamed;
+    renamed.remove(QString("%1.%2").arg(sFileName).arg(nKeep));
+    for(int i=nKeep-1; i>0; i--) {
+        renamed.rename(QString("%1.%2").arg(sFileName).arg(i),
+                       QString("%1.%2").arg(sFileName).arg(i+1));
+    }
+    if(nKeep > 0)
+        renamed.rename(sFileName, sFileName+QString(".1"));
+    else
+        renamed.remove(sFileName);
+}
+
+
+/*!
+ * \brief AsyncLogger::run The writer loop.
+ *
+ * Every DRAIN_INTERVAL ms (or earlier, when a queue is filling up)
+ * all the queues are emptied with a single write; the file is
+ * flushed at most once every FLUSH_INTERVAL ms.
+ */
+void
+AsyncLogger::run() {
+    QElapsedTimer flushTime;
+    flushTime.start();
+    bool bDirty = false;
+    while(!bStop.loadAcquire()) {
+        waitMutex.lock();
+        wakeUp.wait(&waitMutex, DRAIN_INTERVAL);
+        waitMutex.unlock();
+        if(drain())
+            bDirty = true;
+        if(bDirty && flushTime.elapsed() > FLUSH_INTERVAL) {
+            pLogFile->flush();
+            bDirty = false;
+            flushTime.restart();
+        }
+    }
+}
+
+
+/*!
+ * \brief AsyncLogger::drain Writes all the queued messages in time order
+ * \return true if something has been written
+ */
+bool
+AsyncLogger::drain() {
+    QVector<logEntry> batch;
+    quint32 nDropped = 0;
+    registryMutex.lock();
+    for(int i=registry.count()-1; i>=0; i--) {
+        LogQueue *pQueue = registry.at(i);
+        // Read it before emptying: the last messages precede the closing
+        bool bClosed = pQueue->bClosed.loadAcquire();
+        logEntry entry;
+        while(pQueue->pop(entry))
+            batch.append(entry);
+        nDropped += pQueue->dropped.fetchAndStoreRelaxed(0);
+        if(bClosed) {
+            registry.removeAt(i);
+            delete pQueue;
+        }
+    }
+    registryMutex.unlock();
+    if(batch.isEmpty() && (nDropped == 0))
+        return false;
+
+    std::stable_sort(batch.begin(), batch.end(), earlier);
+    QByteArray buffer;
+    for(int i=0; i<batch.count(); i++) {
+        const logEntry& entry = batch.at(i);
+        QString sDebugMessage = QDateTime::fromMSecsSinceEpoch(entry.msecs).toString() +
+                                QString(" - ") +
+                                entry.sFunctionName +
+                                QString(" - ") +
+                                entry.sMessage;
+        buffer += sDebugMessage.toUtf8();
+        buffer += '\n';
+    }
+    if(nDropped > 0) {
+        buffer += QString("%1 - %2 - %3 messages dropped (queue full)\n")
+                  .arg(QDateTime::currentDateTime().toString())
+                  .arg(Q_FUNC_INFO)
+                  .arg(nDropped)
+                  .toUtf8();
+    }
+    qint64 written = pLogFile->write(buffer);
+    if(written > 0)
+        fileSize += written;
+    if(fileSize > maxSize)
+        rotateOpenFile();
+    return true;
+}
+
+
+/*!
+ * \brief AsyncLogger::rotateOpenFile Starts a new log file when the current one is too big
+ */
+void
+AsyncLogger::rotateOpenFile() {
+    pLogFile->close();
+    rotate(sFileName, nKeep);
+    if(!pLogFile->open(QIODevice::WriteOnly)) {
+        qWarning() << Q_FUNC_INFO
+                   << QString("Unable to reopen %1: %2")
+                      .arg(sFileName)
+                      .arg(pLogFile->errorString());
+    }
+    fileSize = 0;
+}
@@ -0,0 +1,68 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef ASYNCLOGGER_H
+#define ASYNCLOGGER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInteger>
+#include <QAtomicPointer>
+#include <QString>
+
+
+QT_FORWARD_DECLARE_CLASS(QFile)
+
+
+class AsyncLogger : public QThread
+{
+    Q_OBJECT
+
+public:
+    static const qint64 maxFileSize = 4*1024*1024;
+    static const int    keptFiles   = 3;
+
+public:
+    static bool startLogging(QFile *pFile, qint64 maxSize=maxFileSize, int nKeep=keptFiles);
+    static void stopLogging();
+    static bool post(QFile *pFile, const QString& sFunctionName, const QString& sMessage);
+    static void rotate(const QString& sFileName, int nKeep);
+
+protected:
+    void run();
+
+private:
+    AsyncLogger(QFile *pFile, qint64 maxSize, int nKeep);
+    bool drain();
+    void rotateOpenFile();
+
+private:
+    static QAtomicPointer<AsyncLogger> pInstance;
+    QFile                             *pLogFile;
+    QString                            sFileName;
+    qint64                             maxSize;
+    int                                nKeep;
+    QMutex                             waitMutex;
+    QWaitCondition                     wakeUp;
+    qint64                             fileSize;
+    QAtomicInteger<int>                bStop;
+    QAtomicInteger<int>                nPosting;
+};
+
+#endif // ASYNCLOGGER_H
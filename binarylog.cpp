@@ -0,0 +1,347 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QFile>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QHash>
+#include <QStringList>
+#include <atomic>
+#include <cstring>
+#if defined(Q_OS_UNIX)
+    #include <signal.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+#include "binarylog.h"
+
+
+Q_STATIC_ASSERT(sizeof(BinaryLog::fileHeader) == BinaryLog::headerSize);
+Q_STATIC_ASSERT(sizeof(BinaryLog::logRecord) == 32);
+
+
+// Same order of the event enum
+static const BinaryLog::eventInfo events[BinaryLog::nEvents] = {
+    {"ScorePanel::onMessageArrived",          "Received %1 chars",          {BinaryLog::Int,    BinaryLog::NoArg}},
+    {"PanelSession::onPong",                  "Server RTT: %1ms",           {BinaryLog::Int,    BinaryLog::NoArg}},
+    {"PanelSession::onTimeToResume",          "Trying to resume (%1ms)",    {BinaryLog::Int,    BinaryLog::NoArg}},
+    {"FileUpdater",                           "%1 Asked a file from byte %2",{BinaryLog::String, BinaryLog::Int}},
+    {"FileUpdater::onProcessBinaryFrame",     "%1 Received %2 bytes",       {BinaryLog::String, BinaryLog::Int}},
+    {"FileUpdater::onProcessBinaryFrame",     "%1 No more file to transfer",{BinaryLog::String, BinaryLog::NoArg}},
+    {"SlideWindow::onTransitionTimeElapsed",  "Frame %1: %2 ms",            {BinaryLog::Int,    BinaryLog::Int}},
+    {"ProcessSupervisor::onStarted",          "%1 started",                 {BinaryLog::String, BinaryLog::NoArg}},
+    {"ProcessSupervisor::onFinished",         "%1 exited with code %2",     {BinaryLog::String, BinaryLog::Int}},
+    {"ProcessSupervisor::setState",           "%1 state %2 (0=Idle 1=Starting 2=Running 3=Quitting 4=Terminating 5=Killing)",
+                                                                            {BinaryLog::String, BinaryLog::Int}},
+    {"ScorePanel::onSpotUpdaterThreadDone",   "Spot Updater closed (code %1)", {BinaryLog::Int, BinaryLog::NoArg}},
+    {"ScorePanel::onSlideUpdaterThreadDone",  "Slide Updater closed (code %1)",{BinaryLog::Int, BinaryLog::NoArg}},
+    {"PanelSession::suspend",                 "Session suspended",          {BinaryLog::NoArg,  BinaryLog::NoArg}},
+    {"ScorePanel::closeSession",              "Session closed",             {BinaryLog::NoArg,  BinaryLog::NoArg}},
+};
+
+QAtomicPointer<BinaryLog::logRecord> BinaryLog::pRecords(Q_NULLPTR);
+
+static QFile                  *pLogFile = Q_NULLPTR;
+static uchar                  *pRegion  = Q_NULLPTR;// Header, strings and records
+static qint64                  regionSize = 0;
+static uchar                  *pTable   = Q_NULLPTR;
+static quint32                 tableUsed = 0;
+static quint32                 ringCapacity = 0;
+static QAtomicInteger<quint32> nextSeq(0);
+static QElapsedTimer           logClock;
+static QMutex                  internMutex;
+static QStringList             internedStrings;
+static QHash<QString, quint16> internedIds;
+static QString                 sDumpFileName;
+#if defined(Q_OS_UNIX)
+static char                    crashFileName[1024];
+#endif
+
+
+/*!
+ * \brief storeString Appends a string to the table of the mapped file
+ *
+ * Every string is stored as its length (quint16) followed by its UTF-8 bytes;
+ * a zero length marks the end of the table.
+ */
+static void
+storeString(const QString& sText) {
+    if(!pTable)
+        return;
+    QByteArray baText = sText.toUtf8();
+    quint16 len = quint16(qMin(int(baText.size()), 255));
+    if(tableUsed+sizeof(len)+len+sizeof(len) > BinaryLog::tableSize)
+        return;// The decoder will show the id only
+    memcpy(pTable+tableUsed, &len, sizeof(len));
+    memcpy(pTable+tableUsed+sizeof(len), baText.constData(), len);
+    tableUsed += quint32(sizeof(len)+len);
+}
+
+
+/*!
+ * \brief BinaryLog::open Prepares the ring of records
+ * \param sFileName The file to (re)create and map in memory
+ * \param capacity The number of records kept: the oldest ones are overwritten
+ * \return true if the records can be written
+ *
+ * The kernel owns the mapped pages: what has been recorded
+ * survives a crash of the Panel.
+ */
+bool
+BinaryLog::open(const QString& sFileName, int capacity) {
+    if(pRecords.loadAcquire() || capacity <= 0)
+        return false;
+    pLogFile = new QFile(sFileName);
+    qint64 fileSize = qint64(headerSize) + tableSize + qint64(capacity)*sizeof(logRecord);
+    if(!pLogFile->open(QIODevice::ReadWrite | QIODevice::Truncate) ||
+       !pLogFile->resize(fileSize))
+    {
+        delete pLogFile;
+        pLogFile = Q_NULLPTR;
+        return false;
+    }
+    uchar *pMap = pLogFile->map(0, fileSize);
+    if(!pMap) {
+        pLogFile->close();
+        delete pLogFile;
+        pLogFile = Q_NULLPTR;
+        return false;
+    }
+    regionSize = fileSize;
+    prepare(pMap, capacity);
+    return true;
+}
+
+
+/*!
+ * \brief BinaryLog::openMemory Prepares the ring of records in memory (the flight recorder)
+ * \param capacity The number of records kept: the oldest ones are overwritten
+ * \return true if the records can be written
+ *
+ * The memory has the same layout of the file written by open():
+ * dump() simply writes it to disk.
+ */
+bool
+BinaryLog::openMemory(int capacity) {
+    if(pRecords.loadAcquire() || capacity <= 0)
+        return false;
+    regionSize = qint64(headerSize) + tableSize + qint64(capacity)*sizeof(logRecord);
+    prepare(new uchar[size_t(regionSize)](), capacity);
+    return true;
+}
+
+
+/*!
+ * \brief BinaryLog::isOpen
+ * \return true if the records are being written
+ */
+bool
+BinaryLog::isOpen() {
+    return pRecords.loadAcquire() != Q_NULLPTR;
+}
+
+
+/*!
+ * \brief BinaryLog::prepare Writes the header and the strings and starts recording
+ * \param pBase The (zero filled) beginning of the file or of the memory
+ * \param capacity The number of records
+ */
+void
+BinaryLog::prepare(uchar *pBase, int capacity) {
+    logClock.start();
+    fileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic      = magic;
+    header.version    = version;
+    header.recordSize = sizeof(logRecord);
+    header.capacity   = quint32(capacity);
+    header.startMs    = QDateTime::currentMSecsSinceEpoch();
+    header.tableSize  = tableSize;
+    memcpy(pBase, &header, sizeof(header));
+    ringCapacity = quint32(capacity);
+    pRegion = pBase;
+    {
+        QMutexLocker locker(&internMutex);
+        pTable = pBase + headerSize;
+        for(int i=0; i<internedStrings.count(); i++)
+            storeString(internedStrings.at(i));
+    }
+    pRecords.storeRelease(reinterpret_cast<logRecord*>(pBase + headerSize + tableSize));
+}
+
+
+/*!
+ * \brief BinaryLog::close Stops recording.
+ *
+ * The file stays mapped (or the memory allocated) until the
+ * Panel exits since another thread could still be writing a record.
+ */
+void
+BinaryLog::close() {
+    pRecords.storeRelease(Q_NULLPTR);
+}
+
+
+#if defined(Q_OS_UNIX)
+/*!
+ * \brief onCrash Writes the records, as they are, before the Panel dies
+ *
+ * Only async-signal-safe calls in here: the file name and
+ * the memory to write have been prepared in advance.
+ */
+static void
+onCrash(int signalNumber) {
+    if(pRegion && crashFileName[0]) {
+        int fd = ::open(crashFileName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(fd >= 0) {
+            const uchar *pData = pRegion;
+            qint64 left = regionSize;
+            while(left > 0) {
+                ssize_t written = ::write(fd, pData, size_t(left));
+                if(written <= 0)
+                    break;
+                pData += written;
+                left  -= written;
+            }
+            ::close(fd);
+        }
+    }
+    // Let the default action (core dump) take place
+    signal(signalNumber, SIG_DFL);
+    raise(signalNumber);
+}
+#endif
+
+
+/*!
+ * \brief BinaryLog::installCrashHandler Where to dump the records (see dump()) also on a crash
+ * \param sFileName The dump file
+ *
+ * On Unix the records are written when the Panel receives
+ * SIGSEGV, SIGBUS, SIGILL, SIGFPE or SIGABRT.
+ */
+void
+BinaryLog::installCrashHandler(const QString& sFileName) {
+    sDumpFileName = sFileName;
+#if defined(Q_OS_UNIX)
+    QByteArray baFileName = QFile::encodeName(sFileName);
+    if(baFileName.size() >= int(sizeof(crashFileName)))
+        return;
+    memcpy(crashFileName, baFileName.constData(), size_t(baFileName.size()));
+    crashFileName[baFileName.size()] = 0;
+    const int crashSignals[] = {SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT};
+    for(size_t i=0; i<sizeof(crashSignals)/sizeof(crashSignals[0]); i++)
+        signal(crashSignals[i], onCrash);
+#endif
+}
+
+
+/*!
+ * \brief BinaryLog::dump Writes the records to the file given to installCrashHandler()
+ * \return true if the file has been written
+ *
+ * The records keep being written meanwhile: at most the ones
+ * still in progress are lost (and ignored by the decoder).
+ */
+bool
+BinaryLog::dump() {
+    if(!pRegion || sDumpFileName.isEmpty())
+        return false;
+    QSaveFile saveFile(sDumpFileName);
+    if(!saveFile.open(QIODevice::WriteOnly))
+        return false;
+    if(saveFile.write(reinterpret_cast<const char*>(pRegion), regionSize) != regionSize) {
+        saveFile.cancelWriting();
+        return false;
+    }
+    return saveFile.commit();
+}
+
+
+/*!
+ * \brief BinaryLog::dumpFile
+ * \return The file written by dump()
+ */
+QString
+BinaryLog::dumpFile() {
+    return sDumpFileName;
+}
+
+
+/*!
+ * \brief BinaryLog::intern The id of a string to be used as a String argument
+ * \param sText Usually a name (of a FileUpdater, of a process...)
+ * \return The id to pass to record()
+ *
+ * Not meant for the hot paths: get the id once and keep it.
+ */
+quint16
+BinaryLog::intern(const QString& sText) {
+    QMutexLocker locker(&internMutex);
+    QHash<QString, quint16>::const_iterator it = internedIds.constFind(sText);
+    if(it != internedIds.constEnd())
+        return it.value();
+    quint16 id = quint16(internedStrings.count());
+    internedStrings.append(sText);
+    internedIds.insert(sText, id);
+    storeString(sText);
+    return id;
+}
+
+
+/*!
+ * \brief BinaryLog::info
+ * \param e The event id (as read from a file)
+ * \return How to decode the event
+ */
+const BinaryLog::eventInfo&
+BinaryLog::info(int e) {
+    static const eventInfo unknown = {"?", "Unknown event %1 %2", {Int, Int}};
+    if(e < 0 || e >= nEvents)
+        return unknown;
+    return events[e];
+}
+
+
+/*!
+ * \brief BinaryLog::write Fills the next slot of the ring
+ *
+ * The sequence number is written last: a reader finding
+ * a zero seq knows the slot is not (yet) valid.
+ */
+void
+BinaryLog::write(event e, qint64 arg0, qint64 arg1) {
+    logRecord *pRing = pRecords.loadAcquire();
+    if(!pRing)
+        return;
+    quint32 seq = nextSeq.fetchAndAddRelaxed(1) + 1;
+    logRecord& slot = pRing[(seq-1) % ringCapacity];
+    slot.seq     = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.event   = quint16(e);
+    slot.spare   = 0;
+    slot.timeUs  = logClock.nsecsElapsed()/1000;
+    slot.args[0] = arg0;
+    slot.args[1] = arg1;
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.seq     = seq;
+}
@@ -0,0 +1,134 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef BINARYLOG_H
+#define BINARYLOG_H
+
+#include <QtGlobal>
+#include <QString>
+#include <QAtomicPointer>
+
+
+/*!
+ * \brief The BinaryLog class Compact, fixed size, log records for the hot paths.
+ *
+ * The records are written, without any formatting, in a ring of a
+ * memory mapped file (LOG_BINARY) or, otherwise, of a memory buffer:
+ * the flight recorder, that is written to disk only on a crash,
+ * on request or when the Panel is closed (see dump()).
+ * The text is rebuilt offline by tools/logdecode
+ * from the table of the events (see BinaryLog::info()).
+ */
+class BinaryLog
+{
+public:
+    /*!
+     * \brief The event enum The recorded events: append only (ids are stored in the files)
+     */
+    enum event {
+        MessageReceived, /*!< A text message from the Server (length) */
+        PingRtt,         /*!< The Server answered our ping (ms) */
+        ResumeAttempt,   /*!< Trying to resume a session (ms since suspended) */
+        FileRequested,   /*!< A FileUpdater asked for a file (updater, offset) */
+        FileChunk,       /*!< A FileUpdater received a chunk (updater, total bytes) */
+        TransferDone,    /*!< A FileUpdater has nothing more to transfer (updater) */
+        SlideFrame,      /*!< A slide transition frame (frame, ms) */
+        ProcessStarted,  /*!< A supervised process is running (name) */
+        ProcessExited,   /*!< A supervised process exited (name, exit code) */
+        ProcessState,    /*!< A supervised process changed state (name, state) */
+        SpotUpdaterDone, /*!< The Spot FileUpdater thread ended (return code) */
+        SlideUpdaterDone,/*!< The Slide FileUpdater thread ended (return code) */
+        SessionSuspended,/*!< The connection with the Server has been lost */
+        SessionClosed,   /*!< The session has been abandoned */
+        nEvents
+    };
+    /*!
+     * \brief The argType enum How the decoder shows an argument
+     */
+    enum argType {
+        NoArg,
+        Int,   /*!< A number */
+        String /*!< The id of a string returned by intern() */
+    };
+    /*!
+     * \brief The eventInfo struct How an event is decoded
+     */
+    struct eventInfo {
+        const char *sSource;/*!< Who records it */
+        const char *sFormat;/*!< The message, with %1 and %2 for the arguments */
+        argType     types[2];
+    };
+    /*!
+     * \brief The logRecord struct A record as stored in the ring
+     */
+    struct logRecord {
+        quint32 seq;   /*!< 1, 2, 3... (0 = empty or partially written slot) */
+        quint16 event;
+        quint16 spare;
+        qint64  timeUs;/*!< Since the startMs of the file header */
+        qint64  args[2];
+    };
+    /*!
+     * \brief The fileHeader struct The beginning of the file
+     */
+    struct fileHeader {
+        quint32 magic;
+        quint32 version;
+        quint32 recordSize;
+        quint32 capacity;  /*!< Number of records in the ring */
+        qint64  startMs;   /*!< Epoch time (ms) of timeUs == 0 */
+        quint32 tableSize; /*!< Bytes reserved to the interned strings */
+        quint32 spare[9];
+    };
+
+public:
+    static const quint32 magic          = 0x5350424C;// "SPBL"
+    static const quint32 version        = 1;
+    static const quint32 headerSize     = 64;
+    static const quint32 tableSize      = 4096;
+    static const int     recordCapacity = 65536;
+    static const int     flightCapacity = 16384;
+
+public:
+    static bool open(const QString& sFileName, int capacity=recordCapacity);
+    static bool openMemory(int capacity=flightCapacity);
+    static bool isOpen();
+    static void close();
+    static void installCrashHandler(const QString& sFileName);
+    static bool dump();
+    static QString dumpFile();
+    static quint16 intern(const QString& sText);
+    static const eventInfo& info(int e);
+
+    /*!
+     * \brief record Lock free: safe (and cheap) from any thread. Nothing is done if not open
+     */
+    static inline void record(event e, qint64 arg0 = 0, qint64 arg1 = 0) {
+        if(pRecords.loadRelaxed())
+            write(e, arg0, arg1);
+    }
+
+private:
+    static void prepare(uchar *pBase, int capacity);
+    static void write(event e, qint64 arg0, qint64 arg1);
+
+private:
+    static QAtomicPointer<logRecord> pRecords;
+};
+
+#endif // BINARYLOG_H
@@ -22,6 +22,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QTimer>
 
 #include "utility.h"
+#include "mediaprobe.h"
+#include "binarylog.h"
 
 #define CHUNK_SIZE 512*1024
 
@@ -44,12 +46,63 @@ FileUpdater::FileUpdater(QString sName, QUrl myServerUrl, QFile *myLogFile, QObj
     , serverUrl(myServerUrl)
 {
     sMyName = sName;
+    nameId = BinaryLog::intern(sMyName);
     pUpdateSocket = Q_NULLPTR;
+    pProbe = Q_NULLPTR;
+    bMetrics = false;
+    bytesCounter = Metrics::nCounters;
+    timeCounter = Metrics::nCounters;
     destinationDir = QString(".");
     bytesReceived = 0;
 }
 
 
+/*!
+ * \brief FileUpdater::~FileUpdater
+ */
+FileUpdater::~FileUpdater() {
+    if(pProbe) {
+        pProbe->save();
+        delete pProbe;
+    }
+}
+
+
+/*!
+ * \brief FileUpdater::setMetrics Select the Metrics counters of this updater
+ * \param myBytesCounter Where to count the received bytes
+ * \param myTimeCounter Where to count the time spent receiving them (ms)
+ */
+void
+FileUpdater::setMetrics(Metrics::counter myBytesCounter, Metrics::counter myTimeCounter) {
+    bytesCounter = myBytesCounter;
+    timeCounter  = myTimeCounter;
+    bMetrics = true;
+}
+
+
+/*!
+ * \brief FileUpdater::countFrame Update the Metrics with a received frame
+ * \param bytes
+ *
+ * Only the gaps shorter than a second between frames are counted
+ * as transfer time, so the idle periods don't lower the throughput.
+ */
+void
+FileUpdater::countFrame(qint64 bytes) {
+    if(!bMetrics)
+        return;
+    Metrics::add(bytesCounter, bytes);
+    if(frameClock.isValid()) {
+        qint64 gap = frameClock.restart();
+        if(gap < 1000)
+            Metrics::add(timeCounter, gap);
+    }
+    else
+        frameClock.start();
+}
+
+
 /*!
  * \brief FileUpdater::setDestination Set the file destination folder.
  * \param myDstinationDir The destination folder
@@ -76,6 +129,11 @@ FileUpdater::setDestination(QString myDstinationDir, QString sExtensions) {
             return false;
         }
     }
+    if(pProbe) {
+        pProbe->save();
+        delete pProbe;
+    }
+    pProbe = new MediaProbe(destinationDir, logFile);
     return true;
 }
 
@@ -245,6 +303,7 @@ FileUpdater::onProcessBinaryFrame(QByteArray baMessage, bool isLastFrame) {
             len = baMessage.size()-1024;
             qint64 written = file.write(baMessage.mid(1024));
             bytesReceived += written;
+            countFrame(written);
             if(len != written) {
                 logMessage(logFile,
                            Q_FUNC_INFO,
@@ -270,6 +329,7 @@ FileUpdater::onProcessBinaryFrame(QByteArray baMessage, bool isLastFrame) {
         int len = baMessage.size();
         qint64 written = file.write(baMessage);
         bytesReceived += written;
+        countFrame(written);
         if(len != written) {
             logMessage(logFile,
                        Q_FUNC_INFO,
@@ -282,7 +342,8 @@ FileUpdater::onProcessBinaryFrame(QByteArray baMessage, bool isLastFrame) {
             return;
         }
     }
-#ifdef LOG_VERBOSE
+    BinaryLog::record(BinaryLog::FileChunk, nameId, bytesReceived);
+#if defined(LOG_VERBOSE) && !defined(LOG_BINARY)
     logMessage(logFile,
                Q_FUNC_INFO,
                sMyName +
@@ -294,6 +355,7 @@ FileUpdater::onProcessBinaryFrame(QByteArray baMessage, bool isLastFrame) {
                        .arg(queryList.last().fileName)
                        .arg(bytesReceived)
                        .arg(CHUNK_SIZE);
+            BinaryLog::record(BinaryLog::FileRequested, nameId, bytesReceived);
             qint64 written = pUpdateSocket->sendTextMessage(sMessage);
             if(written != sMessage.length()) {
                 logMessage(logFile,
@@ -304,7 +366,7 @@ FileUpdater::onProcessBinaryFrame(QByteArray baMessage, bool isLastFrame) {
                 thread()->exit(returnCode);
                 return;
             }
-#ifdef LOG_VERBOSE
+#if defined(LOG_VERBOSE) && !defined(LOG_BINARY)
             else {
                 logMessage(logFile,
                            Q_FUNC_INFO,
@@ -320,6 +382,7 @@ FileUpdater::onProcessBinaryFrame(QByteArray baMessage, bool isLastFrame) {
             QDir renamed;// Remove the .temp exstension
             renamed.rename(destinationDir + sCurrentFileName + QString(".temp"),
                            destinationDir + sCurrentFileName);
+            probeReceivedFile();
             // Go to transfer the next file (if any)
             queryList.removeLast();
             if(!queryList.isEmpty()) {
@@ -344,6 +407,7 @@ FileUpdater::onProcessBinaryFrame(QByteArray baMessage, bool isLastFrame) {
                                    .arg(queryList.last().fileName)
                                    .arg(bytesReceived)
                                    .arg(CHUNK_SIZE);
+                BinaryLog::record(BinaryLog::FileRequested, nameId, bytesReceived);
                 qint64 written = pUpdateSocket->sendTextMessage(sMessage);
                 if(written != sMessage.length()) {
                     logMessage(logFile,
@@ -354,7 +418,7 @@ FileUpdater::onProcessBinaryFrame(QByteArray baMessage, bool isLastFrame) {
                     thread()->exit(returnCode);
                     return;
                 }
-#ifdef LOG_VERBOSE
+#if defined(LOG_VERBOSE) && !defined(LOG_BINARY)
                 else {
                     logMessage(logFile,
                                Q_FUNC_INFO,
@@ -366,7 +430,8 @@ FileUpdater::onProcessBinaryFrame(QByteArray baMessage, bool isLastFrame) {
 #endif
             }
             else {
-#ifdef LOG_VERBOSE
+                BinaryLog::record(BinaryLog::TransferDone, nameId);
+#if defined(LOG_VERBOSE) && !defined(LOG_BINARY)
                 logMessage(logFile,
                            Q_FUNC_INFO,
                            sMyName +
@@ -381,6 +446,21 @@ FileUpdater::onProcessBinaryFrame(QByteArray baMessage, bool isLastFrame) {
 }
 
 
+/*!
+ * \brief FileUpdater::probeReceivedFile Validate the file just received
+ *
+ * The results go to the probe cache so the players can
+ * skip the bad files without probing them again.
+ */
+void
+FileUpdater::probeReceivedFile() {
+    if(!pProbe)
+        return;
+    pProbe->info(queryList.last().fileName);
+    pProbe->save();
+}
+
+
 /*!
  * \brief FileUpdater::handleWriteFileError Write file error handler
  */
@@ -560,6 +640,7 @@ FileUpdater::askFirstFile() {
                            .arg(sCurrentFileName)
                            .arg(bytesReceived)
                            .arg(CHUNK_SIZE);
+    BinaryLog::record(BinaryLog::FileRequested, nameId, bytesReceived);
     qint64 written = pUpdateSocket->sendTextMessage(sMessage);
     if(written != sMessage.length()) {
         logMessage(logFile,
@@ -570,7 +651,7 @@ FileUpdater::askFirstFile() {
         thread()->exit(returnCode);
         return;
     }
-#ifdef LOG_VERBOSE
+#if defined(LOG_VERBOSE) && !defined(LOG_BINARY)
     else {
         logMessage(logFile,
                    Q_FUNC_INFO,
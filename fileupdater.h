@@ -22,12 +22,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QObject>
 #include <QUrl>
 #include <QWebSocket>
-#include <QWidget>
 #include <QFile>
 #include <QFileInfoList>
+#include <QElapsedTimer>
+
+#include "metrics.h"
 
 
 QT_FORWARD_DECLARE_CLASS(QWebSocket)
+QT_FORWARD_DECLARE_CLASS(MediaProbe)
 
 
 /*!
@@ -44,7 +47,9 @@ class FileUpdater : public QObject
     Q_OBJECT
 public:
     explicit FileUpdater(QString sName, QUrl myServerUrl, QFile *myLogFile = Q_NULLPTR, QObject *parent = Q_NULLPTR);
+    ~FileUpdater();
     bool setDestination(QString myDstinationDir, QString sExtensions);
+    void setMetrics(Metrics::counter myBytesCounter, Metrics::counter myTimeCounter);
     void askFileList();
 
     static const int TRANSFER_DONE       =  0;
@@ -68,6 +73,8 @@ private:
     bool isConnectedToNetwork();
     void updateFiles();
     void askFirstFile();
+    void probeReceivedFile();
+    void countFrame(qint64 bytes);
 
 public:
     int returnCode;
@@ -76,12 +83,19 @@ private:
     QFile       *logFile;
     QWebSocket  *pUpdateSocket;
     QString      sMyName;
+    quint16      nameId;
     QFile        file;
     QUrl         serverUrl;
     QString      destinationDir;
     QString      sFileExtensions;
     qint64       bytesReceived;
     QString      sCurrentFileName;
+    MediaProbe  *pProbe;
+    // Metrics
+    bool             bMetrics;
+    Metrics::counter bytesCounter;
+    Metrics::counter timeCounter;
+    QElapsedTimer    frameClock;
 
     QList<files> queryList;
     QList<files> remoteFileList;
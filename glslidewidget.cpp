@@ -0,0 +1,430 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QFile>
+#include <QOpenGLContext>
+#include <QOpenGLTexture>
+#include <QVector4D>
+#include <QtMath>
+
+#include "glslidewidget.h"
+#include "utility.h"
+
+
+#define FOLD_MESH_STEPS 32 // Subdivisions of the folding page (per side)
+
+
+/*!
+ * \brief GLSlideWidget::GLSlideWidget Renders the slide transitions with the shaders
+ * \param myLogFile The File for message logging (if any)
+ * \param parent The SlideWindow that owns the slides
+ *
+ * Each slide is uploaded as a texture only once: the "next" texture
+ * becomes the "present" one when a transition ends.
+ * The fade and the page fold are then computed entirely by the GPU.
+ * It runs also under the Mesa software rasterizer (llvmpipe) so it
+ * can be tried on a machine without a GPU with:
+ *
+ * <pre>LIBGL_ALWAYS_SOFTWARE=1 ./panelChooser</pre>
+ */
+GLSlideWidget::GLSlideWidget(QFile *myLogFile, QWidget *parent)
+    : QOpenGLWidget(parent)
+    , logFile(myLogFile)
+    , pPresentTexture(Q_NULLPTR)
+    , pNextTexture(Q_NULLPTR)
+    , presentKey(0)
+    , nextKey(0)
+    , bTexturesPending(false)
+    , bInitialized(false)
+    , bUsable(true)
+    , transition(glTransition_Fade)
+    , progress(0.0)
+{
+}
+
+
+/*!
+ * \brief GLSlideWidget::~GLSlideWidget
+ */
+GLSlideWidget::~GLSlideWidget() {
+    if(bInitialized) {
+        makeCurrent();
+        releaseTextures();
+        doneCurrent();
+    }
+}
+
+
+/*!
+ * \brief GLSlideWidget::isUsable
+ * \return false if OpenGL or the shaders failed to initialize
+ */
+bool
+GLSlideWidget::isUsable() {
+    return bUsable;
+}
+
+
+/*!
+ * \brief GLSlideWidget::setSlides Set the two slides involved in the next transition
+ * \param newPresentImage The slide actually shown (already scaled to the widget size)
+ * \param newNextImage The slide that will be shown at the end of the transition
+ */
+void
+GLSlideWidget::setSlides(const QImage& newPresentImage, const QImage& newNextImage) {
+    presentImage     = newPresentImage;
+    nextImage        = newNextImage;
+    bTexturesPending = true;
+    progress         = 0.0;
+    if(bInitialized) {
+        makeCurrent();
+        uploadTextures();
+        doneCurrent();
+    }
+    update();
+}
+
+
+/*!
+ * \brief GLSlideWidget::setTransition
+ * \param newTransition One of the glTransition values
+ */
+void
+GLSlideWidget::setTransition(int newTransition) {
+    transition = newTransition;
+}
+
+
+/*!
+ * \brief GLSlideWidget::setProgress Set the transition state and schedule a repaint
+ * \param newProgress 0.0 shows the present slide, 1.0 the next one
+ */
+void
+GLSlideWidget::setProgress(double newProgress) {
+    progress = qBound(0.0, newProgress, 1.0);
+    update();
+}
+
+
+/*!
+ * \brief GLSlideWidget::shaderSource Read a shader from the resources
+ * \param sResource The resource name
+ * \return The shader source
+ *
+ * The shaders are written for OpenGL ES 2.0 (GLSL ES 1.00).
+ * On a desktop context (e.g. Mesa llvmpipe) the same code is
+ * accepted by GLSL 1.20.
+ */
+QByteArray
+GLSlideWidget::shaderSource(QString sResource) {
+    QFile shaderFile(sResource);
+    if(!shaderFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Unable to read %1").arg(sResource));
+        return QByteArray();
+    }
+    QByteArray source = shaderFile.readAll();
+    if(!context()->isOpenGLES())
+        source.replace("#version 100", "#version 120");
+    return source;
+}
+
+
+/*!
+ * \brief GLSlideWidget::buildProgram Compile and link a shader program
+ * \param pProgram The program to build
+ * \param sVertexShader The vertex shader resource
+ * \param sFragmentShader The fragment shader resource
+ * \return true on success
+ */
+bool
+GLSlideWidget::buildProgram(QOpenGLShaderProgram *pProgram,
+                            QString sVertexShader,
+                            QString sFragmentShader)
+{
+    if(!pProgram->addShaderFromSourceCode(QOpenGLShader::Vertex,
+                                          shaderSource(sVertexShader)))
+        return false;
+    if(!pProgram->addShaderFromSourceCode(QOpenGLShader::Fragment,
+                                          shaderSource(sFragmentShader)))
+        return false;
+    pProgram->bindAttributeLocation("p", 0);
+    pProgram->bindAttributeLocation("a_texcoord", 1);
+    return pProgram->link();
+}
+
+
+/*!
+ * \brief GLSlideWidget::buildMeshes Build the full screen quad and the (finer) folding page
+ */
+void
+GLSlideWidget::buildMeshes() {
+    quadVertices = QVector<GLfloat>()
+            << -1.0f << -1.0f << 0.0f << 1.0f
+            <<  1.0f << -1.0f << 0.0f << 1.0f
+            << -1.0f <<  1.0f << 0.0f << 1.0f
+            <<  1.0f <<  1.0f << 0.0f << 1.0f;
+    quadTexCoords = QVector<GLfloat>()
+            << 0.0f << 0.0f
+            << 1.0f << 0.0f
+            << 0.0f << 1.0f
+            << 1.0f << 1.0f;
+
+    // The page has to bend: it needs many more vertices than a quad
+    meshVertices.clear();
+    meshTexCoords.clear();
+    meshIndices.clear();
+    const int n = FOLD_MESH_STEPS;
+    for(int j=0; j<=n; j++) {
+        for(int i=0; i<=n; i++) {
+            GLfloat s = GLfloat(i)/GLfloat(n);
+            GLfloat t = GLfloat(j)/GLfloat(n);
+            meshVertices << 2.0f*s-1.0f << 2.0f*t-1.0f << 0.0f << 1.0f;
+            meshTexCoords << s << t;
+        }
+    }
+    for(int j=0; j<n; j++) {
+        for(int i=0; i<n; i++) {
+            GLushort i0 = GLushort(j*(n+1)+i);
+            GLushort i1 = GLushort(i0+1);
+            GLushort i2 = GLushort(i0+n+1);
+            GLushort i3 = GLushort(i2+1);
+            meshIndices << i0 << i1 << i2;
+            meshIndices << i1 << i3 << i2;
+        }
+    }
+}
+
+
+/*!
+ * \brief GLSlideWidget::initializeGL Compile the shaders: on failure signal the fallback
+ */
+void
+GLSlideWidget::initializeGL() {
+    initializeOpenGLFunctions();
+    if(!context()->isValid()) {
+        bUsable = false;
+        emit glUnavailable();
+        return;
+    }
+    if(!buildProgram(&fadeProgram,
+                     QString(":/vshaderFade.glsl"),
+                     QString(":/fshaderFade.glsl")) ||
+       !buildProgram(&foldProgram,
+                     QString(":/vshaderFold.glsl"),
+                     QString(":/fshaderFold.glsl")))
+    {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Unable to build the shaders: %1 %2")
+                   .arg(fadeProgram.log(), foldProgram.log()));
+        bUsable = false;
+        emit glUnavailable();
+        return;
+    }
+    buildMeshes();
+    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+    bInitialized = true;
+    uploadTextures();
+}
+
+
+/*!
+ * \brief GLSlideWidget::resizeGL
+ * \param w Unused
+ * \param h Unused
+ *
+ * The slides are already scaled to the widget size:
+ * the scene is always the (-1,-1) (1,1) square.
+ */
+void
+GLSlideWidget::resizeGL(int w, int h) {
+    Q_UNUSED(w)
+    Q_UNUSED(h)
+    projection.setToIdentity();
+    projection.ortho(-1.0f, 1.0f, -1.0f, 1.0f, -10.0f, 10.0f);
+}
+
+
+/*!
+ * \brief GLSlideWidget::uploadTextures Upload the slides not already on the GPU
+ */
+void
+GLSlideWidget::uploadTextures() {
+    if(!bTexturesPending)
+        return;
+    bTexturesPending = false;
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    if(presentImage.width() > maxTextureSize || presentImage.height() > maxTextureSize ||
+       nextImage.width()    > maxTextureSize || nextImage.height()    > maxTextureSize)
+    {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Slides larger than %1").arg(maxTextureSize));
+        bUsable = false;
+        emit glUnavailable();
+        return;
+    }
+    // The slide shown as "next" becomes the "present" one:
+    // reuse its texture instead of uploading it again
+    if(pNextTexture && presentImage.cacheKey() == nextKey) {
+        delete pPresentTexture;
+        pPresentTexture = pNextTexture;
+        presentKey      = nextKey;
+        pNextTexture    = Q_NULLPTR;
+        nextKey         = 0;
+    }
+    if(!pPresentTexture || presentKey != presentImage.cacheKey()) {
+        delete pPresentTexture;
+        pPresentTexture = new QOpenGLTexture(presentImage.mirrored(),
+                                             QOpenGLTexture::DontGenerateMipMaps);
+        pPresentTexture->setMinMagFilters(QOpenGLTexture::Linear, QOpenGLTexture::Linear);
+        pPresentTexture->setWrapMode(QOpenGLTexture::ClampToEdge);
+        presentKey = presentImage.cacheKey();
+    }
+    if(!pNextTexture || nextKey != nextImage.cacheKey()) {
+        delete pNextTexture;
+        pNextTexture = new QOpenGLTexture(nextImage.mirrored(),
+                                          QOpenGLTexture::DontGenerateMipMaps);
+        pNextTexture->setMinMagFilters(QOpenGLTexture::Linear, QOpenGLTexture::Linear);
+        pNextTexture->setWrapMode(QOpenGLTexture::ClampToEdge);
+        nextKey = nextImage.cacheKey();
+    }
+    // The pixels are on the GPU now: drop our references
+    presentImage = QImage();
+    nextImage    = QImage();
+}
+
+
+/*!
+ * \brief GLSlideWidget::releaseTextures (Needs a current context)
+ */
+void
+GLSlideWidget::releaseTextures() {
+    delete pPresentTexture;
+    pPresentTexture = Q_NULLPTR;
+    delete pNextTexture;
+    pNextTexture = Q_NULLPTR;
+    presentKey = nextKey = 0;
+}
+
+
+/*!
+ * \brief GLSlideWidget::drawFlat Draw the full screen quad blending two textures
+ * \param pTexture0 Weighted by alpha
+ * \param pTexture1 Weighted by 1-alpha
+ * \param alpha The blending factor
+ */
+void
+GLSlideWidget::drawFlat(QOpenGLTexture *pTexture0, QOpenGLTexture *pTexture1, float alpha) {
+    fadeProgram.bind();
+    pTexture0->bind(0);
+    pTexture1->bind(1);
+    fadeProgram.setUniformValue("mvp_matrix", projection);
+    fadeProgram.setUniformValue("texture0", 0);
+    fadeProgram.setUniformValue("texture1", 1);
+    fadeProgram.setUniformValue("alpha", alpha);
+    fadeProgram.enableAttributeArray(0);
+    fadeProgram.enableAttributeArray(1);
+    fadeProgram.setAttributeArray(0, quadVertices.constData(), 4);
+    fadeProgram.setAttributeArray(1, quadTexCoords.constData(), 2);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    fadeProgram.disableAttributeArray(1);
+    fadeProgram.disableAttributeArray(0);
+    fadeProgram.release();
+}
+
+
+/*!
+ * \brief GLSlideWidget::drawFold Draw the page being turned
+ * \param pTexture The page texture
+ *
+ * The cone parameters follow the three phases described by
+ * Hong et al. "Turning Pages of 3D Electronic Books".
+ */
+void
+GLSlideWidget::drawFold(QOpenGLTexture *pTexture) {
+    const double angle1 = qDegreesToRadians(90.0);
+    const double angle2 = qDegreesToRadians(8.0);
+    const double angle3 = qDegreesToRadians(6.0);
+    const double A1 = -15.0;
+    const double A2 = -2.5;
+    const double A3 = -3.5;
+    const double theta1 = 0.05;
+    const double theta2 = 0.5;
+    const double theta3 = 10.0;
+    const double theta4 = 2.0;
+    double theta, ay, dt, f1, f2;
+    if(progress <= 0.15) {
+        dt = progress/0.15;
+        f1 = qSin(M_PI*qPow(dt, theta1)/2.0);
+        f2 = qSin(M_PI*qPow(dt, theta2)/2.0);
+        theta = angle1 + (angle2-angle1)*f1;
+        ay    = A1     + (A2-A1)*f2;
+    }
+    else if(progress <= 0.4) {
+        dt = (progress-0.15)/0.25;
+        theta = angle2 + (angle3-angle2)*dt;
+        ay    = A2     + (A3-A2)*dt;
+    }
+    else {
+        dt = (progress-0.4)/0.6;
+        f1 = qSin(M_PI*qPow(dt, theta3)/2.0);
+        f2 = qSin(M_PI*qPow(dt, theta4)/2.0);
+        theta = angle3 + (angle1-angle3)*f1;
+        ay    = A3     + (A1-A3)*f2;
+    }
+
+    foldProgram.bind();
+    pTexture->bind(0);
+    foldProgram.setUniformValue("mvp_matrix", projection);
+    foldProgram.setUniformValue("texture0", 0);
+    foldProgram.setUniformValue("a", QVector4D(0.0f, float(ay), 0.0f, 0.0f));
+    foldProgram.setUniformValue("theta", float(theta));
+    foldProgram.setUniformValue("angle", float(progress*M_PI));
+    foldProgram.setUniformValue("xLeft", -1.0f);
+    foldProgram.enableAttributeArray(0);
+    foldProgram.enableAttributeArray(1);
+    foldProgram.setAttributeArray(0, meshVertices.constData(), 4);
+    foldProgram.setAttributeArray(1, meshTexCoords.constData(), 2);
+    glDrawElements(GL_TRIANGLES, meshIndices.count(), GL_UNSIGNED_SHORT, meshIndices.constData());
+    foldProgram.disableAttributeArray(1);
+    foldProgram.disableAttributeArray(0);
+    foldProgram.release();
+}
+
+
+/*!
+ * \brief GLSlideWidget::paintGL
+ */
+void
+GLSlideWidget::paintGL() {
+    glClear(GL_COLOR_BUFFER_BIT);
+    if(!bUsable || !pPresentTexture || !pNextTexture)
+        return;
+    if(transition == glTransition_Fold) {
+        drawFlat(pNextTexture, pNextTexture, 1.0f);
+        if(progress < 1.0)
+            drawFold(pPresentTexture);
+    }
+    else {
+        drawFlat(pNextTexture, pPresentTexture, float(progress));
+    }
+}
@@ -0,0 +1,97 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef GLSLIDEWIDGET_H
+#define GLSLIDEWIDGET_H
+
+#include <QOpenGLWidget>
+#include <QOpenGLFunctions>
+#include <QOpenGLShaderProgram>
+#include <QMatrix4x4>
+#include <QVector>
+#include <QImage>
+
+
+QT_FORWARD_DECLARE_CLASS(QFile)
+QT_FORWARD_DECLARE_CLASS(QOpenGLTexture)
+
+
+class GLSlideWidget : public QOpenGLWidget, protected QOpenGLFunctions
+{
+    Q_OBJECT
+
+public:
+    GLSlideWidget(QFile *myLogFile = Q_NULLPTR, QWidget *parent = Q_NULLPTR);
+    ~GLSlideWidget();
+    bool isUsable();
+    void setSlides(const QImage& newPresentImage, const QImage& newNextImage);
+    void setTransition(int newTransition);
+    void setProgress(double newProgress);
+
+public:
+    /*!
+     * \brief The glTransition enum The transitions rendered by the shaders
+     */
+    enum glTransition {
+        glTransition_Fade,/*!< Cross fade (fshaderFade.glsl) */
+        glTransition_Fold /*!< Page fold (vshaderFold.glsl) */
+    };
+
+signals:
+    void glUnavailable();/*!< Emitted when OpenGL can't be used: the caller has to fall back on the CPU */
+
+protected:
+    void initializeGL();
+    void resizeGL(int w, int h);
+    void paintGL();
+
+private:
+    QByteArray shaderSource(QString sResource);
+    bool buildProgram(QOpenGLShaderProgram *pProgram,
+                      QString sVertexShader,
+                      QString sFragmentShader);
+    void buildMeshes();
+    void uploadTextures();
+    void drawFlat(QOpenGLTexture *pTexture0, QOpenGLTexture *pTexture1, float alpha);
+    void drawFold(QOpenGLTexture *pTexture);
+    void releaseTextures();
+
+private:
+    QFile                *logFile;
+    QOpenGLShaderProgram  fadeProgram;
+    QOpenGLShaderProgram  foldProgram;
+    QOpenGLTexture       *pPresentTexture;
+    QOpenGLTexture       *pNextTexture;
+    QImage                presentImage;
+    QImage                nextImage;
+    qint64                presentKey;
+    qint64                nextKey;
+    bool                  bTexturesPending;
+    bool                  bInitialized;
+    bool                  bUsable;
+    int                   transition;
+    double                progress;
+    QMatrix4x4            projection;
+    QVector<GLfloat>      quadVertices;
+    QVector<GLfloat>      quadTexCoords;
+    QVector<GLfloat>      meshVertices;
+    QVector<GLfloat>      meshTexCoords;
+    QVector<GLushort>     meshIndices;
+};
+
+#endif // GLSLIDEWIDGET_H
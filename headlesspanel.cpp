@@ -0,0 +1,136 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QHostInfo>
+#include <QElapsedTimer>
+
+#include "headlesspanel.h"
+#include "panelsession.h"
+#include "scoremodel.h"
+#include "utility.h"
+
+
+/*!
+ * \brief HeadlessPanel::HeadlessPanel A Score Panel without display
+ * \param myServerUrl The Panel Server to connect to
+ * \param myPanelType VOLLEY_PANEL, BASKET_PANEL or HANDBALL_PANEL
+ * \param myLogFile
+ * \param parent
+ *
+ * It keeps the session with the Server with the same PanelSession
+ * of ScorePanel and feeds the messages to the same ScoreModel used
+ * by the Segnapunti Panels, measuring the time spent parsing them.
+ * Used (with the --headless option) for benchmarking and CI
+ * on machines without a display.
+ */
+HeadlessPanel::HeadlessPanel(QString myServerUrl, int myPanelType, QFile *myLogFile, QObject *parent)
+    : QObject(parent)
+    , logFile(myLogFile)
+    , sServerUrl(myServerUrl)
+    , nMessages(0)
+    , nFields(0)
+    , totalParseNs(0)
+    , maxParseNs(0)
+    , nResumes(0)
+{
+    pScoreModel = new ScoreModel(myPanelType, this);
+    pSession = new PanelSession(sServerUrl, QHostInfo::localHostName(), logFile, this);
+
+    connect(pSession->socket(), SIGNAL(textMessageReceived(QString)),
+            this, SLOT(onTextMessageReceived(QString)));
+    connect(pSession, SIGNAL(sessionStarted(bool)),
+            this, SLOT(onSessionStarted(bool)));
+    connect(pSession, SIGNAL(sessionLost()),
+            this, SLOT(onSessionLost()));
+
+    logMessage(logFile,
+               Q_FUNC_INFO,
+               QString("Connecting to %1 (panel type %2)")
+               .arg(sServerUrl)
+               .arg(myPanelType));
+    pSession->open();
+}
+
+
+/*!
+ * \brief HeadlessPanel::~HeadlessPanel
+ */
+HeadlessPanel::~HeadlessPanel() {
+    pSession->close();
+}
+
+
+/*!
+ * \brief HeadlessPanel::onSessionStarted Count the resumed sessions
+ * \param bResumed
+ */
+void
+HeadlessPanel::onSessionStarted(bool bResumed) {
+    if(bResumed)
+        nResumes++;
+}
+
+
+/*!
+ * \brief HeadlessPanel::onSessionLost Give up with this Server
+ */
+void
+HeadlessPanel::onSessionLost() {
+    pSession->close();
+    emit panelClosed();
+}
+
+
+/*!
+ * \brief HeadlessPanel::onTextMessageReceived Update the model and measure it
+ */
+void
+HeadlessPanel::onTextMessageReceived(QString sMessage) {
+    QElapsedTimer parseTime;
+    parseTime.start();
+    QStringList fields = pScoreModel->update(sMessage);
+    qint64 ns = parseTime.nsecsElapsed();
+    nMessages++;
+    nFields += fields.count();
+    totalParseNs += ns;
+    maxParseNs = qMax(maxParseNs, ns);
+#ifdef LOG_VERBOSE
+    logMessage(logFile,
+               Q_FUNC_INFO,
+               QString("%1 fields in %2 ns").arg(fields.count()).arg(ns));
+#endif
+}
+
+
+/*!
+ * \brief HeadlessPanel::report
+ * \return The statistics collected so far and the present score
+ */
+QString
+HeadlessPanel::report() {
+    QString sReport;
+    sReport += QString("messages: %1\n").arg(nMessages);
+    sReport += QString("fields: %1\n").arg(nFields);
+    if(nMessages > 0)
+        sReport += QString("parse ns (mean/max): %1/%2\n")
+                   .arg(totalParseNs/nMessages)
+                   .arg(maxParseNs);
+    sReport += QString("resumes: %1\n").arg(nResumes);
+    sReport += QString("score: %1\n").arg(pScoreModel->snapshot());
+    return sReport;
+}
@@ -0,0 +1,63 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef HEADLESSPANEL_H
+#define HEADLESSPANEL_H
+
+#include <QObject>
+
+
+QT_FORWARD_DECLARE_CLASS(QFile)
+QT_FORWARD_DECLARE_CLASS(ScoreModel)
+QT_FORWARD_DECLARE_CLASS(PanelSession)
+
+
+class HeadlessPanel : public QObject
+{
+    Q_OBJECT
+
+public:
+    HeadlessPanel(QString myServerUrl, int myPanelType, QFile *myLogFile, QObject *parent = Q_NULLPTR);
+    ~HeadlessPanel();
+    QString report();
+
+signals:
+    /*!
+     * \brief panelClosed The Server didn't come back within RESUME_TIMEOUT
+     */
+    void panelClosed();
+
+private slots:
+    void onSessionStarted(bool bResumed);
+    void onSessionLost();
+    void onTextMessageReceived(QString sMessage);
+
+private:
+    QFile        *logFile;
+    QString       sServerUrl;
+    ScoreModel   *pScoreModel;
+    PanelSession *pSession;
+    // Statistics
+    qint64        nMessages;
+    qint64        nFields;
+    qint64        totalParseNs;
+    qint64        maxParseNs;
+    int           nResumes;
+};
+
+#endif // HEADLESSPANEL_H
@@ -0,0 +1,221 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QPainter>
+#include <QEvent>
+#include <QSettings>
+
+#include "liveview.h"
+#include "v4l2capture.h"
+#include "utility.h"
+
+
+/*!
+ * \brief LiveView::LiveView A Picture in Picture view of the Live Camera
+ * \param myLogFile The File for message logging (if any)
+ * \param parent The Score Panel that hosts the view
+ *
+ * The frames are painted as soon as they are dequeued from the
+ * driver, over the bottom right corner of the parent.
+ */
+LiveView::LiveView(QFile *myLogFile, QWidget *parent)
+    : QWidget(parent)
+    , logFile(myLogFile)
+    , frameTimeUs(0)
+    , bFramePainted(true)
+{
+    setAttribute(Qt::WA_OpaquePaintEvent);// We paint every pixel
+    setAttribute(Qt::WA_NoSystemBackground);
+    pCapture = new V4L2Capture(logFile, this);
+    connect(pCapture, SIGNAL(frameReady(QImage,qint64)),
+            this, SLOT(onFrameReady(QImage,qint64)));
+    connect(pCapture, SIGNAL(captureError(QString)),
+            this, SLOT(onCaptureError(QString)));
+    parent->installEventFilter(this);
+    resetStatistics();
+    hide();
+}
+
+
+/*!
+ * \brief LiveView::~LiveView
+ */
+LiveView::~LiveView() {
+    pCapture->close();
+}
+
+
+/*!
+ * \brief LiveView::start Start showing the Camera
+ * \param sDevice The V4L2 device (a v4l2loopback device works as well)
+ * \return false if the device can't be used
+ */
+bool
+LiveView::start(QString sDevice) {
+    if(isActive())
+        return true;
+    QSettings settings("Gabriele Salvato", "Score Panel");
+    QSize captureSize(settings.value("camera/width",  640).toInt(),
+                      settings.value("camera/height", 480).toInt());
+    if(!pCapture->open(sDevice, captureSize))
+        return false;
+    resetStatistics();
+    frame = QImage();
+    placeInParent();
+    show();
+    raise();
+    return true;
+}
+
+
+/*!
+ * \brief LiveView::stop Stop the Camera and hide the view
+ */
+void
+LiveView::stop() {
+    if(!isActive())
+        return;
+    pCapture->close();
+    frame = QImage();// It was pointing to the driver buffers
+    hide();
+    logMessage(logFile,
+               Q_FUNC_INFO,
+               QString("Capture to display latency (mean,max us): %1")
+               .arg(latencyReport()));
+    emit closed();
+}
+
+
+/*!
+ * \brief LiveView::onCaptureError The Camera has been lost (and already closed)
+ * \param sError Unused (already logged)
+ *
+ * The view is hidden and closed() lets the Server know
+ * that the Camera is no longer shown.
+ */
+void
+LiveView::onCaptureError(QString sError) {
+    Q_UNUSED(sError)
+    frame = QImage();// It was pointing to the driver buffers
+    hide();
+    emit closed();
+}
+
+
+/*!
+ * \brief LiveView::isActive
+ * \return true if the Camera is streaming
+ */
+bool
+LiveView::isActive() {
+    return pCapture->isOpen();
+}
+
+
+/*!
+ * \brief LiveView::latencyReport
+ * \return "mean,max" of the capture to display latency in us
+ */
+QString
+LiveView::latencyReport() {
+    qint64 mean = nFrames > 0 ? latencySumUs/nFrames : 0;
+    return QString("%1,%2").arg(mean).arg(latencyMaxUs);
+}
+
+
+/*!
+ * \brief LiveView::resetStatistics
+ */
+void
+LiveView::resetStatistics() {
+    nFrames      = 0;
+    latencySumUs = 0;
+    latencyMaxUs = 0;
+}
+
+
+/*!
+ * \brief LiveView::placeInParent Keep the view in the bottom right corner
+ *
+ * The view takes one third of the parent width (4:3 aspect).
+ */
+void
+LiveView::placeInParent() {
+    QWidget* pParent = parentWidget();
+    int w = pParent->width()/3;
+    int h = (w*3)/4;
+    int margin = pParent->width()/100;
+    setGeometry(pParent->width()-w-margin, pParent->height()-h-margin, w, h);
+}
+
+
+/*!
+ * \brief LiveView::eventFilter Follow the parent size changes
+ */
+bool
+LiveView::eventFilter(QObject *pObject, QEvent *event) {
+    if(pObject == parentWidget() && event->type() == QEvent::Resize)
+        placeInParent();
+    return QWidget::eventFilter(pObject, event);
+}
+
+
+/*!
+ * \brief LiveView::onFrameReady Invoked when a new frame has been captured
+ * \param newFrame The frame (valid until the next one)
+ * \param captureTimeUs The capture time (CLOCK_MONOTONIC)
+ */
+void
+LiveView::onFrameReady(QImage newFrame, qint64 captureTimeUs) {
+    frame = newFrame;
+    frameTimeUs = captureTimeUs;
+    bFramePainted = false;
+    repaint();// Don't wait for the next event loop iteration
+}
+
+
+/*!
+ * \brief LiveView::paintEvent Paint the last frame, aspect preserved
+ */
+void
+LiveView::paintEvent(QPaintEvent *event) {
+    Q_UNUSED(event)
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::black);
+    if(frame.isNull())
+        return;
+    QSize frameSize = frame.size().scaled(size(), Qt::KeepAspectRatio);
+    QRect target(QPoint((width()-frameSize.width())/2, (height()-frameSize.height())/2),
+                 frameSize);
+    painter.drawImage(target, frame);
+    if(!bFramePainted) {
+        qint64 latencyUs = V4L2Capture::monotonicUs() - frameTimeUs;
+        bFramePainted = true;
+        nFrames++;
+        latencySumUs += latencyUs;
+        latencyMaxUs = qMax(latencyMaxUs, latencyUs);
+#ifdef LOG_VERBOSE
+        if(nFrames % 300 == 0) {
+            logMessage(logFile,
+                       Q_FUNC_INFO,
+                       QString("Capture to display latency (mean,max us): %1")
+                       .arg(latencyReport()));
+        }
+#endif
+    }
+}
@@ -0,0 +1,69 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef LIVEVIEW_H
+#define LIVEVIEW_H
+
+#include <QWidget>
+#include <QImage>
+
+
+QT_FORWARD_DECLARE_CLASS(QFile)
+QT_FORWARD_DECLARE_CLASS(V4L2Capture)
+
+
+class LiveView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    LiveView(QFile *myLogFile, QWidget *parent);
+    ~LiveView();
+    bool start(QString sDevice);
+    void stop();
+    bool isActive();
+    QString latencyReport();
+
+signals:
+    void closed();/*!< Emitted when a running Live View stops */
+
+protected:
+    void paintEvent(QPaintEvent *event);
+    bool eventFilter(QObject *pObject, QEvent *event);
+
+private slots:
+    void onFrameReady(QImage frame, qint64 captureTimeUs);
+    void onCaptureError(QString sError);
+
+private:
+    void placeInParent();
+    void resetStatistics();
+
+private:
+    QFile*       logFile;
+    V4L2Capture* pCapture;
+    QImage       frame;
+    qint64       frameTimeUs;
+    bool         bFramePainted;
+    // Capture-to-display latency (us)
+    qint64       nFrames;
+    qint64       latencySumUs;
+    qint64       latencyMaxUs;
+};
+
+#endif // LIVEVIEW_H
@@ -16,7 +16,70 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *
 */
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QSettings>
+#include <QTextStream>
+#include <QTimer>
+#include <QTime>
+#include <cstring>
+
 #include "myapplication.h"
+#include "headlesspanel.h"
+#include "utility.h"
+
+
+/*!
+ * \brief runHeadless Run a Panel without any display (--headless)
+ *
+ * Only the protocol and the score model are exercised: no widgets,
+ * no serial ports, no processes. The Server is the one given with
+ * --server (or the last one used) and the statistics are printed
+ * on exit (after --duration seconds, if given).
+ */
+static int
+runHeadless(int& argc, char *argv[]) {
+    QCoreApplication a(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Score Panel (headless)");
+    parser.addHelpOption();
+    QCommandLineOption headlessOption("headless", "Run without display.");
+    QCommandLineOption serverOption("server", "Panel Server url (ws://host:port).", "url");
+    QCommandLineOption panelOption("panel", "Panel type (0=Volley, 1=Basket, 2=Handball).", "type");
+    QCommandLineOption durationOption("duration", "Seconds to run (0 = forever).", "s", "0");
+    parser.addOption(headlessOption);
+    parser.addOption(serverOption);
+    parser.addOption(panelOption);
+    parser.addOption(durationOption);
+    parser.process(a);
+
+    QSettings settings("Gabriele Salvato", "Score Panel");
+    QString sServerUrl = settings.value("server/lastUrl", QString()).toString();
+    int panelType = settings.value("server/lastPanelType", FIRST_PANEL).toInt();
+    if(parser.isSet(serverOption))
+        sServerUrl = parser.value(serverOption);
+    if(parser.isSet(panelOption))
+        panelType = parser.value(panelOption).toInt();
+    if(sServerUrl.isEmpty() || panelType < FIRST_PANEL || panelType > LAST_PANEL) {
+        QTextStream(stderr) << "A Server (--server) and a valid panel type (--panel) are needed" << Qt::endl;
+        return 1;
+    }
+
+    QTime time(QTime::currentTime());
+    srand(uint(time.msecsSinceStartOfDay()));
+
+    HeadlessPanel panel(sServerUrl, panelType, Q_NULLPTR);
+    // Without its Server the statistics are printed and we are done
+    QObject::connect(&panel, SIGNAL(panelClosed()),
+                     &a, SLOT(quit()));
+    int duration = parser.value(durationOption).toInt();
+    if(duration > 0)
+        QTimer::singleShot(duration*1000, &a, SLOT(quit()));
+    int result = a.exec();
+    QTextStream(stdout) << panel.report();
+    return result;
+}
+
 
 /*!
  * \mainpage The Score Panels
@@ -74,6 +137,18 @@ main(int argc, char *argv[]) {
     QString sVersion = QString("1.2");
     QApplication::setApplicationVersion(sVersion);
 
+    // --headless: protocol and score model only, no widgets at all.
+    // --offscreen: the whole widget path, rendered without a display.
+    bool bHeadless = false;
+    for(int i=1; i<argc; i++) {
+        if(!strcmp(argv[i], "--headless"))
+            bHeadless = true;
+        else if(!strcmp(argv[i], "--offscreen"))
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    if(bHeadless)
+        return runHeadless(argc, argv);
+
     MyApplication a(argc, argv);
     int result = a.exec();
     return result;
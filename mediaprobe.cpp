@@ -0,0 +1,419 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QImageReader>
+#include <QSettings>
+#include <QMutex>
+#include <QtEndian>
+
+#include "mediaprobe.h"
+#include "utility.h"
+
+
+#define CACHE_FILE     ".mediaprobe.json"
+#define MAX_MOOV_SIZE  (32*1024*1024) // Larger boxes are not worth a spot
+#define VIDEO_CODECS   "avc1,avc3,hvc1,hev1,mp4v"
+
+
+// The cache file is shared by the updater threads and the players
+static QMutex cacheMutex;
+
+
+/*!
+ * \brief boxType Build the fourcc of an ISO BMFF box
+ */
+static quint32
+boxType(const char* sType) {
+    return qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(sType));
+}
+
+
+/*!
+ * \brief fourcc The printable form of a box type
+ */
+static QString
+fourcc(quint32 type) {
+    uchar chars[4];
+    qToBigEndian<quint32>(type, chars);
+    return QString::fromLatin1(reinterpret_cast<const char*>(chars), 4);
+}
+
+
+/*!
+ * \brief findBox Look for a child box in a memory buffer
+ * \param data The buffer
+ * \param from The first byte of the children
+ * \param to One past the last byte of the children
+ * \param type The box to look for
+ * \param contentStart [out] The first byte of the box content
+ * \param contentEnd [out] One past the last byte of the box content
+ * \return false if the box is not present (or the buffer is malformed)
+ */
+static bool
+findBox(const QByteArray& data, int from, int to, const char* type, int& contentStart, int& contentEnd) {
+    const uchar* pData = reinterpret_cast<const uchar*>(data.constData());
+    int pos = from;
+    while(pos+8 <= to) {
+        qint64 size = qFromBigEndian<quint32>(pData+pos);
+        int header = 8;
+        if(size == 1) {
+            if(pos+16 > to) return false;
+            size = qint64(qFromBigEndian<quint64>(pData+pos+8));
+            header = 16;
+        }
+        else if(size == 0)
+            size = to - pos;
+        if(size < header || pos+size > to)
+            return false;
+        if(qFromBigEndian<quint32>(pData+pos+4) == boxType(type)) {
+            contentStart = pos + header;
+            contentEnd   = int(pos + size);
+            return true;
+        }
+        pos += int(size);
+    }
+    return false;
+}
+
+
+/*!
+ * \brief MediaProbe::MediaProbe Check Spots and Slides before showing them
+ * \param sDirectory The directory of the media files
+ * \param myLogFile The File for message logging (if any)
+ *
+ * The results are kept in a cache file inside the directory
+ * and are valid as long as the file size and modification time
+ * do not change. In this way the players never probe a file twice.
+ */
+MediaProbe::MediaProbe(QString sDirectory, QFile *myLogFile)
+    : logFile(myLogFile)
+    , sDir(sDirectory)
+    , bDirty(false)
+{
+    if(!sDir.endsWith("/")) sDir += "/";
+    sCacheFile = sDir + QString(CACHE_FILE);
+    load();
+}
+
+
+/*!
+ * \brief MediaProbe::load Read the cache file (if any)
+ */
+void
+MediaProbe::load() {
+    QMutexLocker locker(&cacheMutex);
+    QFile cacheFile(sCacheFile);
+    if(!cacheFile.open(QIODevice::ReadOnly))
+        return;
+    QJsonObject root = QJsonDocument::fromJson(cacheFile.readAll()).object();
+    for(QJsonObject::const_iterator it=root.constBegin(); it!=root.constEnd(); ++it)
+        cache.insert(it.key(), fromJson(it.value().toObject()));
+}
+
+
+/*!
+ * \brief MediaProbe::save Write back the cache (only if changed)
+ *
+ * The entries of the files no more present are dropped.
+ */
+void
+MediaProbe::save() {
+    QMutexLocker locker(&cacheMutex);
+    QJsonObject root;
+    for(QHash<QString,mediaInfo>::const_iterator it=cache.constBegin(); it!=cache.constEnd(); ++it) {
+        if(QFile::exists(sDir + it.key()))
+            root.insert(it.key(), toJson(it.value()));
+        else
+            bDirty = true;
+    }
+    if(!bDirty)
+        return;
+    QSaveFile cacheFile(sCacheFile);// Readers never see a partial file
+    if(!cacheFile.open(QIODevice::WriteOnly) ||
+       cacheFile.write(QJsonDocument(root).toJson(QJsonDocument::Compact)) < 0 ||
+       !cacheFile.commit())
+    {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Unable to write %1").arg(sCacheFile));
+        return;
+    }
+    bDirty = false;
+}
+
+
+/*!
+ * \brief MediaProbe::info The probe results for a file
+ * \param sFileName The file name (inside the directory)
+ * \return The cached results or, if stale, the ones of a new probe
+ */
+mediaInfo
+MediaProbe::info(QString sFileName) {
+    QFileInfo fileInfo(sDir + sFileName);
+    if(cache.contains(sFileName)) {
+        const mediaInfo& cached = cache[sFileName];
+        if(cached.fileSize == fileInfo.size() &&
+           cached.lastModified == fileInfo.lastModified().toMSecsSinceEpoch())
+            return cached;
+    }
+    mediaInfo newInfo = probeFile(fileInfo.absoluteFilePath());
+    if(!newInfo.bValid) {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("%1 rejected: %2").arg(sFileName, newInfo.sError));
+    }
+#ifdef LOG_VERBOSE
+    else {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("%1: %2 %3 %4x%5 %6ms")
+                   .arg(sFileName, newInfo.sFormat, newInfo.sCodec)
+                   .arg(newInfo.width)
+                   .arg(newInfo.height)
+                   .arg(newInfo.durationMs));
+    }
+#endif
+    cache.insert(sFileName, newInfo);
+    bDirty = true;
+    return newInfo;
+}
+
+
+/*!
+ * \brief MediaProbe::playable Filter out the files that can't be played
+ * \param fileList The files to check (inside the directory)
+ * \return The valid files
+ */
+QFileInfoList
+MediaProbe::playable(const QFileInfoList& fileList) {
+    QFileInfoList validList;
+    for(int i=0; i<fileList.count(); i++) {
+        if(info(fileList.at(i).fileName()).bValid)
+            validList.append(fileList.at(i));
+    }
+    return validList;
+}
+
+
+/*!
+ * \brief MediaProbe::probeFile Probe a file without using the cache
+ * \param sFilePath The file to probe
+ * \return The probe results
+ */
+mediaInfo
+MediaProbe::probeFile(QString sFilePath) {
+    QFileInfo fileInfo(sFilePath);
+    mediaInfo info;
+    info.bValid       = false;
+    info.durationMs   = 0;
+    info.width        = 0;
+    info.height       = 0;
+    info.fileSize     = fileInfo.size();
+    info.lastModified = fileInfo.lastModified().toMSecsSinceEpoch();
+    if(fileInfo.suffix().toLower() != QString("mp4"))
+        return probeImage(sFilePath, info);
+    QFile file(sFilePath);
+    if(!file.open(QIODevice::ReadOnly)) {
+        info.sError = QString("unable to open");
+        return info;
+    }
+    return probeMp4(file, info);
+}
+
+
+/*!
+ * \brief MediaProbe::probeImage Check that an image can be decoded
+ */
+mediaInfo
+MediaProbe::probeImage(QString sFilePath, mediaInfo info) {
+    QImageReader reader(sFilePath);
+    if(!reader.canRead()) {
+        info.sError = reader.errorString();
+        return info;
+    }
+    QSize size = reader.size();
+    info.sFormat = QString::fromLatin1(reader.format());
+    info.width   = size.width();
+    info.height  = size.height();
+    info.bValid  = true;
+    return info;
+}
+
+
+/*!
+ * \brief MediaProbe::probeMp4 Walk the boxes of an mp4 file
+ * \param file The opened file
+ * \param info The partially filled results
+ * \return The results
+ *
+ * Truncated files, files without the movie header or without
+ * a video track and unsupported codecs are rejected.
+ */
+mediaInfo
+MediaProbe::probeMp4(QFile& file, mediaInfo info) {
+    info.sFormat = QString("mp4");
+    qint64 fileSize = file.size();
+    qint64 pos = 0;
+    qint64 moovPos = -1, moovSize = 0;
+    bool bFtyp = false, bMdat = false;
+    // Top level boxes: read only their headers
+    while(pos+8 <= fileSize) {
+        if(!file.seek(pos)) break;
+        QByteArray header = file.read(16);
+        if(header.size() < 8) break;
+        const uchar* pHeader = reinterpret_cast<const uchar*>(header.constData());
+        qint64 size = qFromBigEndian<quint32>(pHeader);
+        quint32 type = qFromBigEndian<quint32>(pHeader+4);
+        int headerSize = 8;
+        if(size == 1) {
+            if(header.size() < 16) break;
+            size = qint64(qFromBigEndian<quint64>(pHeader+8));
+            headerSize = 16;
+        }
+        else if(size == 0)
+            size = fileSize - pos;
+        if(size < headerSize || pos+size > fileSize) {
+            info.sError = QString("truncated %1 box").arg(fourcc(type));
+            return info;
+        }
+        if(type == boxType("ftyp")) bFtyp = true;
+        if(type == boxType("mdat")) bMdat = true;
+        if(type == boxType("moov")) {
+            moovPos  = pos + headerSize;
+            moovSize = size - headerSize;
+        }
+        pos += size;
+    }
+    if(!bFtyp || !bMdat || moovPos < 0) {
+        info.sError = QString("not a complete mp4 file");
+        return info;
+    }
+    if(moovSize > MAX_MOOV_SIZE) {
+        info.sError = QString("movie header too large");
+        return info;
+    }
+    file.seek(moovPos);
+    QByteArray moov = file.read(moovSize);
+    if(moov.size() != moovSize) {
+        info.sError = QString("unable to read the movie header");
+        return info;
+    }
+    const uchar* pMoov = reinterpret_cast<const uchar*>(moov.constData());
+    int start, end;
+    // Duration from the movie header
+    if(findBox(moov, 0, moov.size(), "mvhd", start, end)) {
+        quint32 timeScale = 0;
+        quint64 duration  = 0;
+        if(pMoov[start] == 1 && end-start >= 32) {
+            timeScale = qFromBigEndian<quint32>(pMoov+start+20);
+            duration  = qFromBigEndian<quint64>(pMoov+start+24);
+        }
+        else if(end-start >= 20) {
+            timeScale = qFromBigEndian<quint32>(pMoov+start+12);
+            duration  = qFromBigEndian<quint32>(pMoov+start+16);
+        }
+        if(timeScale > 0)
+            info.durationMs = qint64(duration*1000/timeScale);
+    }
+    // Look for the video track
+    int trakFrom = 0;
+    int trakStart, trakEnd;
+    while(findBox(moov, trakFrom, moov.size(), "trak", trakStart, trakEnd)) {
+        trakFrom = trakEnd;
+        int mdiaStart, mdiaEnd, minfStart, minfEnd, stblStart, stblEnd;
+        if(!findBox(moov, trakStart, trakEnd, "mdia", mdiaStart, mdiaEnd))
+            continue;
+        if(!findBox(moov, mdiaStart, mdiaEnd, "hdlr", start, end) || end-start < 12)
+            continue;
+        if(qFromBigEndian<quint32>(pMoov+start+8) != boxType("vide"))
+            continue;
+        if(!findBox(moov, mdiaStart, mdiaEnd, "minf", minfStart, minfEnd) ||
+           !findBox(moov, minfStart, minfEnd, "stbl", stblStart, stblEnd) ||
+           !findBox(moov, stblStart, stblEnd, "stsd", start, end) ||
+           end-start < 8+36)
+        {
+            info.sError = QString("malformed video track");
+            return info;
+        }
+        // First sample entry: size, type, then the visual sample entry fields
+        const uchar* pEntry = pMoov + start + 8;
+        info.sCodec = fourcc(qFromBigEndian<quint32>(pEntry+4));
+        info.width  = qFromBigEndian<quint16>(pEntry+32);
+        info.height = qFromBigEndian<quint16>(pEntry+34);
+        break;
+    }
+    if(info.sCodec.isEmpty()) {
+        info.sError = QString("no video track");
+        return info;
+    }
+    QSettings settings("Gabriele Salvato", "Score Panel");
+    QStringList codecs = settings.value("spots/codecs", VIDEO_CODECS).toString().split(",", Qt::SkipEmptyParts);
+    if(!codecs.contains(info.sCodec)) {
+        info.sError = QString("unsupported codec %1").arg(info.sCodec);
+        return info;
+    }
+    if(info.durationMs <= 0) {
+        info.sError = QString("empty movie");
+        return info;
+    }
+    info.bValid = true;
+    return info;
+}
+
+
+/*!
+ * \brief MediaProbe::toJson
+ */
+QJsonObject
+MediaProbe::toJson(const mediaInfo& info) {
+    QJsonObject object;
+    object.insert("valid",    info.bValid);
+    object.insert("format",   info.sFormat);
+    object.insert("codec",    info.sCodec);
+    object.insert("duration", double(info.durationMs));
+    object.insert("width",    info.width);
+    object.insert("height",   info.height);
+    object.insert("size",     double(info.fileSize));
+    object.insert("modified", double(info.lastModified));
+    object.insert("error",    info.sError);
+    return object;
+}
+
+
+/*!
+ * \brief MediaProbe::fromJson
+ */
+mediaInfo
+MediaProbe::fromJson(const QJsonObject& object) {
+    mediaInfo info;
+    info.bValid       = object.value("valid").toBool();
+    info.sFormat      = object.value("format").toString();
+    info.sCodec       = object.value("codec").toString();
+    info.durationMs   = qint64(object.value("duration").toDouble());
+    info.width        = object.value("width").toInt();
+    info.height       = object.value("height").toInt();
+    info.fileSize     = qint64(object.value("size").toDouble(-1));
+    info.lastModified = qint64(object.value("modified").toDouble());
+    info.sError       = object.value("error").toString();
+    return info;
+}
@@ -0,0 +1,71 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef MEDIAPROBE_H
+#define MEDIAPROBE_H
+
+#include <QString>
+#include <QHash>
+#include <QFileInfoList>
+
+
+QT_FORWARD_DECLARE_CLASS(QFile)
+QT_FORWARD_DECLARE_CLASS(QJsonObject)
+
+
+/*!
+ * \brief The result of probing a media file
+ */
+struct mediaInfo {
+    bool    bValid;        /*!< \brief true if the file can be played (or shown) */
+    QString sFormat;       /*!< \brief "mp4" or the image format */
+    QString sCodec;        /*!< \brief The video codec (sample entry fourcc) */
+    qint64  durationMs;    /*!< \brief The duration (0 for images) */
+    int     width;         /*!< \brief The frame width */
+    int     height;        /*!< \brief The frame height */
+    qint64  fileSize;      /*!< \brief The size of the probed file */
+    qint64  lastModified;  /*!< \brief The modification time of the probed file (ms since epoch) */
+    QString sError;        /*!< \brief Why the file is not valid */
+};
+
+
+class MediaProbe
+{
+public:
+    MediaProbe(QString sDirectory, QFile *myLogFile = Q_NULLPTR);
+    mediaInfo info(QString sFileName);
+    QFileInfoList playable(const QFileInfoList& fileList);
+    void save();
+    static mediaInfo probeFile(QString sFilePath);
+
+private:
+    void load();
+    static mediaInfo probeMp4(QFile& file, mediaInfo info);
+    static mediaInfo probeImage(QString sFilePath, mediaInfo info);
+    static QJsonObject toJson(const mediaInfo& info);
+    static mediaInfo fromJson(const QJsonObject& object);
+
+private:
+    QFile*                   logFile;
+    QString                  sDir;
+    QString                  sCacheFile;
+    QHash<QString,mediaInfo> cache;
+    bool                     bDirty;
+};
+
+#endif // MEDIAPROBE_H
@@ -0,0 +1,122 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QFile>
+#include <QStringList>
+#if defined(Q_OS_UNIX)
+    #include <unistd.h>
+    #include <sys/resource.h>
+#endif
+
+#include "metrics.h"
+
+
+QAtomicInteger<qint64> Metrics::counters[Metrics::nCounters];
+QAtomicInteger<qint64> Metrics::buckets[Metrics::nHistograms][Metrics::nBuckets];
+
+// Upper limits (in us) of the histogram buckets: the last one is open
+static const qint64 bucketLimit[Metrics::nBuckets-1] = {
+    50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000
+};
+
+
+/*!
+ * \brief Metrics::sample Add a time to an histogram
+ * \param h The histogram
+ * \param us The time in us
+ */
+void
+Metrics::sample(histogram h, qint64 us) {
+    int i = 0;
+    while(i < nBuckets-1 && us >= bucketLimit[i])
+        i++;
+    buckets[h][i].fetchAndAddRelaxed(1);
+}
+
+
+/*!
+ * \brief Metrics::value
+ * \return The present value of a counter
+ */
+qint64
+Metrics::value(counter c) {
+    return counters[c].loadRelaxed();
+}
+
+
+/*!
+ * \brief Metrics::histogramString
+ * \return The bucket counts separated by '/'
+ */
+QString
+Metrics::histogramString(histogram h) {
+    QStringList sCounts;
+    for(int i=0; i<nBuckets; i++)
+        sCounts.append(QString::number(buckets[h][i].loadRelaxed()));
+    return sCounts.join("/");
+}
+
+
+/*!
+ * \brief Metrics::transferString
+ * \return "bytes/KB per second" of a FileUpdater
+ */
+QString
+Metrics::transferString(counter bytes, counter ms) {
+    qint64 nBytes = value(bytes);
+    qint64 nMs = value(ms);
+    qint64 kBps = nMs > 0 ? nBytes/nMs : 0;// bytes/ms = KB/s (1000 bytes)
+    return QString("%1/%2").arg(nBytes).arg(kBps);
+}
+
+
+/*!
+ * \brief Metrics::snapshot All the counters in a compact form
+ * \return "key=value;..." (the histograms bucket limits are 50,100,200,500us,1,2,5,10,20ms)
+ */
+QString
+Metrics::snapshot() {
+    QString sSnapshot;
+    sSnapshot += QString("msgs=%1").arg(value(MessagesReceived));
+    sSnapshot += QString(";parse=%1").arg(histogramString(ParseTime));
+    sSnapshot += QString(";paint=%1").arg(histogramString(PaintTime));
+    sSnapshot += QString(";frames=%1/%2").arg(value(SlideFrames)).arg(value(SlideLateFrames));
+    sSnapshot += QString(";spots=%1").arg(transferString(SpotBytes, SpotTransferMs));
+    sSnapshot += QString(";slides=%1").arg(transferString(SlideBytes, SlideTransferMs));
+    sSnapshot += QString(";spawns=%1/%2").arg(value(ProcessSpawns)).arg(value(ProcessFailures));
+#if defined(Q_OS_LINUX)
+    // Resident set size (in pages) is the second field of statm
+    QFile statm("/proc/self/statm");
+    if(statm.open(QIODevice::ReadOnly)) {
+        QList<QByteArray> fields = statm.readAll().split(' ');
+        if(fields.count() > 1) {
+            qint64 rssKB = fields.at(1).toLongLong()*sysconf(_SC_PAGESIZE)/1024;
+            sSnapshot += QString(";rssKB=%1").arg(rssKB);
+        }
+    }
+#endif
+#if defined(Q_OS_UNIX)
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) == 0) {
+        qint64 cpuMs = qint64(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)*1000 +
+                       qint64(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec)/1000;
+        sSnapshot += QString(";cpuMs=%1").arg(cpuMs);
+    }
+#endif
+    return sSnapshot;
+}
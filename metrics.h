@@ -0,0 +1,74 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QAtomicInteger>
+#include <QString>
+
+
+class Metrics
+{
+public:
+    /*!
+     * \brief The counter enum The Panel counters
+     */
+    enum counter {
+        MessagesReceived,/*!< Text messages from the Server */
+        SlideFrames,     /*!< Slide transition frames */
+        SlideLateFrames, /*!< Frames later than twice their interval */
+        ProcessSpawns,   /*!< Processes started (Slides, Spots, Camera) */
+        ProcessFailures, /*!< Processes that failed to start */
+        SpotBytes,       /*!< Bytes received by the Spot FileUpdater */
+        SpotTransferMs,  /*!< Time spent receiving them */
+        SlideBytes,      /*!< Bytes received by the Slide FileUpdater */
+        SlideTransferMs, /*!< Time spent receiving them */
+        nCounters
+    };
+    /*!
+     * \brief The histogram enum The Panel time histograms (in us)
+     */
+    enum histogram {
+        ParseTime,/*!< From the message arrival to the updated score model */
+        PaintTime,/*!< From the executed message to the repainted window */
+        nHistograms
+    };
+    static const int nBuckets = 10;
+
+public:
+    /*!
+     * \brief add Lock free: safe (and cheap) from any thread
+     */
+    static inline void add(counter c, qint64 n = 1) {
+        counters[c].fetchAndAddRelaxed(n);
+    }
+    static void sample(histogram h, qint64 us);
+    static qint64 value(counter c);
+    static QString snapshot();
+
+private:
+    static QString histogramString(histogram h);
+    static QString transferString(counter bytes, counter ms);
+
+private:
+    static QAtomicInteger<qint64> counters[nCounters];
+    static QAtomicInteger<qint64> buckets[nHistograms][nBuckets];
+};
+
+#endif // METRICS_H
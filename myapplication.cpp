@@ -26,10 +26,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "myapplication.h"
 #include "serverdiscoverer.h"
 #include "messagewindow.h"
+#include "networkwatcher.h"
 #include "utility.h"
+#include "asynclogger.h"
+#include "binarylog.h"
 
 
 #define NETWORK_CHECK_TIME    3000 // In msec
+#define NETWORK_SAFETY_TIME  30000 // In msec (when the kernel notifies the changes)
 
 /*!
  * \brief MyApplication::MyApplication The client part of the ScorePanel System.
@@ -47,6 +51,8 @@ MyApplication::MyApplication(int& argc, char ** argv)
     , logFile(Q_NULLPTR)
     , pServerDiscoverer(Q_NULLPTR)
     , pNoNetWindow(Q_NULLPTR)
+    , pNetworkWatcher(Q_NULLPTR)
+    , bWaitingNetwork(true)
 {
     pSettings = new QSettings("Gabriele Salvato", "Score Panel");
     sLanguage = pSettings->value("language/current",  QString("Italiano")).toString();
@@ -72,6 +78,10 @@ MyApplication::MyApplication(int& argc, char ** argv)
     connect(&networkReadyTimer, SIGNAL(timeout()),
             this, SLOT(onTimeToCheckNetwork()));
 
+    // The pending log messages have to be written before leaving
+    connect(this, SIGNAL(aboutToQuit()),
+            this, SLOT(onAboutToQuit()));
+
     // On Android, no Log Files !
     #ifndef Q_OS_ANDROID
         QString sBaseDir;
@@ -79,6 +89,21 @@ MyApplication::MyApplication(int& argc, char ** argv)
         if(!sBaseDir.endsWith(QString("/"))) sBaseDir+= QString("/");
         logFileName = QString("%1score_panel.txt").arg(sBaseDir);
         PrepareLogFile();
+    #ifdef LOG_BINARY
+        // The previous run is kept: it could be the one that crashed
+        QString sBinaryLogName = QString("%1score_panel_log.bin").arg(sBaseDir);
+        AsyncLogger::rotate(sBinaryLogName, 1);
+        if(!BinaryLog::open(sBinaryLogName)) {
+            logMessage(logFile,
+                       Q_FUNC_INFO,
+                       QString("Unable to open %1").arg(sBinaryLogName));
+        }
+    #endif
+        // Without a binary log the last events are kept in memory
+        // and saved on a crash, on ESC or on <dumpTrace>
+        if(!BinaryLog::isOpen())
+            BinaryLog::openMemory();
+        BinaryLog::installCrashHandler(QString("%1score_panel_flight.bin").arg(sBaseDir));
     #endif
 
     // Create a message window
@@ -94,8 +119,17 @@ MyApplication::MyApplication(int& argc, char ** argv)
 
     // When the network becomes available we will start the
     // "PanelServer Discovery Service".
-    // Let's start the periodic check for the network
-    networkReadyTimer.start(NETWORK_CHECK_TIME);
+    // The kernel tells us when the network changes...
+    pNetworkWatcher = new NetworkWatcher(logFile, this);
+    connect(pNetworkWatcher, SIGNAL(networkChanged()),
+            this, SLOT(onNetworkChanged()));
+    if(!pNetworkWatcher->start()) {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("No network notifications: polling the interfaces"));
+    }
+    // ...otherwise let's start the periodic check for the network
+    startNetworkPolling();
 
     // And now it is time to check if the Network
     // is already up and working
@@ -120,9 +154,10 @@ MyApplication::onTimeToCheckNetwork() {
             // The network connection went down.
             pNoNetWindow->setDisplayedText(tr("Errore: Server Discovery Non Avviato"));
             // then restart checking...
-            networkReadyTimer.start(NETWORK_CHECK_TIME);
+            startNetworkPolling();
         }
         else {
+            bWaitingNetwork = false;
             delete pNoNetWindow;
             pNoNetWindow = Q_NULLPTR;
         }
@@ -133,10 +168,40 @@ MyApplication::onTimeToCheckNetwork() {
         pNoNetWindow->setDisplayedText(tr("In Attesa della Connessione con la Rete"));
         // No other window should obscure this one
         pNoNetWindow->showFullScreen();
+        // and keep checking
+        startNetworkPolling();
     }
 }
 
 
+/*!
+ * \brief MyApplication::startNetworkPolling Start the fallback periodic network check
+ *
+ * With the kernel notifications active the polling is only
+ * a safety net, so it runs much less often.
+ */
+void
+MyApplication::startNetworkPolling() {
+    if(pNetworkWatcher && pNetworkWatcher->isActive())
+        networkReadyTimer.start(NETWORK_SAFETY_TIME);
+    else
+        networkReadyTimer.start(NETWORK_CHECK_TIME);
+}
+
+
+/*!
+ * \brief MyApplication::onNetworkChanged Invoked when the kernel notifies a network change
+ *
+ * Checked only while waiting for the network: once the
+ * discovery started, it is the discoverer that reports the problems.
+ */
+void
+MyApplication::onNetworkChanged() {
+    if(bWaitingNetwork)
+        onTimeToCheckNetwork();
+}
+
+
 /*!
  * \brief MyApplication::onRecheckNetwork Invoked when the Server disconnect
  *
@@ -151,7 +216,9 @@ MyApplication::onRecheckNetwork() {
     pNoNetWindow->setDisplayedText(tr("In Attesa della Connessione con la Rete"));
     // No other window should obscure this one
     pNoNetWindow->showFullScreen();
-    networkReadyTimer.start(NETWORK_CHECK_TIME);
+    bWaitingNetwork = true;
+    // The network may well be still up: check it now
+    onTimeToCheckNetwork();
 }
 
 
@@ -174,13 +241,17 @@ MyApplication::isConnectedToNetwork() {
            iface.flags().testFlag(QNetworkInterface::CanMulticast) &&
           !iface.flags().testFlag(QNetworkInterface::IsLoopBack))
         {
-            for(int j=0; j<iface.addressEntries().count(); j++) {
-                // we have an interface that is up, and has an ip address
-                // therefore the link is present
-                if(result == false)
+            // The discovery is IPv4 multicast: an IPv4 address is needed
+            QList<QNetworkAddressEntry> entries = iface.addressEntries();
+            for(int j=0; j<entries.count(); j++) {
+                if(entries.at(j).ip().protocol() == QAbstractSocket::IPv4Protocol) {
                     result = true;
+                    break;
+                }
             }
         }
+        if(result)
+            break;
     }
 #ifdef LOG_VERBOSE
     logMessage(logFile,
@@ -197,15 +268,15 @@ MyApplication::isConnectedToNetwork() {
  *
  * This function create the file only if enabled at compilation time
  * by defining the macro LOG_MSG.
+ * The previous logs are kept as logFileName.1 ... logFileName.n and the
+ * file is written by an AsyncLogger that rotates it when it grows too big.
  */
 bool
 MyApplication::PrepareLogFile() {
 #ifdef LOG_MESG
     QFileInfo checkFile(logFileName);
     if(checkFile.exists() && checkFile.isFile()) {
-        QDir renamed;
-        renamed.remove(logFileName+QString(".bkp"));
-        renamed.rename(logFileName, logFileName+QString(".bkp"));
+        AsyncLogger::rotate(logFileName, AsyncLogger::keptFiles);
     }
     logFile = new QFile(logFileName);
     if (!logFile->open(QIODevice::WriteOnly)) {
@@ -215,6 +286,17 @@ MyApplication::PrepareLogFile() {
         delete logFile;
         logFile = Q_NULLPTR;
     }
+    else
+        AsyncLogger::startLogging(logFile);
 #endif
     return true;
 }
+
+
+/*!
+ * \brief MyApplication::onAboutToQuit Writes the log messages still queued
+ */
+void
+MyApplication::onAboutToQuit() {
+    AsyncLogger::stopLogging();
+}
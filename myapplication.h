@@ -27,6 +27,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 QT_FORWARD_DECLARE_CLASS(QSettings)
 QT_FORWARD_DECLARE_CLASS(ServerDiscoverer)
 QT_FORWARD_DECLARE_CLASS(MessageWindow)
+QT_FORWARD_DECLARE_CLASS(NetworkWatcher)
 QT_FORWARD_DECLARE_CLASS(QFile)
 
 
@@ -40,10 +41,13 @@ public:
 private slots:
     void onTimeToCheckNetwork();
     void onRecheckNetwork();
+    void onNetworkChanged();
+    void onAboutToQuit();
 
 private:
     bool isConnectedToNetwork();
     bool PrepareLogFile();
+    void startNetworkPolling();
 
 public:
     QTranslator        Translator;
@@ -53,6 +57,8 @@ private:
     QFile             *logFile;
     ServerDiscoverer  *pServerDiscoverer;
     MessageWindow     *pNoNetWindow;
+    NetworkWatcher    *pNetworkWatcher;
+    bool               bWaitingNetwork;
     QString            sLanguage;
     QString            logFileName;
     QTimer             networkReadyTimer;
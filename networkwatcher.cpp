@@ -0,0 +1,164 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QSocketNotifier>
+
+#if defined(Q_OS_LINUX) & !defined(Q_OS_ANDROID)
+    #include <sys/socket.h>
+    #include <linux/netlink.h>
+    #include <linux/rtnetlink.h>
+    #include <unistd.h>
+    #include <errno.h>
+    #include <string.h>
+#endif
+
+#include "networkwatcher.h"
+#include "utility.h"
+
+
+/*!
+ * \brief NetworkWatcher::NetworkWatcher Kernel notifications of network changes
+ * \param myLogFile The File for message logging (if any)
+ * \param parent
+ *
+ * It listens to the rtnetlink link and address groups, so the
+ * network state can be checked as soon as something changes
+ * instead of polling the interfaces.
+ */
+NetworkWatcher::NetworkWatcher(QFile *myLogFile, QObject *parent)
+    : QObject(parent)
+    , logFile(myLogFile)
+    , netlinkSocket(-1)
+    , pNotifier(Q_NULLPTR)
+{
+}
+
+
+/*!
+ * \brief NetworkWatcher::~NetworkWatcher
+ */
+NetworkWatcher::~NetworkWatcher() {
+    if(pNotifier)
+        pNotifier->setEnabled(false);
+#if defined(Q_OS_LINUX) & !defined(Q_OS_ANDROID)
+    if(netlinkSocket >= 0)
+        ::close(netlinkSocket);
+#endif
+}
+
+
+/*!
+ * \brief NetworkWatcher::start Subscribe to the kernel notifications
+ * \return false if the notifications are not available (the caller has to poll)
+ */
+bool
+NetworkWatcher::start() {
+#if defined(Q_OS_LINUX) & !defined(Q_OS_ANDROID)
+    if(netlinkSocket >= 0)
+        return true;
+    netlinkSocket = socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if(netlinkSocket < 0) {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Unable to open the netlink socket: %1").arg(strerror(errno)));
+        return false;
+    }
+    struct sockaddr_nl address;
+    memset(&address, 0, sizeof(address));
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+    if(bind(netlinkSocket, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) < 0) {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Unable to bind the netlink socket: %1").arg(strerror(errno)));
+        ::close(netlinkSocket);
+        netlinkSocket = -1;
+        return false;
+    }
+    pNotifier = new QSocketNotifier(netlinkSocket, QSocketNotifier::Read, this);
+    connect(pNotifier, SIGNAL(activated(QSocketDescriptor,QSocketNotifier::Type)),
+            this, SLOT(onNetlinkMessage()));
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+/*!
+ * \brief NetworkWatcher::isActive
+ * \return true if the kernel notifications are being received
+ */
+bool
+NetworkWatcher::isActive() {
+    return netlinkSocket >= 0;
+}
+
+
+/*!
+ * \brief NetworkWatcher::onNetlinkMessage Read all the pending notifications
+ *
+ * A burst of notifications (e.g. a DHCP lease) gives a single networkChanged().
+ */
+void
+NetworkWatcher::onNetlinkMessage() {
+#if defined(Q_OS_LINUX) & !defined(Q_OS_ANDROID)
+    bool bChanged = false;
+    char buffer[8192];
+    for(;;) {
+        ssize_t len = recv(netlinkSocket, buffer, sizeof(buffer), 0);
+        if(len < 0) {
+            if(errno == ENOBUFS)// Notifications lost: check anyway
+                bChanged = true;
+            else if(errno != EAGAIN && errno != EINTR)
+                logMessage(logFile,
+                           Q_FUNC_INFO,
+                           QString("netlink error: %1").arg(strerror(errno)));
+            if(errno == EINTR || errno == ENOBUFS)
+                continue;
+            break;
+        }
+        if(len == 0)
+            break;
+        int remaining = int(len);
+        for(struct nlmsghdr* pHeader = reinterpret_cast<struct nlmsghdr*>(buffer);
+            NLMSG_OK(pHeader, remaining);
+            pHeader = NLMSG_NEXT(pHeader, remaining))
+        {
+            switch(pHeader->nlmsg_type) {
+            case RTM_NEWLINK:
+            case RTM_DELLINK:
+            case RTM_NEWADDR:
+            case RTM_DELADDR:
+                bChanged = true;
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    if(bChanged) {
+#ifdef LOG_VERBOSE
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Network changed"));
+#endif
+        emit networkChanged();
+    }
+#endif
+}
@@ -0,0 +1,51 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef NETWORKWATCHER_H
+#define NETWORKWATCHER_H
+
+#include <QObject>
+
+
+QT_FORWARD_DECLARE_CLASS(QFile)
+QT_FORWARD_DECLARE_CLASS(QSocketNotifier)
+
+
+class NetworkWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    NetworkWatcher(QFile *myLogFile = Q_NULLPTR, QObject *parent = Q_NULLPTR);
+    ~NetworkWatcher();
+    bool start();
+    bool isActive();
+
+signals:
+    void networkChanged();/*!< A link or an address has been added, removed or changed */
+
+private slots:
+    void onNetlinkMessage();
+
+private:
+    QFile*           logFile;
+    int              netlinkSocket;
+    QSocketNotifier* pNotifier;
+};
+
+#endif // NETWORKWATCHER_H
@@ -19,15 +19,6 @@
 #
 #-------------------------------------------------
 
-QT += core
-QT += gui
-QT += websockets
-QT += serialport
-QT += widgets
-contains(QMAKE_HOST.arch, "armv7l") || contains(QMAKE_HOST.arch, "armv6l"): {
-    QT += dbus
-}
-
 CONFIG += c++11
 
 Linux {
@@ -56,39 +47,9 @@ DEFINES += QT_DEPRECATED_WARNINGS
 DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 
-SOURCES += main.cpp
-SOURCES += myapplication.cpp
-SOURCES += timeoutwindow.cpp
-SOURCES += messagewindow.cpp
-SOURCES += scorepanel.cpp
-SOURCES += segnapuntibasket.cpp
-SOURCES += segnapuntivolley.cpp
-SOURCES += segnapuntihandball.cpp
-SOURCES += serverdiscoverer.cpp
-SOURCES += fileupdater.cpp
-SOURCES += utility.cpp
-SOURCES += timedscorepanel.cpp
-contains(QMAKE_HOST.arch, "x86_64") {
-    SOURCES += slidewindow.cpp
-}
+include(scorepanel.pri)
 
-
-HEADERS += myapplication.h
-HEADERS += build_number.h
-HEADERS += timeoutwindow.h
-HEADERS += messagewindow.h
-HEADERS += scorepanel.h
-HEADERS += segnapuntibasket.h
-HEADERS += segnapuntivolley.h
-HEADERS += segnapuntihandball.h
-HEADERS += serverdiscoverer.h
-HEADERS += fileupdater.h
-HEADERS += utility.h
-HEADERS += timedscorepanel.h
-HEADERS += panelorientation.h
-contains(QMAKE_HOST.arch, "x86_64") {
-    HEADERS += slidewindow.h
-}
+SOURCES += main.cpp
 
 
 CONFIG += mobility
@@ -100,10 +61,6 @@ message("Present Build: " $$cat(../scoreController/build_number))
 
 contains(QMAKE_HOST.arch, "armv7l") || contains(QMAKE_HOST.arch, "armv6l"): {
     message("Running on Raspberry: Including Camera libraries")
-    DBUS_INTERFACES += slidewindow.xml
-    CONFIG += c++11
-    INCLUDEPATH += /usr/local/include
-    LIBS += -L"/usr/local/lib" -lpigpiod_if2 # To include libpigpiod_if2.so from /usr/local/lib
 }
 
 
@@ -123,7 +80,4 @@ DISTFILES += \
     build_number.sh \
     build_number \
 
-RESOURCES += \
-    panelchooser.qrc
-
 ANDROID_PACKAGE_SOURCE_DIR = $$PWD/android
@@ -0,0 +1,325 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include "panelsession.h"
+#include "binarylog.h"
+#include "sessionpolicy.h"
+#include "utility.h"
+
+
+/*!
+ * \brief PanelSession::PanelSession The session of a Panel with its Server
+ * \param myServerUrl The Panel Server to connect to
+ * \param myClientName The name sent with the snapshot request
+ * \param myLogFile The File for message logging (if any)
+ * \param parent
+ *
+ * Owns the WebSocket and keeps it alive following sessionpolicy.h:
+ * the status snapshot is asked upon every connection, the Server
+ * liveness is checked with pings (any message received counts as
+ * well) and a lost connection is reopened in background with an
+ * exponential backoff, for at most RESUME_TIMEOUT.
+ * The socket object is never replaced, so the connections made
+ * to it by the users stay valid across the resumes.
+ * It has no widgets: ScorePanel, HeadlessPanel and the simulated
+ * Panels of tools/loadtest share it.
+ */
+PanelSession::PanelSession(QString myServerUrl, QString myClientName, QFile *myLogFile, QObject *parent)
+    : QObject(parent)
+    , logFile(myLogFile)
+    , sServerUrl(myServerUrl)
+    , sClientName(myClientName)
+    , bStillConnected(false)
+    , bResuming(false)
+    , resumeDelay(RESUME_FIRST_DELAY)
+    , lastPingRtt(-1)
+{
+    pSocket = new QWebSocket(QString(), QWebSocketProtocol::VersionLatest, this);
+
+    connect(pSocket, SIGNAL(connected()),
+            this, SLOT(onConnected()));
+    connect(pSocket, SIGNAL(disconnected()),
+            this, SLOT(onDisconnected()));
+    connect(pSocket, SIGNAL(error(QAbstractSocket::SocketError)),
+            this, SLOT(onSocketError(QAbstractSocket::SocketError)));
+    connect(pSocket, SIGNAL(textMessageReceived(QString)),
+            this, SLOT(onTextMessageReceived(QString)));
+    connect(pSocket, SIGNAL(pong(quint64,QByteArray)),
+            this, SLOT(onPong(quint64,QByteArray)));
+    // To silent some warnings
+    pSocket->ignoreSslErrors();
+
+    connect(&refreshTimer, SIGNAL(timeout()),
+            this, SLOT(onTimeToRefreshStatus()));
+    // A lost connection is reopened in background (see suspend())
+    resumeTimer.setSingleShot(true);
+    connect(&resumeTimer, SIGNAL(timeout()),
+            this, SLOT(onTimeToResume()));
+}
+
+
+/*!
+ * \brief PanelSession::~PanelSession
+ */
+PanelSession::~PanelSession() {
+    refreshTimer.stop();
+    resumeTimer.stop();
+    pSocket->disconnect();
+    pSocket->abort();
+}
+
+
+/*!
+ * \brief PanelSession::socket
+ * \return The WebSocket to talk with the Server
+ */
+QWebSocket*
+PanelSession::socket() {
+    return pSocket;
+}
+
+
+/*!
+ * \brief PanelSession::open Connect to the Server
+ *
+ * Used also to start a new session after sessionLost()
+ */
+void
+PanelSession::open() {
+    bResuming = false;
+    resumeTimer.stop();
+    pSocket->open(QUrl(sServerUrl));
+}
+
+
+/*!
+ * \brief PanelSession::close End the session for good
+ * \param sReason Sent to the Server (if still connected)
+ *
+ * All the connections to the socket are removed: nothing
+ * will be received anymore.
+ */
+void
+PanelSession::close(QString sReason) {
+    refreshTimer.stop();
+    resumeTimer.stop();
+    bResuming = false;
+    pSocket->disconnect();
+    if(pSocket->isValid())
+        pSocket->close(QWebSocketProtocol::CloseCodeNormal, sReason);
+    else
+        pSocket->abort();
+}
+
+
+/*!
+ * \brief PanelSession::isResuming
+ * \return true while a lost connection is being reopened
+ */
+bool
+PanelSession::isResuming() {
+    return bResuming;
+}
+
+
+/*!
+ * \brief PanelSession::lastRtt
+ * \return The last ping round trip time (ms) or -1 if not yet known
+ */
+qint64
+PanelSession::lastRtt() {
+    return lastPingRtt;
+}
+
+
+/*!
+ * \brief PanelSession::onConnected Ask the Server for the present status
+ *
+ * A single snapshot brings the Panel up to date
+ */
+void
+PanelSession::onConnected() {
+    bool bResumed = bResuming;
+    if(bResuming) {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Session resumed after %1ms").arg(suspendedTime.elapsed()));
+        bResuming = false;
+        resumeTimer.stop();
+    }
+    QString sMessage = QString("<getStatus>%1</getStatus>").arg(sClientName);
+    qint64 bytesSent = pSocket->sendTextMessage(sMessage);
+    if(bytesSent != sMessage.length()) {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Unable to ask the initial status"));
+    }
+    bStillConnected = false;
+    refreshTimer.start(rand()%PING_JITTER+PING_MIN_INTERVAL);
+    emit sessionStarted(bResumed);
+}
+
+
+/*!
+ * \brief PanelSession::onDisconnected
+ */
+void
+PanelSession::onDisconnected() {
+#ifdef LOG_VERBOSE
+    logMessage(logFile,
+               Q_FUNC_INFO,
+               QString("Panel Server Disconnected"));
+#endif
+    suspend();
+}
+
+
+/*!
+ * \brief PanelSession::onSocketError
+ * \param error
+ */
+void
+PanelSession::onSocketError(QAbstractSocket::SocketError error) {
+#ifdef LOG_VERBOSE
+    logMessage(logFile,
+               Q_FUNC_INFO,
+               QString("%1 Error %2")
+               .arg(pSocket->errorString())
+               .arg(error));
+#else
+    Q_UNUSED(error)
+#endif
+    suspend();
+}
+
+
+/*!
+ * \brief PanelSession::suspend The connection with the Server has been lost
+ *
+ * The users keep showing what they have while the connection is
+ * reopened in background with an exponential backoff. Only if the
+ * Server doesn't come back within RESUME_TIMEOUT sessionLost()
+ * is emitted.
+ */
+void
+PanelSession::suspend() {
+    refreshTimer.stop();
+    if(bResuming) {// A failed attempt: the next one is already scheduled
+        if(!resumeTimer.isActive())
+            resumeTimer.start(resumeDelay);
+        return;
+    }
+    logMessage(logFile,
+               Q_FUNC_INFO,
+               QString("Connection lost: resuming the session with %1").arg(sServerUrl));
+    BinaryLog::record(BinaryLog::SessionSuspended);
+    bResuming = true;
+    suspendedTime.start();
+    resumeDelay = RESUME_FIRST_DELAY;
+    resumeTimer.start(0);
+    emit sessionSuspended();
+}
+
+
+/*!
+ * \brief PanelSession::onTimeToResume Reopen the same socket toward the same Server
+ */
+void
+PanelSession::onTimeToResume() {
+    if(suspendedTime.elapsed() > RESUME_TIMEOUT) {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Unable to resume the session with %1").arg(sServerUrl));
+        bResuming = false;
+        pSocket->blockSignals(true);
+        pSocket->abort();
+        pSocket->blockSignals(false);
+        emit sessionLost();
+        return;
+    }
+    BinaryLog::record(BinaryLog::ResumeAttempt, suspendedTime.elapsed());
+#if defined(LOG_VERBOSE) && !defined(LOG_BINARY)
+    logMessage(logFile,
+               Q_FUNC_INFO,
+               QString("Trying to resume (%1ms)").arg(suspendedTime.elapsed()));
+#endif
+    // Drop the previous attempt silently: it is not a new failure
+    pSocket->blockSignals(true);
+    pSocket->abort();
+    pSocket->blockSignals(false);
+    pSocket->open(QUrl(sServerUrl));
+    // An attempt that gets no answer is abandoned as well
+    resumeTimer.start(resumeDelay);
+    resumeDelay = qMin(resumeDelay*2, RESUME_MAX_DELAY);
+}
+
+
+/*!
+ * \brief PanelSession::onTimeToRefreshStatus Periodic liveness check of the Server
+ *
+ * The Server pushes the state only when it changes, so we
+ * don't poll it: a WebSocket ping is sent instead and either
+ * its pong or any message received proves the Server alive.
+ */
+void
+PanelSession::onTimeToRefreshStatus() {
+    if(!bStillConnected) {
+#ifdef LOG_VERBOSE
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Panel Server Disconnected"));
+#endif
+        suspend();
+        return;
+    }
+    bStillConnected = false;
+    pSocket->ping();
+    refreshTimer.start(rand()%PING_JITTER+PING_MIN_INTERVAL);
+}
+
+
+/*!
+ * \brief PanelSession::onPong Invoked when the Server answers our ping
+ * \param elapsedTime The round trip time (ms)
+ * \param payload Unused
+ */
+void
+PanelSession::onPong(quint64 elapsedTime, QByteArray payload) {
+    Q_UNUSED(payload)
+    bStillConnected = true;
+    lastPingRtt = qint64(elapsedTime);
+    BinaryLog::record(BinaryLog::PingRtt, lastPingRtt);
+#if defined(LOG_VERBOSE) && !defined(LOG_BINARY)
+    logMessage(logFile,
+               Q_FUNC_INFO,
+               QString("Server RTT: %1ms").arg(lastPingRtt));
+#endif
+    emit pongReceived(lastPingRtt);
+}
+
+
+/*!
+ * \brief PanelSession::onTextMessageReceived Any message proves the Server alive
+ * \param sMessage Unused (the users have their own handlers)
+ */
+void
+PanelSession::onTextMessageReceived(QString sMessage) {
+    Q_UNUSED(sMessage)
+    bStillConnected = true;
+    refreshTimer.start(rand()%PING_JITTER+PING_MIN_INTERVAL);
+}
@@ -0,0 +1,90 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef PANELSESSION_H
+#define PANELSESSION_H
+
+#include <QObject>
+#include <QWebSocket>
+#include <QTimer>
+#include <QElapsedTimer>
+
+
+QT_FORWARD_DECLARE_CLASS(QFile)
+
+
+class PanelSession : public QObject
+{
+    Q_OBJECT
+
+public:
+    PanelSession(QString myServerUrl, QString myClientName, QFile *myLogFile, QObject *parent = Q_NULLPTR);
+    ~PanelSession();
+    QWebSocket* socket();
+    void open();
+    void close(QString sReason = QString());
+    bool isResuming();
+    qint64 lastRtt();
+
+signals:
+    /*!
+     * \brief sessionStarted The Server is connected and the snapshot has been asked
+     * \param bResumed true if a suspended session has been resumed
+     */
+    void sessionStarted(bool bResumed);
+    /*!
+     * \brief sessionSuspended The connection has been lost: it is reopened in background
+     */
+    void sessionSuspended();
+    /*!
+     * \brief sessionLost The Server didn't come back within RESUME_TIMEOUT
+     */
+    void sessionLost();
+    /*!
+     * \brief pongReceived The Server answered our ping
+     * \param rtt The round trip time (ms)
+     */
+    void pongReceived(qint64 rtt);
+
+private slots:
+    void onConnected();
+    void onDisconnected();
+    void onSocketError(QAbstractSocket::SocketError error);
+    void onTextMessageReceived(QString sMessage);
+    void onPong(quint64 elapsedTime, QByteArray payload);
+    void onTimeToRefreshStatus();
+    void onTimeToResume();
+
+private:
+    void suspend();
+
+private:
+    QFile         *logFile;
+    QString        sServerUrl;
+    QString        sClientName;
+    QWebSocket    *pSocket;
+    QTimer         refreshTimer;
+    QTimer         resumeTimer;
+    bool           bStillConnected;
+    bool           bResuming;
+    int            resumeDelay;
+    QElapsedTimer  suspendedTime;
+    qint64         lastPingRtt;
+};
+
+#endif // PANELSESSION_H
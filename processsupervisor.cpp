@@ -0,0 +1,339 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include "processsupervisor.h"
+#include "utility.h"
+#include "metrics.h"
+#include "binarylog.h"
+
+
+#define START_TIMEOUT      3000 // Time allowed to start the process
+#define QUIT_TIMEOUT       3000 // Time allowed to exit after the quit command
+#define TERMINATE_TIMEOUT  2000 // Time allowed to exit after SIGTERM
+#define KILL_TIMEOUT       2000 // Time allowed to exit after SIGKILL
+
+
+/*!
+ * \brief ProcessSupervisor::ProcessSupervisor Asynchronous life cycle of an external process
+ * \param sName The name used in the log messages
+ * \param myLogFile The File for message logging (if any)
+ * \param parent
+ *
+ * No call ever waits for the process: every transition is driven
+ * by the QProcess signals or by a timeout. A process that doesn't
+ * exit is escalated from the quit command to SIGTERM and then to SIGKILL.
+ */
+ProcessSupervisor::ProcessSupervisor(QString sName, QFile *myLogFile, QObject *parent)
+    : QObject(parent)
+    , sName(sName)
+    , nameId(BinaryLog::intern(sName))
+    , logFile(myLogFile)
+    , pProcess(Q_NULLPTR)
+    , currentState(state_Idle)
+{
+    timeoutTimer.setSingleShot(true);
+    connect(&timeoutTimer, SIGNAL(timeout()),
+            this, SLOT(onTimeout()));
+}
+
+
+/*!
+ * \brief ProcessSupervisor::~ProcessSupervisor
+ *
+ * A process still alive is left to terminate on its own,
+ * still escalated to SIGKILL, without waiting for it.
+ */
+ProcessSupervisor::~ProcessSupervisor() {
+    timeoutTimer.stop();
+    if(pProcess && pProcess->state() != QProcess::NotRunning) {
+        pProcess->disconnect(this);
+        pProcess->setParent(Q_NULLPTR);
+        connect(pProcess, SIGNAL(finished(int, QProcess::ExitStatus)),
+                pProcess, SLOT(deleteLater()));
+        pProcess->terminate();
+        QTimer::singleShot(TERMINATE_TIMEOUT, pProcess, SLOT(kill()));
+    }
+}
+
+
+/*!
+ * \brief ProcessSupervisor::runDetached Fire and forget a command (e.g. xrefresh)
+ * \param sProgram
+ * \param arguments
+ */
+void
+ProcessSupervisor::runDetached(QString sProgram, QStringList arguments) {
+    QProcess::startDetached(sProgram, arguments);
+}
+
+
+/*!
+ * \brief ProcessSupervisor::state
+ * \return The present state of the supervised process
+ */
+ProcessSupervisor::supervisorState
+ProcessSupervisor::state() {
+    return currentState;
+}
+
+
+/*!
+ * \brief ProcessSupervisor::isActive
+ * \return true if a process exists (starting, running or stopping)
+ */
+bool
+ProcessSupervisor::isActive() {
+    return currentState != state_Idle;
+}
+
+
+/*!
+ * \brief ProcessSupervisor::isRunning
+ * \return true if the process is running and has not been asked to stop
+ */
+bool
+ProcessSupervisor::isRunning() {
+    return currentState == state_Running;
+}
+
+
+/*!
+ * \brief ProcessSupervisor::process
+ * \return The supervised QProcess (for reading its output) or Q_NULLPTR
+ */
+QProcess*
+ProcessSupervisor::process() {
+    return pProcess;
+}
+
+
+/*!
+ * \brief ProcessSupervisor::setState
+ * \param newState
+ * \param timeout Time (ms) allowed in the new state (0 = forever)
+ */
+void
+ProcessSupervisor::setState(supervisorState newState, int timeout) {
+    currentState = newState;
+    BinaryLog::record(BinaryLog::ProcessState, nameId, newState);
+    if(timeout > 0)
+        timeoutTimer.start(timeout);
+    else
+        timeoutTimer.stop();
+}
+
+
+/*!
+ * \brief ProcessSupervisor::start Start the process (returns immediately)
+ * \param sProgram
+ * \param arguments
+ *
+ * started() or failedToStart() will be emitted.
+ */
+void
+ProcessSupervisor::start(QString sProgram, QStringList arguments) {
+    if(currentState != state_Idle) {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("%1 is already active").arg(sName));
+        return;
+    }
+    pProcess = new QProcess(this);
+    pProcess->setProcessChannelMode(QProcess::MergedChannels);
+    connect(pProcess, SIGNAL(started()),
+            this, SLOT(onStarted()));
+    connect(pProcess, SIGNAL(readyReadStandardOutput()),
+            this, SLOT(onReadyRead()));
+    connect(pProcess, SIGNAL(finished(int, QProcess::ExitStatus)),
+            this, SLOT(onFinished(int, QProcess::ExitStatus)));
+    connect(pProcess, SIGNAL(errorOccurred(QProcess::ProcessError)),
+            this, SLOT(onErrorOccurred(QProcess::ProcessError)));
+    setState(state_Starting, START_TIMEOUT);
+    Metrics::add(Metrics::ProcessSpawns);
+    pProcess->start(sProgram, arguments);
+}
+
+
+/*!
+ * \brief ProcessSupervisor::stop Ask the process to exit (returns immediately)
+ * \param quitCommand Written to the process stdin to ask a gentle exit (if not empty)
+ */
+void
+ProcessSupervisor::stop(QByteArray quitCommand) {
+    if(currentState == state_Starting) {
+        pProcess->kill();
+        setState(state_Killing, KILL_TIMEOUT);
+    }
+    else if(currentState == state_Running) {
+        if(!quitCommand.isEmpty()) {
+            pProcess->write(quitCommand);
+            setState(state_Quitting, QUIT_TIMEOUT);
+        }
+        else {
+            pProcess->terminate();// SIGTERM
+            setState(state_Terminating, TERMINATE_TIMEOUT);
+        }
+    }
+}
+
+
+/*!
+ * \brief ProcessSupervisor::expectExit The process has been asked to exit by other means (e.g. D-Bus)
+ *
+ * It will be escalated only if it doesn't exit in time.
+ */
+void
+ProcessSupervisor::expectExit() {
+    if(currentState == state_Running)
+        setState(state_Quitting, QUIT_TIMEOUT);
+    else if(currentState == state_Starting)
+        stop();
+}
+
+
+/*!
+ * \brief ProcessSupervisor::write Write to the process stdin
+ * \param data
+ * \return The number of bytes written or -1
+ */
+qint64
+ProcessSupervisor::write(const QByteArray& data) {
+    if(currentState != state_Starting && currentState != state_Running)
+        return -1;
+    return pProcess->write(data);// Buffered while starting
+}
+
+
+/*!
+ * \brief ProcessSupervisor::onStarted
+ */
+void
+ProcessSupervisor::onStarted() {
+    if(currentState != state_Starting)
+        return;
+    setState(state_Running, 0);
+    BinaryLog::record(BinaryLog::ProcessStarted, nameId);
+#if defined(LOG_VERBOSE) && !defined(LOG_BINARY)
+    logMessage(logFile,
+               Q_FUNC_INFO,
+               QString("%1 started").arg(sName));
+#endif
+    emit started();
+}
+
+
+/*!
+ * \brief ProcessSupervisor::onReadyRead
+ *
+ * The output nobody is interested in is discarded
+ * to avoid its accumulation.
+ */
+void
+ProcessSupervisor::onReadyRead() {
+    if(receivers(SIGNAL(readyRead())) == 0)
+        pProcess->readAll();
+    else
+        emit readyRead();
+}
+
+
+/*!
+ * \brief ProcessSupervisor::onTimeout Escalate a process that doesn't react
+ */
+void
+ProcessSupervisor::onTimeout() {
+    switch(currentState) {
+    case state_Starting:
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("%1 did not start in time").arg(sName));
+        pProcess->kill();
+        setState(state_Killing, KILL_TIMEOUT);
+        emit failedToStart();
+        break;
+    case state_Quitting:
+        pProcess->terminate();
+        setState(state_Terminating, TERMINATE_TIMEOUT);
+        break;
+    case state_Terminating:
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("%1 ignored SIGTERM: killing it").arg(sName));
+        pProcess->kill();
+        setState(state_Killing, KILL_TIMEOUT);
+        break;
+    case state_Killing:
+        // Not even SIGKILL: forget it without waiting
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("%1 can't be killed").arg(sName));
+        pProcess->disconnect(this);
+        pProcess->setParent(Q_NULLPTR);
+        connect(pProcess, SIGNAL(finished(int, QProcess::ExitStatus)),
+                pProcess, SLOT(deleteLater()));
+        pProcess = Q_NULLPTR;
+        setState(state_Idle, 0);
+        emit finished(-1, QProcess::CrashExit);
+        break;
+    default:
+        break;
+    }
+}
+
+
+/*!
+ * \brief ProcessSupervisor::onFinished
+ * \param exitCode
+ * \param exitStatus
+ */
+void
+ProcessSupervisor::onFinished(int exitCode, QProcess::ExitStatus exitStatus) {
+    BinaryLog::record(BinaryLog::ProcessExited, nameId, exitCode);
+#if defined(LOG_VERBOSE) && !defined(LOG_BINARY)
+    logMessage(logFile,
+               Q_FUNC_INFO,
+               QString("%1 exited with code %2").arg(sName).arg(exitCode));
+#endif
+    pProcess->disconnect(this);
+    pProcess->deleteLater();
+    pProcess = Q_NULLPTR;
+    setState(state_Idle, 0);
+    emit finished(exitCode, exitStatus);
+}
+
+
+/*!
+ * \brief ProcessSupervisor::onErrorOccurred
+ * \param error
+ */
+void
+ProcessSupervisor::onErrorOccurred(QProcess::ProcessError error) {
+    if(error != QProcess::FailedToStart)
+        return;// The other errors are followed by finished()
+    Metrics::add(Metrics::ProcessFailures);
+    logMessage(logFile,
+               Q_FUNC_INFO,
+               QString("Unable to start %1: %2")
+               .arg(sName)
+               .arg(pProcess->errorString()));
+    pProcess->disconnect(this);
+    pProcess->deleteLater();
+    pProcess = Q_NULLPTR;
+    setState(state_Idle, 0);
+    emit failedToStart();
+}
@@ -0,0 +1,86 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef PROCESSSUPERVISOR_H
+#define PROCESSSUPERVISOR_H
+
+#include <QObject>
+#include <QProcess>
+#include <QTimer>
+#include <QStringList>
+
+
+QT_FORWARD_DECLARE_CLASS(QFile)
+
+
+class ProcessSupervisor : public QObject
+{
+    Q_OBJECT
+
+public:
+    ProcessSupervisor(QString sName, QFile *myLogFile = Q_NULLPTR, QObject *parent = Q_NULLPTR);
+    ~ProcessSupervisor();
+    void start(QString sProgram, QStringList arguments = QStringList());
+    void stop(QByteArray quitCommand = QByteArray());
+    void expectExit();
+    qint64 write(const QByteArray& data);
+    bool isActive();
+    bool isRunning();
+    QProcess* process();
+    static void runDetached(QString sProgram, QStringList arguments = QStringList());
+
+public:
+    /*!
+     * \brief The supervisorState enum The life cycle of the supervised process
+     */
+    enum supervisorState {
+        state_Idle,       /*!< No process */
+        state_Starting,   /*!< start() called, waiting for started() */
+        state_Running,    /*!< The process is running */
+        state_Quitting,   /*!< The quit command has been sent */
+        state_Terminating,/*!< SIGTERM has been sent */
+        state_Killing     /*!< SIGKILL has been sent */
+    };
+    supervisorState state();
+
+signals:
+    void started();
+    void readyRead();/*!< New output (stdout and stderr merged) is available */
+    void failedToStart();
+    void finished(int exitCode, QProcess::ExitStatus exitStatus);
+
+private slots:
+    void onStarted();
+    void onReadyRead();
+    void onFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void onErrorOccurred(QProcess::ProcessError error);
+    void onTimeout();
+
+private:
+    void setState(supervisorState newState, int timeout);
+
+private:
+    QString         sName;
+    quint16         nameId;
+    QFile*          logFile;
+    QProcess*       pProcess;
+    QTimer          timeoutTimer;
+    supervisorState currentState;
+};
+
+#endif // PROCESSSUPERVISOR_H
@@ -0,0 +1,213 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QDir>
+#include <QFileInfo>
+
+#include "protocolcapture.h"
+#include "utility.h"
+
+
+#define CAPTURE_MAGIC   0x53504331 // "SPC1"
+#define CAPTURE_VERSION 1
+#define FLUSH_INTERVAL  1000       // In msec
+
+
+/*!
+ * \brief ProtocolCapture::ProtocolCapture Records (and reads back) the Server messages
+ * \param myLogFile
+ *
+ * The file starts with a magic number, the format version and the
+ * panel type; then every message is stored as its arrival time (us
+ * since the start), its kind (text or binary) and its bytes.
+ * It is written with QDataStream, so it is portable across the
+ * Panel architectures.
+ */
+ProtocolCapture::ProtocolCapture(QFile *myLogFile)
+    : logFile(myLogFile)
+    , lastFlush(0)
+    , iPanelType(-1)
+    , bRecording(false)
+{
+    stream.setVersion(QDataStream::Qt_5_12);
+}
+
+
+/*!
+ * \brief ProtocolCapture::~ProtocolCapture
+ */
+ProtocolCapture::~ProtocolCapture() {
+    stop();
+}
+
+
+/*!
+ * \brief ProtocolCapture::start Start recording
+ * \param sFileName The capture file (an old one is kept as .bkp)
+ * \param myPanelType The type of the recording Panel
+ * \return true if the file could be created
+ */
+bool
+ProtocolCapture::start(QString sFileName, int myPanelType) {
+    stop();
+    QFileInfo checkFile(sFileName);
+    if(checkFile.exists() && checkFile.isFile()) {
+        QDir renamed;
+        renamed.remove(sFileName+QString(".bkp"));
+        renamed.rename(sFileName, sFileName+QString(".bkp"));
+    }
+    file.setFileName(sFileName);
+    if(!file.open(QIODevice::WriteOnly)) {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Unable to create %1: %2")
+                   .arg(sFileName, file.errorString()));
+        return false;
+    }
+    stream.setDevice(&file);
+    iPanelType = myPanelType;
+    stream << quint32(CAPTURE_MAGIC) << quint32(CAPTURE_VERSION) << qint32(iPanelType);
+    clock.start();
+    lastFlush = 0;
+    bRecording = true;
+    return true;
+}
+
+
+/*!
+ * \brief ProtocolCapture::stop Close the capture file (if open)
+ */
+void
+ProtocolCapture::stop() {
+    bRecording = false;
+    stream.setDevice(Q_NULLPTR);
+    if(file.isOpen())
+        file.close();
+}
+
+
+/*!
+ * \brief ProtocolCapture::isActive
+ * \return true while recording
+ */
+bool
+ProtocolCapture::isActive() {
+    return bRecording;
+}
+
+
+/*!
+ * \brief ProtocolCapture::addText Record a text message
+ */
+void
+ProtocolCapture::addText(const QString& sMessage) {
+    if(bRecording)
+        add(TextMessage, sMessage.toUtf8());
+}
+
+
+/*!
+ * \brief ProtocolCapture::addBinary Record a binary message
+ */
+void
+ProtocolCapture::addBinary(const QByteArray& baMessage) {
+    if(bRecording)
+        add(BinaryMessage, baMessage);
+}
+
+
+/*!
+ * \brief ProtocolCapture::add
+ *
+ * Flushed at most once a second to keep the message path cheap.
+ */
+void
+ProtocolCapture::add(quint8 kind, const QByteArray& baPayload) {
+    qint64 nowUs = clock.nsecsElapsed()/1000;
+    stream << qint64(nowUs) << kind << baPayload;
+    if(stream.status() != QDataStream::Ok) {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Error writing %1: capture stopped").arg(file.fileName()));
+        stop();
+        return;
+    }
+    if(nowUs/1000-lastFlush > FLUSH_INTERVAL) {
+        file.flush();
+        lastFlush = nowUs/1000;
+    }
+}
+
+
+/*!
+ * \brief ProtocolCapture::open Open a capture file for replay
+ * \param sFileName
+ * \return false if the file is missing or it is not a capture
+ */
+bool
+ProtocolCapture::open(QString sFileName) {
+    stop();
+    file.setFileName(sFileName);
+    if(!file.open(QIODevice::ReadOnly)) {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Unable to open %1: %2")
+                   .arg(sFileName, file.errorString()));
+        return false;
+    }
+    stream.setDevice(&file);
+    quint32 magic, version;
+    qint32 type;
+    stream >> magic >> version >> type;
+    if(stream.status() != QDataStream::Ok ||
+       magic != CAPTURE_MAGIC ||
+       version != CAPTURE_VERSION)
+    {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("%1 is not a capture file").arg(sFileName));
+        stop();
+        return false;
+    }
+    iPanelType = type;
+    return true;
+}
+
+
+/*!
+ * \brief ProtocolCapture::next Read the next message
+ * \param record
+ * \return false at the end of the file (a truncated last record is dropped)
+ */
+bool
+ProtocolCapture::next(captureRecord& record) {
+    if(!file.isOpen() || bRecording)
+        return false;
+    stream >> record.timeUs >> record.kind >> record.payload;
+    return stream.status() == QDataStream::Ok;
+}
+
+
+/*!
+ * \brief ProtocolCapture::panelType
+ * \return The type of the Panel that recorded the capture
+ */
+int
+ProtocolCapture::panelType() {
+    return iPanelType;
+}
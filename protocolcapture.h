@@ -0,0 +1,71 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef PROTOCOLCAPTURE_H
+#define PROTOCOLCAPTURE_H
+
+#include <QFile>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QByteArray>
+
+
+/*!
+ * \brief The captureRecord struct A message as stored in a capture file
+ */
+struct captureRecord {
+    qint64     timeUs; /*!< Microseconds since the capture start */
+    quint8     kind;   /*!< ProtocolCapture::TextMessage or BinaryMessage */
+    QByteArray payload;/*!< The message (UTF-8 for the text ones) */
+};
+
+
+class ProtocolCapture
+{
+public:
+    explicit ProtocolCapture(QFile *myLogFile = Q_NULLPTR);
+    ~ProtocolCapture();
+    // Recording
+    bool start(QString sFileName, int myPanelType);
+    void stop();
+    bool isActive();
+    void addText(const QString& sMessage);
+    void addBinary(const QByteArray& baMessage);
+    // Replay
+    bool open(QString sFileName);
+    bool next(captureRecord& record);
+    int panelType();
+
+public:
+    static const quint8 TextMessage   = 0;
+    static const quint8 BinaryMessage = 1;
+
+private:
+    void add(quint8 kind, const QByteArray& baPayload);
+
+private:
+    QFile*        logFile;
+    QFile         file;
+    QDataStream   stream;
+    QElapsedTimer clock;
+    qint64        lastFlush;
+    int           iPanelType;
+    bool          bRecording;
+};
+
+#endif // PROTOCOLCAPTURE_H
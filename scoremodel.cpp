@@ -0,0 +1,217 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include "scoremodel.h"
+#include "utility.h"
+
+
+#define IGNORE_INVALID -1000 // Invalid values leave the field untouched
+
+
+/*!
+ * \brief ScoreModel::ScoreModel The state shown by a Score Panel, without widgets
+ * \param myPanelType VOLLEY_PANEL, BASKET_PANEL or HANDBALL_PANEL
+ * \param parent
+ *
+ * It parses the Server messages and validates the values exactly
+ * as the Panels do, so that the protocol can be exercised (and
+ * measured) without a display. The Panels apply to their widgets
+ * only the fields the model reports as received.
+ */
+ScoreModel::ScoreModel(int myPanelType, QObject *parent)
+    : QObject(parent)
+    , iPanelType(myPanelType)
+{
+}
+
+
+/*!
+ * \brief ScoreModel::panelType
+ * \return The panel type the model has been built for
+ */
+int
+ScoreModel::panelType() {
+    return iPanelType;
+}
+
+
+/*!
+ * \brief ScoreModel::update Parse a Server message
+ * \param sMessage The message
+ * \return The (valid) fields found in the message
+ */
+QStringList
+ScoreModel::update(const QString& sMessage) {
+    received.clear();
+    parseText(sMessage, "team0");
+    parseText(sMessage, "team1");
+    if(iPanelType == VOLLEY_PANEL) {
+        parseInt(sMessage, "set0",     0,  3,  8);
+        parseInt(sMessage, "set1",     0,  3,  8);
+        parseInt(sMessage, "timeout0", 0,  2,  8);
+        parseInt(sMessage, "timeout1", 0,  2,  8);
+        parseInt(sMessage, "score0",   0, 99, 99);
+        parseInt(sMessage, "score1",   0, 99, 99);
+        parseInt(sMessage, "servizio",-1,  1,  0);
+    }
+    else if(iPanelType == BASKET_PANEL) {
+        parsePeriod(sMessage, 10);
+        parseInt(sMessage, "timeout0", 0,   3, IGNORE_INVALID);
+        parseInt(sMessage, "timeout1", 0,   3, IGNORE_INVALID);
+        parseInt(sMessage, "score0",   0, 999, 999);
+        parseInt(sMessage, "score1",   0, 999, 999);
+        parseFlag(sMessage, "possess");
+        parseInt(sMessage, "fauls0",   0,  99, 99);
+        parseInt(sMessage, "fauls1",   0,  99, 99);
+        parseFlag(sMessage, "bonus0");
+        parseFlag(sMessage, "bonus1");
+    }
+    else if(iPanelType == HANDBALL_PANEL) {
+        parsePeriod(sMessage, 30);
+        parseInt(sMessage, "timeout0", 0,   3, IGNORE_INVALID);
+        parseInt(sMessage, "timeout1", 0,   3, IGNORE_INVALID);
+        parseInt(sMessage, "score0",   0, 999, 999);
+        parseInt(sMessage, "score1",   0, 999, 999);
+    }
+    return received;
+}
+
+
+/*!
+ * \brief ScoreModel::parseText A (team) name
+ */
+void
+ScoreModel::parseText(const QString& sMessage, QString sField) {
+    QString sToken = XML_Parse(sMessage, sField);
+    if(sToken == QString("NoData"))
+        return;
+    texts.insert(sField, sToken.left(maxTeamNameLen));
+    received.append(sField);
+}
+
+
+/*!
+ * \brief ScoreModel::parseInt An integer in [iMin, iMax]
+ * \param iInvalid The value to show when out of range (or IGNORE_INVALID)
+ */
+void
+ScoreModel::parseInt(const QString& sMessage, QString sField, int iMin, int iMax, int iInvalid) {
+    QString sToken = XML_Parse(sMessage, sField);
+    if(sToken == QString("NoData"))
+        return;
+    bool ok;
+    int iVal = sToken.toInt(&ok);
+    if(!ok || iVal<iMin || iVal>iMax) {
+        if(iInvalid == IGNORE_INVALID)
+            return;
+        iVal = iInvalid;
+    }
+    values.insert(sField, iVal);
+    received.append(sField);
+}
+
+
+/*!
+ * \brief ScoreModel::parseFlag Any integer (zero or not)
+ */
+void
+ScoreModel::parseFlag(const QString& sMessage, QString sField) {
+    QString sToken = XML_Parse(sMessage, sField);
+    if(sToken == QString("NoData"))
+        return;
+    bool ok;
+    int iVal = sToken.toInt(&ok);
+    if(!ok)
+        return;
+    values.insert(sField, iVal);
+    received.append(sField);
+}
+
+
+/*!
+ * \brief ScoreModel::parsePeriod The "period,periodTime" pair
+ * \param iMaxPeriodTime The longest period (in minutes)
+ *
+ * A missing period time is handled as an invalid one.
+ */
+void
+ScoreModel::parsePeriod(const QString& sMessage, int iMaxPeriodTime) {
+    QString sToken = XML_Parse(sMessage, "period");
+    if(sToken == QString("NoData"))
+        return;
+    QStringList sArgs = sToken.split(",", Qt::SkipEmptyParts);
+    bool ok = false;
+    int iVal = 99;
+    if(sArgs.count() > 0)
+        iVal = sArgs.at(0).toInt(&ok);
+    if(!ok || iVal<0 || iVal>99)
+        iVal = 99;
+    values.insert("period", iVal);
+    ok = false;
+    if(sArgs.count() > 1)
+        iVal = sArgs.at(1).toInt(&ok);
+    if(!ok || iVal<0 || iVal>iMaxPeriodTime)
+        iVal = iMaxPeriodTime;
+    values.insert("periodTime", iVal);
+    received.append("period");
+}
+
+
+/*!
+ * \brief ScoreModel::value
+ * \return The value of an integer field (0 if never received)
+ */
+int
+ScoreModel::value(QString sField) {
+    return values.value(sField, 0);
+}
+
+
+/*!
+ * \brief ScoreModel::text
+ * \return The value of a text field (empty if never received)
+ */
+QString
+ScoreModel::text(QString sField) {
+    return texts.value(sField);
+}
+
+
+/*!
+ * \brief ScoreModel::snapshot
+ * \return The whole state, in the Server message format
+ */
+QString
+ScoreModel::snapshot() {
+    QString sSnapshot;
+    QMap<QString, QString>::const_iterator t;
+    for(t=texts.constBegin(); t!=texts.constEnd(); ++t)
+        sSnapshot += QString("<%1>%2</%1>").arg(t.key(), t.value());
+    QMap<QString, int>::const_iterator v;
+    for(v=values.constBegin(); v!=values.constEnd(); ++v) {
+        if(v.key() == QString("periodTime"))
+            continue;
+        if(v.key() == QString("period"))
+            sSnapshot += QString("<period>%1,%2</period>")
+                         .arg(v.value())
+                         .arg(values.value("periodTime"));
+        else
+            sSnapshot += QString("<%1>%2</%1>").arg(v.key()).arg(v.value());
+    }
+    return sSnapshot;
+}
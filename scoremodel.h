@@ -0,0 +1,55 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef SCOREMODEL_H
+#define SCOREMODEL_H
+
+#include <QObject>
+#include <QMap>
+#include <QStringList>
+
+
+class ScoreModel : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ScoreModel(int myPanelType, QObject *parent = Q_NULLPTR);
+    QStringList update(const QString& sMessage);
+    int panelType();
+    int value(QString sField);
+    QString text(QString sField);
+    QString snapshot();
+
+public:
+    static const int maxTeamNameLen = 15;
+
+private:
+    void parseText(const QString& sMessage, QString sField);
+    void parseInt(const QString& sMessage, QString sField, int iMin, int iMax, int iInvalid);
+    void parseFlag(const QString& sMessage, QString sField);
+    void parsePeriod(const QString& sMessage, int iMaxPeriodTime);
+
+private:
+    int                    iPanelType;
+    QMap<QString, int>     values;
+    QMap<QString, QString> texts;
+    QStringList            received;
+};
+
+#endif // SCOREMODEL_H
@@ -0,0 +1,209 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QPainter>
+#include <QEvent>
+#include <QSettings>
+
+#include "scoreoverlay.h"
+
+
+/*!
+ * \brief ScoreOverlay::ScoreOverlay Keeps the score visible over Spots and Slides
+ * \param pScoreSource The widget showing the score
+ *
+ * The score is rendered once per update into a cached pixmap,
+ * scaled to the overlay size. The repaints driven by the media
+ * below only blit that pixmap.
+ * The overlay moves by itself on the media widget that is shown
+ * (see addHost()).
+ */
+ScoreOverlay::ScoreOverlay(QWidget *pScoreSource)
+    : QWidget(Q_NULLPTR)
+    , pSource(pScoreSource)
+    , bEnabled(false)
+{
+    QSettings settings("Gabriele Salvato", "Score Panel");
+    heightFraction = qBound(0.1, settings.value("panel/overlayHeight", 0.25).toDouble(), 1.0);
+    opacity        = qBound(0.1, settings.value("panel/overlayOpacity", 0.85).toDouble(), 1.0);
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setAttribute(Qt::WA_NoSystemBackground);
+    hide();
+}
+
+
+/*!
+ * \brief ScoreOverlay::setSource Change the widget showing the score
+ * \param pNewSource
+ */
+void
+ScoreOverlay::setSource(QWidget *pNewSource) {
+    pSource = pNewSource;
+    refresh();
+}
+
+
+/*!
+ * \brief ScoreOverlay::addHost Add a media widget the overlay can be shown on
+ * \param pHost The media widget (usually a top level window)
+ */
+void
+ScoreOverlay::addHost(QWidget *pHost) {
+    hosts.append(QPointer<QWidget>(pHost));
+    pHost->installEventFilter(this);
+    if(bEnabled && pHost->isVisible())
+        attachTo(pHost);
+}
+
+
+/*!
+ * \brief ScoreOverlay::setOverlayMode Turn the overlay mode on or off
+ * \param bEnable
+ */
+void
+ScoreOverlay::setOverlayMode(bool bEnable) {
+    bEnabled = bEnable;
+    if(!bEnabled) {
+        detach();
+        return;
+    }
+    for(int i=0; i<hosts.count(); i++) {
+        if(hosts.at(i) && hosts.at(i)->isVisible()) {
+            attachTo(hosts.at(i));
+            return;
+        }
+    }
+}
+
+
+/*!
+ * \brief ScoreOverlay::overlayMode
+ * \return true if the overlay mode is on
+ */
+bool
+ScoreOverlay::overlayMode() {
+    return bEnabled;
+}
+
+
+/*!
+ * \brief ScoreOverlay::attachTo Show the overlay over a media widget
+ * \param pHost
+ */
+void
+ScoreOverlay::attachTo(QWidget *pHost) {
+    if(pCurrentHost != pHost) {
+        pCurrentHost = pHost;
+        setParent(pHost);
+    }
+    placeInHost();
+    show();
+    raise();
+    refresh();
+}
+
+
+/*!
+ * \brief ScoreOverlay::detach Hide the overlay
+ */
+void
+ScoreOverlay::detach() {
+    hide();
+    pCurrentHost = Q_NULLPTR;
+}
+
+
+/*!
+ * \brief ScoreOverlay::placeInHost The overlay takes the top of the host
+ */
+void
+ScoreOverlay::placeInHost() {
+    if(!pCurrentHost)
+        return;
+    int h = int(pCurrentHost->height() * heightFraction);
+    setGeometry(0, 0, pCurrentHost->width(), h);
+}
+
+
+/*!
+ * \brief ScoreOverlay::eventFilter Follow the hosts being shown, hidden or resized
+ */
+bool
+ScoreOverlay::eventFilter(QObject *pObject, QEvent *event) {
+    QWidget* pHost = qobject_cast<QWidget*>(pObject);
+    if(!bEnabled || !pHost)
+        return QWidget::eventFilter(pObject, event);
+    if(event->type() == QEvent::Show) {
+        attachTo(pHost);
+    }
+    else if(event->type() == QEvent::Hide && pHost == pCurrentHost) {
+        detach();
+        for(int i=0; i<hosts.count(); i++) {// Another host still visible ?
+            if(hosts.at(i) && hosts.at(i) != pHost && hosts.at(i)->isVisible()) {
+                attachTo(hosts.at(i));
+                break;
+            }
+        }
+    }
+    else if(event->type() == QEvent::Resize && pHost == pCurrentHost) {
+        placeInHost();
+        refresh();
+    }
+    return QWidget::eventFilter(pObject, event);
+}
+
+
+/*!
+ * \brief ScoreOverlay::refresh Render the score again in the cached pixmap
+ *
+ * The score is drawn directly at the overlay size,
+ * so no further scaling is needed when painting.
+ */
+void
+ScoreOverlay::refresh() {
+    if(!isVisible() || !pSource || width() <= 0 || height() <= 0)
+        return;
+    if(scorePixmap.size() != size())
+        scorePixmap = QPixmap(size());
+    scorePixmap.fill(Qt::black);
+    QPainter painter(&scorePixmap);
+    QSize sourceSize = pSource->size();
+    if(sourceSize.isEmpty())
+        return;
+    double scale = qMin(double(width())/sourceSize.width(),
+                        double(height())/sourceSize.height());
+    painter.translate((width()-sourceSize.width()*scale)/2.0, 0.0);
+    painter.scale(scale, scale);
+    pSource->render(&painter);
+    painter.end();
+    repaint();// Don't wait for the next video frame
+}
+
+
+/*!
+ * \brief ScoreOverlay::paintEvent Blit the cached score
+ */
+void
+ScoreOverlay::paintEvent(QPaintEvent *event) {
+    Q_UNUSED(event)
+    if(scorePixmap.isNull())
+        return;
+    QPainter painter(this);
+    painter.setOpacity(opacity);
+    painter.drawPixmap(0, 0, scorePixmap);
+}
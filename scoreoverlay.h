@@ -0,0 +1,61 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef SCOREOVERLAY_H
+#define SCOREOVERLAY_H
+
+#include <QWidget>
+#include <QPixmap>
+#include <QPointer>
+#include <QList>
+
+
+class ScoreOverlay : public QWidget
+{
+    Q_OBJECT
+
+public:
+    ScoreOverlay(QWidget *pScoreSource);
+    void setSource(QWidget *pNewSource);
+    void addHost(QWidget *pHost);
+    void setOverlayMode(bool bEnable);
+    bool overlayMode();
+
+public slots:
+    void refresh();
+
+protected:
+    void paintEvent(QPaintEvent *event);
+    bool eventFilter(QObject *pObject, QEvent *event);
+
+private:
+    void attachTo(QWidget *pHost);
+    void detach();
+    void placeInHost();
+
+private:
+    QPointer<QWidget>        pSource;
+    QList<QPointer<QWidget>> hosts;
+    QPointer<QWidget>        pCurrentHost;
+    QPixmap                  scorePixmap;
+    bool                     bEnabled;
+    double                   heightFraction;
+    double                   opacity;
+};
+
+#endif // SCOREOVERLAY_H
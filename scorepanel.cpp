@@ -37,8 +37,25 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #else
     #include "slidewindow.h"
 #endif
+#if defined(Q_PROCESSOR_ARM) & !defined(Q_OS_ANDROID)
+    #include "spotprocessplayer.h"
+#elif !defined(Q_OS_ANDROID)
+    #include "spotplayer.h"
+#endif
 
 #include "fileupdater.h"
+#include "processsupervisor.h"
+#include "mediaprobe.h"
+#include "scoreoverlay.h"
+#include "tracer.h"
+#include "protocolcapture.h"
+#include "metrics.h"
+#include "binarylog.h"
+#include "panelsession.h"
+#include "sessionpolicy.h"
+#if !defined(Q_OS_ANDROID)
+    #include "liveview.h"
+#endif
 #include "scorepanel.h"
 #include "utility.h"
 #include "panelorientation.h"
@@ -47,9 +64,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 /*! \todo Do we have to send the port numbers to use with
  * the message sent by the Server upon a connection ?
+ * (SPOT_UPDATE_PORT and SLIDE_UPDATE_PORT are in sessionpolicy.h)
  */
-#define SPOT_UPDATE_PORT      45455
-#define SLIDE_UPDATE_PORT     45456
+
+// Posted after each message: delivered after any repaint it caused
+static const QEvent::Type RepaintCheckEvent = QEvent::Type(QEvent::registerEventType());
 
 #define PAN_PIN  14 // GPIO Numbers are Broadcom (BCM) numbers
 #define TILT_PIN 26 // GPIO Numbers are Broadcom (BCM) numbers
@@ -81,9 +100,12 @@ ScorePanel::ScorePanel(const QString &serverUrl, QFile *myLogFile, QWidget *pare
     , isScoreOnly(false)
     , pPanelServerSocket(Q_NULLPTR)
     , logFile(myLogFile)
+    , pScoreModel(Q_NULLPTR)
+    , pSession(Q_NULLPTR)
     , slidePlayer(Q_NULLPTR)
-    , videoPlayer(Q_NULLPTR)
     , cameraPlayer(Q_NULLPTR)
+    , pLiveView(Q_NULLPTR)
+    , pScoreOverlay(Q_NULLPTR)
     , panPin(PAN_PIN)  // BCM14 is Pin  8 in the 40 pin GPIO connector.
     , tiltPin(TILT_PIN)// BCM26 IS Pin 37 in the 40 pin GPIO connector.
     , gpioHostHandle(-1)
@@ -115,6 +137,19 @@ ScorePanel::ScorePanel(const QString &serverUrl, QFile *myLogFile, QWidget *pare
 #endif
     if(!sBaseDir.endsWith(QString("/"))) sBaseDir+= QString("/");
 
+    // Score update tracing (saved on request)
+    pTracer = new Tracer(logFile);
+    sTraceFile = QString("%1score_panel_trace.json").arg(sBaseDir);
+
+    // Capture of the Server messages (for tools/replay)
+    pCapture = new ProtocolCapture(logFile);
+    bCaptureEnabled = pSettings->value("capture/enabled", false).toBool();
+    sCaptureFile = QString("%1score_panel_capture.bin").arg(sBaseDir);
+
+    // Message rate between two <getMetrics>
+    lastMetricsMessages = 0;
+    metricsTime.start();
+
     // Spot management
     pSpotUpdaterThread = Q_NULLPTR;
     pSpotUpdater       = Q_NULLPTR;
@@ -144,45 +179,67 @@ ScorePanel::ScorePanel(const QString &serverUrl, QFile *myLogFile, QWidget *pare
              QDBusConnection::sessionBus(),   // Bus
              this);
 
-    slidePlayer = new QProcess(this);
+    slidePlayer = new ProcessSupervisor(QString("Slide Show"), logFile, this);
     connect(slidePlayer, SIGNAL(finished(int, QProcess::ExitStatus)),
             this, SLOT(onSlideShowClosed(int, QProcess::ExitStatus)));
     QString sHomeDir = QDir::homePath();
     if(!sHomeDir.endsWith("/")) sHomeDir += "/";
     QString sCommand = QString("%1SlideShow")
                               .arg(sHomeDir);
-    slidePlayer->start(sCommand);
-    if(!slidePlayer->waitForStarted(3000)) {
-        slidePlayer->terminate();
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Impossibile mandare lo Slide Show."));
-        delete slidePlayer;
-        slidePlayer = Q_NULLPTR;
-    }
+    slidePlayer->start(sCommand);// A failure is logged by the supervisor
+#endif
+#if !defined(Q_OS_ANDROID)
+    cameraPlayer = new ProcessSupervisor(QString("Camera"), logFile, this);
+    connect(cameraPlayer, SIGNAL(finished(int, QProcess::ExitStatus)),
+            this, SLOT(onLiveClosed(int, QProcess::ExitStatus)));
+    pLiveView = new LiveView(logFile, this);
+    connect(pLiveView, SIGNAL(closed()),
+            this, SLOT(onLiveViewClosed()));
 #endif
 #if !defined(Q_PROCESSOR_ARM) & !defined(Q_OS_ANDROID)
-    pMySlideWindow = new SlideWindow();
+    pMySlideWindow = new SlideWindow(logFile);
 #endif
 
-    // We are ready to connect to the remote Panel Server
-    pPanelServerSocket = new QWebSocket();
+    // A single Spot player for the whole session
+#if defined(Q_PROCESSOR_ARM) & !defined(Q_OS_ANDROID)
+    pSpotPlayer = new SpotProcessPlayer(logFile, this);
+#elif !defined(Q_OS_ANDROID)
+    pSpotPlayer = new SpotPlayer(logFile);
+#endif
+#if !defined(Q_OS_ANDROID)
+    pSpotPlayer->setSpotDir(sSpotDir);
+    connect(pSpotPlayer, SIGNAL(spotLoopClosed()),
+            this, SLOT(onSpotPlayerClosed()));
+#endif
 
-    connect(pPanelServerSocket, SIGNAL(connected()),
-            this, SLOT(onPanelServerConnected()));
-    connect(pPanelServerSocket, SIGNAL(disconnected()),
-            this, SLOT(onPanelServerDisconnected()));
-    connect(pPanelServerSocket, SIGNAL(error(QAbstractSocket::SocketError)),
-            this, SLOT(onPanelServerSocketError(QAbstractSocket::SocketError)));
+    // The score can stay visible over the in process Spots and Slides
+#if !defined(Q_PROCESSOR_ARM) & !defined(Q_OS_ANDROID)
+    pScoreOverlay = new ScoreOverlay(pPanel);
+    pScoreOverlay->addHost(pSpotPlayer);
+    pScoreOverlay->addHost(pMySlideWindow);
+    pScoreOverlay->setOverlayMode(pSettings->value("panel/overlay", false).toBool());
+    overlayTimer.setSingleShot(true);// Coalesce the bursts of score updates
+    connect(&overlayTimer, SIGNAL(timeout()),
+            pScoreOverlay, SLOT(refresh()));
+#endif
 
-    // To silent some warnings
-    pPanelServerSocket->ignoreSslErrors();
-    // Open the Server socket to talk to
-    pPanelServerSocket->open(QUrl(serverUrl));
+    // We are ready to connect to the remote Panel Server:
+    // the session keeps the connection alive (see PanelSession)
+    pSession = new PanelSession(serverUrl, QHostInfo::localHostName(), logFile, this);
+    pPanelServerSocket = pSession->socket();
+
+    // Connected before the derived Panels handlers to timestamp the arrival
+    connect(pPanelServerSocket, SIGNAL(textMessageReceived(QString)),
+            this, SLOT(onMessageArrived(QString)));
+    connect(pPanelServerSocket, SIGNAL(binaryMessageReceived(QByteArray)),
+            this, SLOT(onBinaryMessageArrived(QByteArray)));
+    connect(pSession, SIGNAL(sessionStarted(bool)),
+            this, SLOT(onSessionStarted(bool)));
+    connect(pSession, SIGNAL(sessionLost()),
+            this, SLOT(onSessionLost()));
 
-    // Connect the refreshTimer timeout with its SLOT
-    connect(&refreshTimer, SIGNAL(timeout()),
-            this, SLOT(onTimeToRefreshStatus()));
+    // Open the Server socket to talk to
+    pSession->open();
 }
 
 
@@ -190,10 +247,8 @@ ScorePanel::ScorePanel(const QString &serverUrl, QFile *myLogFile, QWidget *pare
  * \brief ScorePanel::~ScorePanel The Score Panel destructor
  */
 ScorePanel::~ScorePanel() {
-    refreshTimer.disconnect();
-    refreshTimer.stop();
-    if(pPanelServerSocket)
-        pPanelServerSocket->disconnect();
+    if(pSession)
+        pSession->close();
 #if defined(Q_PROCESSOR_ARM) && !defined(Q_OS_ANDROID)
     if(gpioHostHandle>=0) {
         pigpio_stop(gpioHostHandle);
@@ -203,10 +258,21 @@ ScorePanel::~ScorePanel() {
     pSettings = Q_NULLPTR;
 
     doProcessCleanup();
+#if !defined(Q_PROCESSOR_ARM) & !defined(Q_OS_ANDROID)
+    overlayTimer.stop();
+    delete pScoreOverlay;// Before its host windows
+    pScoreOverlay = Q_NULLPTR;
+    delete pSpotPlayer;
+    pSpotPlayer = Q_NULLPTR;
+#endif
 
-    if(pPanelServerSocket)
-        delete pPanelServerSocket;
+    delete pSession;// and its socket
+    pSession = Q_NULLPTR;
     pPanelServerSocket = Q_NULLPTR;
+    delete pTracer;
+    pTracer = Q_NULLPTR;
+    delete pCapture;
+    pCapture = Q_NULLPTR;
 }
 
 
@@ -227,6 +293,8 @@ ScorePanel::buildLayout() {
     layout()->addWidget(pPanel);
     if(oldPanel != Q_NULLPTR)
         delete oldPanel;
+    if(pScoreOverlay)
+        pScoreOverlay->setSource(pPanel);
 }
 
 
@@ -239,6 +307,10 @@ ScorePanel::buildLayout() {
  */
 void
 ScorePanel::onCreateSpotUpdaterThread() {
+    if(pSpotUpdaterThread)
+        return;// Already updating
+    if(!pPanelServerSocket || !pPanelServerSocket->isValid())
+        return;// Will be restarted when the session resumes
 #ifdef LOG_VERBOSE
     logMessage(logFile,
                Q_FUNC_INFO,
@@ -252,6 +324,7 @@ ScorePanel::onCreateSpotUpdaterThread() {
     QString spotUpdateServer;
     spotUpdateServer= QString("ws://%1:%2").arg(pPanelServerSocket->peerAddress().toString()).arg(spotUpdatePort);
     pSpotUpdater = new FileUpdater(QString("SpotUpdater"), spotUpdateServer, logFile);
+    pSpotUpdater->setMetrics(Metrics::SpotBytes, Metrics::SpotTransferMs);
     pSpotUpdater->moveToThread(pSpotUpdaterThread);
     connect(this, SIGNAL(updateSpots()),
             pSpotUpdater, SLOT(startUpdate()));
@@ -301,6 +374,7 @@ void
 ScorePanel::onSpotUpdaterThreadDone() {
     if(pSpotUpdaterThread)
         pSpotUpdaterThread->disconnect();
+    BinaryLog::record(BinaryLog::SpotUpdaterDone, pSpotUpdater->returnCode);
 #ifdef LOG_VERBOSE
     logMessage(logFile,
                Q_FUNC_INFO,
@@ -312,6 +386,10 @@ ScorePanel::onSpotUpdaterThreadDone() {
         logMessage(logFile,
                    Q_FUNC_INFO,
                    QString("Spot Updater closed without errors"));
+#endif
+#if !defined(Q_OS_ANDROID)
+        // The spot list is rebuilt here, not at every spot switch
+        pSpotPlayer->refreshSpotList();
 #endif
     }
     else if(pSpotUpdater->returnCode == FileUpdater::ERROR_SOCKET) {
@@ -352,6 +430,10 @@ ScorePanel::onSpotUpdaterThreadDone() {
  */
 void
 ScorePanel::onCreateSlideUpdaterThread() {
+    if(pSlideUpdaterThread)
+        return;// Already updating
+    if(!pPanelServerSocket || !pPanelServerSocket->isValid())
+        return;// Will be restarted when the session resumes
 #ifdef LOG_VERBOSE
     logMessage(logFile,
                Q_FUNC_INFO,
@@ -365,6 +447,7 @@ ScorePanel::onCreateSlideUpdaterThread() {
     QString slideUpdateServer;
     slideUpdateServer= QString("ws://%1:%2").arg(pPanelServerSocket->peerAddress().toString()).arg(slideUpdatePort);
     pSlideUpdater = new FileUpdater(QString("SlideUpdater"), slideUpdateServer, logFile);
+    pSlideUpdater->setMetrics(Metrics::SlideBytes, Metrics::SlideTransferMs);
     pSlideUpdater->moveToThread(pSlideUpdaterThread);
     connect(this, SIGNAL(updateSlides()),
             pSlideUpdater, SLOT(startUpdate()));
@@ -414,6 +497,7 @@ void
 ScorePanel::onSlideUpdaterThreadDone() {
     if(pSlideUpdaterThread)
         pSlideUpdaterThread->disconnect();
+    BinaryLog::record(BinaryLog::SlideUpdaterDone, pSlideUpdater->returnCode);
 #ifdef LOG_VERBOSE
     logMessage(logFile,
                Q_FUNC_INFO,
@@ -470,48 +554,27 @@ ScorePanel::setScoreOnly(bool bScoreOnly) {
         // Terminate, if running, Videos, Slides and Camera
 
 #if defined(Q_PROCESSOR_ARM) && !defined(Q_OS_ANDROID)
-        if(slidePlayer) {
-            slidePlayer->disconnect();
+        if(slidePlayer->isActive()) {
             pMySlideWindow->exitShow();// This gently close the slidePlayer Process...
-            system("xrefresh -display :0");
-            slidePlayer->close();
+            slidePlayer->expectExit();// ...otherwise it will be terminated
 #ifdef LOG_VERBOSE
             logMessage(logFile,
                        Q_FUNC_INFO,
                        QString("Closing Slide Player..."));
 #endif
-            slidePlayer->waitForFinished(3000);
-            slidePlayer->deleteLater();
-            slidePlayer = Q_NULLPTR;
         }
 #else
         if(pMySlideWindow) {
             pMySlideWindow->close();
         }
 #endif
-        if(videoPlayer) {
-#ifdef LOG_MESG
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Closing Video Player..."));
+#if !defined(Q_OS_ANDROID)
+        pSpotPlayer->stop();
+#endif
+#if !defined(Q_OS_ANDROID)
+        pLiveView->stop();
+        cameraPlayer->stop();
 #endif
-            videoPlayer->disconnect();
-    #if defined(Q_PROCESSOR_ARM) && !defined(Q_OS_ANDROID)
-            videoPlayer->write("q", 1);
-            system("xrefresh -display :0");
-    #else
-            videoPlayer->close();
-    #endif
-            videoPlayer->waitForFinished(3000);
-            videoPlayer->deleteLater();
-            videoPlayer = Q_NULLPTR;
-        }
-        if(cameraPlayer) {
-            cameraPlayer->close();
-            cameraPlayer->waitForFinished(3000);
-            cameraPlayer->deleteLater();
-            cameraPlayer = Q_NULLPTR;
-        }
     }
 }
 
@@ -527,83 +590,59 @@ ScorePanel::getScoreOnly() {
 
 
 /*!
- * \brief ScorePanel::onPanelServerConnected Invoked asynchronously upon the Server connection
+ * \brief ScorePanel::onSessionStarted Invoked when the Server is (again) connected
+ * \param bResumed true if the connection has been lost and reopened
+ *
+ * The status snapshot has been already asked by the session.
  */
 void
-ScorePanel::onPanelServerConnected() {
+ScorePanel::onSessionStarted(bool bResumed) {
 #ifdef LOG_VERBOSE
     logMessage(logFile,
                Q_FUNC_INFO,
-               QString("Started"));
+               QString("Started%1").arg(bResumed ? " (resumed)" : ""));
+#else
+    Q_UNUSED(bResumed)
 #endif
-    QString sMessage;
-    sMessage = QString("<getStatus>%1</getStatus>").arg(QHostInfo::localHostName());
-    qint64 bytesSent = pPanelServerSocket->sendTextMessage(sMessage);
-    if(bytesSent != sMessage.length()) {
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Unable to ask the initial status"));
-    }
 #if !defined(Q_OS_ANDROID)
     onCreateSpotUpdaterThread();
     onCreateSlideUpdaterThread();
 #endif
-    bStillConnected = false;
-    refreshTimer.start(rand()%2000+3000);
 }
 
 
+/*!
+ * \brief ScorePanel::onSessionLost The Server didn't come back within RESUME_TIMEOUT
+ *
+ * Till then the Panel kept showing what it had (score, Spots,
+ * Slides, Camera): now it is closed and a new Server discovery
+ * is started.
+ */
 void
-ScorePanel::onTimeToRefreshStatus() {
-    if(!bStillConnected) {
-#ifdef LOG_VERBOSE
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Panel Server Disconnected"));
-#endif
-        if(pPanelServerSocket)
-            pPanelServerSocket->deleteLater();
-        pPanelServerSocket =Q_NULLPTR;
-        doProcessCleanup();
-        close();
-        emit panelClosed();
-        return;
-    }
-    QString sMessage;
-    sMessage = QString("<getStatus>%1</getStatus>").arg(QHostInfo::localHostName());
-    qint64 bytesSent = pPanelServerSocket->sendTextMessage(sMessage);
-    if(bytesSent != sMessage.length()) {
-#ifdef LOG_VERBOSE
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Unable to refresh the Panel status"));
-#endif
-        if(pPanelServerSocket)
-            pPanelServerSocket->deleteLater();
-        pPanelServerSocket =Q_NULLPTR;
-        doProcessCleanup();
-        close();
-        emit panelClosed();
-    }
-    bStillConnected = false;
+ScorePanel::onSessionLost() {
+    closeSession();
 }
 
 
 /*!
- * \brief ScorePanel::onPanelServerDisconnected
- * Invoked asynchronously upon the Server disconnection
+ * \brief ScorePanel::closeSession Give up with this Server
  */
 void
-ScorePanel::onPanelServerDisconnected() {
+ScorePanel::closeSession() {
+    BinaryLog::record(BinaryLog::SessionClosed);
     doProcessCleanup();
 #ifdef LOG_VERBOSE
     logMessage(logFile,
                Q_FUNC_INFO,
                QString("emitting panelClosed()"));
 #endif
-    if(pPanelServerSocket)
-        pPanelServerSocket->deleteLater();
-    pPanelServerSocket =Q_NULLPTR;
+    if(pSession) {
+        pSession->close();
+        pSession->deleteLater();// and its socket
+    }
+    pSession = Q_NULLPTR;
+    pPanelServerSocket = Q_NULLPTR;
+    close();// Closes the Widget
     emit panelClosed();
 }
 
@@ -619,85 +658,36 @@ ScorePanel::doProcessCleanup() {
                Q_FUNC_INFO,
                QString("Cleaning all processes"));
 #endif
-    refreshTimer.disconnect();
     spotUpdaterRestartTimer.disconnect();
     slideUpdaterRestartTimer.disconnect();
-    refreshTimer.stop();
     spotUpdaterRestartTimer.stop();
     slideUpdaterRestartTimer.stop();
     closeSpotUpdaterThread();
     closeSlideUpdaterThread();
 
 #if defined(Q_PROCESSOR_ARM) && !defined(Q_OS_ANDROID)
-    if(slidePlayer) {
-        slidePlayer->disconnect();
+    if(slidePlayer->isActive()) {
         pMySlideWindow->exitShow();// This gently close the slidePlayer Process...
-        system("xrefresh -display :0");
-        slidePlayer->close();
+        slidePlayer->expectExit();// ...otherwise it will be terminated
 #ifdef LOG_VERBOSE
         logMessage(logFile,
                    Q_FUNC_INFO,
                    QString("Closing Slide Player..."));
 #endif
-        slidePlayer->waitForFinished(3000);
-        slidePlayer->deleteLater();
-        slidePlayer = Q_NULLPTR;
     }
 #else
     if(pMySlideWindow) {
         pMySlideWindow->close();
     }
 #endif
-    if(videoPlayer) {
-        videoPlayer->disconnect();
-#if defined(Q_PROCESSOR_ARM) && !defined(Q_OS_ANDROID)
-        videoPlayer->write("q", 1);
-        system("xrefresh -display :0");
-#else
-        videoPlayer->close();
+#if !defined(Q_OS_ANDROID)
+    if(pSpotPlayer)
+        pSpotPlayer->stop();
 #endif
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Closing Video Player..."));
-        videoPlayer->waitForFinished(3000);
-        videoPlayer->deleteLater();
-        videoPlayer = Q_NULLPTR;
-    }
-    if(cameraPlayer) {
-        cameraPlayer->close();
-        cameraPlayer->waitForFinished(3000);
-        cameraPlayer->deleteLater();
-        cameraPlayer = Q_NULLPTR;
-    }
-}
-
-
-/*!
- * \brief ScorePanel::onPanelServerSocketError
- * Invoked asynchronously upon a Server socket error.
- * \param error
- */
-void
-ScorePanel::onPanelServerSocketError(QAbstractSocket::SocketError error) {
-    Q_UNUSED(error)
-    doProcessCleanup();
-#ifdef LOG_VERBOSE
-    logMessage(logFile,
-               Q_FUNC_INFO,
-               QString("%1 %2 Error %3")
-               .arg(pPanelServerSocket->peerAddress().toString())
-               .arg(pPanelServerSocket->errorString())
-               .arg(error));
+#if !defined(Q_OS_ANDROID)
+    pLiveView->stop();
+    cameraPlayer->stop();
 #endif
-    if(pPanelServerSocket) {
-        pPanelServerSocket->disconnect();
-        if(pPanelServerSocket->isValid())
-            pPanelServerSocket->close();
-        pPanelServerSocket->deleteLater();
-    }
-    pPanelServerSocket = Q_NULLPTR;
-    close();// Closes the Widget
-    emit panelClosed();
 }
 
 
@@ -787,16 +777,26 @@ ScorePanel::closeEvent(QCloseEvent *event) {
 void
 ScorePanel::keyPressEvent(QKeyEvent *event) {
     if(event->key() == Qt::Key_Escape) {
-        if(pPanelServerSocket) {
-            pPanelServerSocket->disconnect();
-            pPanelServerSocket->close(QWebSocketProtocol::CloseCodeNormal,
-                                      tr("Il Client ha chiuso il collegamento"));
-        }
+        dumpFlightRecorder();
+        if(pSession)
+            pSession->close(tr("Il Client ha chiuso il collegamento"));
         close();
     }
 }
 
 
+/*!
+ * \brief ScorePanel::dumpFlightRecorder Save the last recorded events (see BinaryLog::dump())
+ */
+void
+ScorePanel::dumpFlightRecorder() {
+    if(BinaryLog::dump())
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Flight recorder saved in %1").arg(BinaryLog::dumpFile()));
+}
+
+
 /*!
  * \brief ScorePanel::onSlideShowClosed Invoked asynchronously when the Slide Window closes
  * \param exitCode unused
@@ -807,52 +807,36 @@ ScorePanel::onSlideShowClosed(int exitCode, QProcess::ExitStatus exitStatus) {
     Q_UNUSED(exitCode);
     Q_UNUSED(exitStatus);
 
-    if(slidePlayer) {
-        slidePlayer->deleteLater();
-        slidePlayer = Q_NULLPTR;
-        //To avoid a blank screen that sometime appear at the end of the slideShow
+    //To avoid a blank screen that sometime appear at the end of the slideShow
 #if defined(Q_PROCESSOR_ARM) && !defined(Q_OS_ANDROID)
-        int iDummy = system("xrefresh -display :0");
-        Q_UNUSED(iDummy)
+    ProcessSupervisor::runDetached(QString("xrefresh"), QStringList() << "-display" << ":0");
 #endif
-    }
 }
 
 
 /*!
- * \brief ScorePanel::onSpotClosed Invoked asynchronously when the Spot Window closes
- * \param exitCode Unused
- * \param exitStatus Unused
+ * \brief ScorePanel::onSpotPlayerClosed Invoked when the in-process spot loop ends
  */
 void
-ScorePanel::onSpotClosed(int exitCode, QProcess::ExitStatus exitStatus) {
-    Q_UNUSED(exitCode);
-    Q_UNUSED(exitStatus);
-    if(videoPlayer) {
-        videoPlayer->disconnect();
-        videoPlayer->close();// Closes all communication with the process and kills it.
-        delete videoPlayer;
-        videoPlayer = Q_NULLPTR;
-        //To avoid a blank screen that sometime appear at the end of omxplayer
-        int iDummy = system("xrefresh -display :0");
-        Q_UNUSED(iDummy)
-        QString sMessage = "<closed_spot>1</closed_spot>";
-        qint64 bytesSent = pPanelServerSocket->sendTextMessage(sMessage);
-        if(bytesSent != sMessage.length()) {
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Unable to send %1")
-                       .arg(sMessage));
-        }
+ScorePanel::onSpotPlayerClosed() {
+    if(!pPanelServerSocket)
+        return;
+    QString sMessage = "<closed_spot>1</closed_spot>";
+    qint64 bytesSent = pPanelServerSocket->sendTextMessage(sMessage);
+    if(bytesSent != sMessage.length()) {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Unable to send %1")
+                   .arg(sMessage));
+    }
 #ifdef LOG_VERBOSE
-        else {
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Sent %1")
-                       .arg(sMessage));
-        }
-#endif
+    else {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Sent %1")
+                   .arg(sMessage));
     }
+#endif
 }
 
 
@@ -865,99 +849,136 @@ void
 ScorePanel::onLiveClosed(int exitCode, QProcess::ExitStatus exitStatus) {
     Q_UNUSED(exitCode);
     Q_UNUSED(exitStatus);
-    if(cameraPlayer) {
-        delete cameraPlayer;
-        cameraPlayer = Q_NULLPTR;
 #if defined(Q_PROCESSOR_ARM) && !defined(Q_OS_ANDROID)
-        //To avoid a blank screen that sometime appear at the end of omxplayer
-        int iDummy =system("xrefresh -display :0");
-        Q_UNUSED(iDummy)
+    //To avoid a blank screen that sometime appear at the end of omxplayer
+    ProcessSupervisor::runDetached(QString("xrefresh"), QStringList() << "-display" << ":0");
 #endif
-        QString sMessage = "<closed_live>1</closed_live>";
-        qint64 bytesSent = pPanelServerSocket->sendTextMessage(sMessage);
-        if(bytesSent != sMessage.length()) {
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Unable to send %1")
-                       .arg(sMessage));
-        }
+    if(!pPanelServerSocket || !pPanelServerSocket->isValid())
+        return;// Closed during the cleanup
+    QString sMessage = "<closed_live>1</closed_live>";
+    qint64 bytesSent = pPanelServerSocket->sendTextMessage(sMessage);
+    if(bytesSent != sMessage.length()) {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Unable to send %1")
+                   .arg(sMessage));
     }
 }
 
 
 /*!
- * \brief ScorePanel::onStartNextSpot
- * \param exitCode
- * \param exitStatus
+ * \brief ScorePanel::onLiveViewClosed Invoked when the in process Live View stops
  */
 void
-ScorePanel::onStartNextSpot(int exitCode, QProcess::ExitStatus exitStatus) {
-    Q_UNUSED(exitCode);
-    Q_UNUSED(exitStatus);
-    // Update spot list just in case we are updating the spot list...
-    QDir spotDir(sSpotDir);
-    spotList = QFileInfoList();
-    QStringList nameFilter(QStringList() << "*.mp4" << "*.MP4");
-    spotDir.setNameFilters(nameFilter);
-    spotDir.setFilter(QDir::Files);
-    spotList = spotDir.entryInfoList();
-    if(spotList.count() == 0) {
-#ifdef LOG_VERBOSE
+ScorePanel::onLiveViewClosed() {
+    if(!pPanelServerSocket || !pPanelServerSocket->isValid())
+        return;// Closed during the cleanup
+    QString sMessage = "<closed_live>1</closed_live>";
+    qint64 bytesSent = pPanelServerSocket->sendTextMessage(sMessage);
+    if(bytesSent != sMessage.length()) {
         logMessage(logFile,
                    Q_FUNC_INFO,
-                   QString("No spots available !"));
-#endif
-        if(videoPlayer) {
-            videoPlayer->disconnect();
-            delete videoPlayer;
-            videoPlayer = Q_NULLPTR;
-            QString sMessage = "<closed_spot>1</closed_spot>";
-            qint64 bytesSent = pPanelServerSocket->sendTextMessage(sMessage);
-            if(bytesSent != sMessage.length()) {
-                logMessage(logFile,
-                           Q_FUNC_INFO,
-                           QString("Unable to send %1")
-                           .arg(sMessage));
-            }
-        }
-        //To avoid a blank screen that sometime appear at the end of omxplayer
-        int iDummy = system("xrefresh -display :0");
-        Q_UNUSED(iDummy)
-        return;
+                   QString("Unable to send %1")
+                   .arg(sMessage));
     }
+}
+
+/*!
+ * \brief ScorePanel::onScoreChanged Invoked when the score shown has changed
+ *
+ * The overlay is rendered again at the next event loop iteration:
+ * a burst of updates costs a single rendering.
+ */
+void
+ScorePanel::onScoreChanged() {
+    if(pScoreOverlay && pScoreOverlay->isVisible())
+        overlayTimer.start(0);
+}
+
+
+/*!
+ * \brief ScorePanel::onMessageArrived A message left the socket: a score update starts
+ * \param sMessage
+ */
+void
+ScorePanel::onMessageArrived(QString sMessage) {
+    Metrics::add(Metrics::MessagesReceived);
+    BinaryLog::record(BinaryLog::MessageReceived, sMessage.length());
+    pTracer->begin();
+    if(bCaptureEnabled && startCapture())
+        pCapture->addText(sMessage);
+}
+
 
-    iCurrentSpot = iCurrentSpot % spotList.count();
-    if(!videoPlayer) {
-        videoPlayer = new QProcess(this);
-        connect(videoPlayer, SIGNAL(finished(int, QProcess::ExitStatus)),
-                this, SLOT(onStartNextSpot(int, QProcess::ExitStatus)));
+/*!
+ * \brief ScorePanel::onBinaryMessageArrived
+ * \param baMessage
+ */
+void
+ScorePanel::onBinaryMessageArrived(QByteArray baMessage) {
+    if(bCaptureEnabled && startCapture())
+        pCapture->addBinary(baMessage);
+}
+
+
+/*!
+ * \brief ScorePanel::startCapture Open the capture file, if not yet done
+ * \return true if the capture is running
+ *
+ * Started with the first message since only then the derived
+ * Panel (and hence the panel type) is known.
+ */
+bool
+ScorePanel::startCapture() {
+    if(pCapture->isActive())
+        return true;
+    if(!pScoreModel)
+        return false;
+    if(!pCapture->start(sCaptureFile, pScoreModel->panelType())) {
+        bCaptureEnabled = false;
+        return false;
     }
-    QString sCommand;
-    #ifdef Q_PROCESSOR_ARM
-        sCommand = "/usr/bin/omxplayer -o hdmi -r " + spotList.at(iCurrentSpot).absoluteFilePath();
-    #else
-        sCommand = "/usr/bin/cvlc --no-osd -f " + spotList.at(iCurrentSpot).absoluteFilePath() + " vlc://quit";
-    #endif
-    videoPlayer->start(sCommand);
-#ifdef LOG_VERBOSE
     logMessage(logFile,
                Q_FUNC_INFO,
-               QString("Now playing: %1")
-               .arg(spotList.at(iCurrentSpot).absoluteFilePath()));
-#endif
-    iCurrentSpot = (iCurrentSpot+1) % spotList.count();// Prepare Next Spot
-    if(!videoPlayer->waitForStarted(3000)) {
-        videoPlayer->close();
-        logMessage(logFile,
-                   Q_FUNC_INFO,
-                   QString("Impossibile mandare lo spot"));
-        videoPlayer->disconnect();
-        delete videoPlayer;
-        videoPlayer = Q_NULLPTR;
-        //To avoid a blank screen that sometime appear at the end of omxplayer
-        int iDummy = system("xrefresh -display :0");
-        Q_UNUSED(iDummy)
+               QString("Capturing the Server messages in %1").arg(sCaptureFile));
+    return true;
+}
+
+
+/*!
+ * \brief ScorePanel::event Timestamps the window repaints
+ * \param event
+ * \return
+ *
+ * The UpdateRequest of the top level window is where Qt paints
+ * the dirty widgets and flushes them to the screen.
+ * A RepaintCheckEvent reaching us while the update is still
+ * open means that the message left nothing to repaint.
+ */
+bool
+ScorePanel::event(QEvent *event) {
+    if(event->type() == RepaintCheckEvent) {
+        pTracer->notPainted();
+        return true;
     }
+    bool bResult = QWidget::event(event);
+    if(event->type() == QEvent::UpdateRequest)
+        pTracer->painted();
+    return bResult;
+}
+
+
+/*!
+ * \brief ScorePanel::markDispatched The derived Panel has handled the message
+ *
+ * The UpdateRequest of a dirty window is posted with low priority
+ * while the widgets are changed: the RepaintCheckEvent, posted here
+ * with the same priority, is delivered after it.
+ */
+void
+ScorePanel::markDispatched() {
+    pTracer->mark(Tracer::Dispatched);
+    QCoreApplication::postEvent(this, new QEvent(RepaintCheckEvent), Qt::LowEventPriority);
 }
 
 
@@ -981,22 +1002,24 @@ ScorePanel::onBinaryMessageReceived(QByteArray baMessage) {
  */
 void
 ScorePanel::onTextMessageReceived(QString sMessage) {
-    refreshTimer.start(rand()%2000+3000);
-    bStillConnected = true;
     QString sToken;
     bool ok;
     int iVal;
     QString sNoData = QString("NoData");
 
+    // The derived panels have already updated the score
+    pTracer->mark(Tracer::Updated);
+    onScoreChanged();
+
     sToken = XML_Parse(sMessage, "kill");
     if(sToken != sNoData) {
         iVal = sToken.toInt(&ok);
         if(!ok || iVal<0 || iVal>1)
             iVal = 0;
         if(iVal == 1) {
-            pPanelServerSocket->disconnect();
+            pSession->close();
             #ifdef Q_PROCESSOR_ARM
-            system("sudo halt");
+            ProcessSupervisor::runDetached(QString("sudo"), QStringList() << "halt");
             #endif
             close();// emit the QCloseEvent that is responsible
                     // to clean up all pending processes
@@ -1005,13 +1028,9 @@ ScorePanel::onTextMessageReceived(QString sMessage) {
 
     sToken = XML_Parse(sMessage, "endspot");
     if(sToken != sNoData) {
-        if(videoPlayer) {
-            #ifdef Q_PROCESSOR_ARM
-            videoPlayer->write("q", 1);
-            #else
-            videoPlayer->close();
-            #endif
-        }
+        #if !defined(Q_OS_ANDROID)
+        pSpotPlayer->nextSpot();
+        #endif
     }// endspot
 
     sToken = XML_Parse(sMessage, "spotloop");
@@ -1021,16 +1040,9 @@ ScorePanel::onTextMessageReceived(QString sMessage) {
 
     sToken = XML_Parse(sMessage, "endspotloop");
     if(sToken != sNoData) {
-        if(videoPlayer) {
-            videoPlayer->disconnect();
-            connect(videoPlayer, SIGNAL(finished(int, QProcess::ExitStatus)),
-                    this, SLOT(onSpotClosed(int, QProcess::ExitStatus)));
-            #ifdef Q_PROCESSOR_ARM
-            videoPlayer->write("q", 1);
-            #else
-            videoPlayer->terminate();
-            #endif
-        }
+        #if !defined(Q_OS_ANDROID)
+        pSpotPlayer->stopLoop();
+        #endif
     }// endspoloop
 
     sToken = XML_Parse(sMessage, "slideshow");
@@ -1038,6 +1050,40 @@ ScorePanel::onTextMessageReceived(QString sMessage) {
         startSlideShow();
     }// slideshow
 
+    sToken = XML_Parse(sMessage, "slideTransition");
+    if(sToken != sNoData) {
+        #if !defined(Q_PROCESSOR_ARM) & !defined(Q_OS_ANDROID)
+        iVal = sToken.toInt(&ok);
+        if(!ok || !pMySlideWindow || !pMySlideWindow->setTransitionMode(iVal)) {
+            logMessage(logFile,
+                       Q_FUNC_INFO,
+                       QString("Unknown slide transition: %1").arg(sToken));
+        }
+        #endif
+    }// slideTransition
+
+    sToken = XML_Parse(sMessage, "slidePlaylist");
+    if(sToken != sNoData) {
+        #if !defined(Q_PROCESSOR_ARM) & !defined(Q_OS_ANDROID)
+        if(pMySlideWindow)
+            pMySlideWindow->setPlaylist(sToken);
+        #endif
+    }// slidePlaylist
+
+    sToken = XML_Parse(sMessage, "slidePrefetch");
+    if(sToken != sNoData) {
+        #if !defined(Q_PROCESSOR_ARM) & !defined(Q_OS_ANDROID)
+        QStringList sArgs = sToken.split(",", Qt::SkipEmptyParts);
+        if(sArgs.count() == 2 && pMySlideWindow) {
+            bool okDepth, okBudget;
+            int iDepth  = sArgs.at(0).toInt(&okDepth);
+            int iBudget = sArgs.at(1).toInt(&okBudget);
+            if(okDepth && okBudget)
+                pMySlideWindow->setPrefetch(iDepth, iBudget);
+        }
+        #endif
+    }// slidePrefetch
+
     sToken = XML_Parse(sMessage, "endslideshow");
     if(sToken != sNoData){
         #if defined(Q_PROCESSOR_ARM) & !defined(Q_OS_ANDROID)
@@ -1060,8 +1106,9 @@ ScorePanel::onTextMessageReceived(QString sMessage) {
     sToken = XML_Parse(sMessage, "endlive");
     if(sToken != sNoData) {
         #if !defined(Q_OS_ANDROID)
-        if(cameraPlayer) {
-            cameraPlayer->terminate();
+        pLiveView->stop();
+        if(cameraPlayer->isActive()) {
+            cameraPlayer->stop();
 #ifdef LOG_VERBOSE
             logMessage(logFile,
                        Q_FUNC_INFO,
@@ -1071,6 +1118,56 @@ ScorePanel::onTextMessageReceived(QString sMessage) {
         #endif
     }// endlive
 
+    sToken = XML_Parse(sMessage, "getLiveLatency");
+    if(sToken != sNoData) {
+        #if !defined(Q_OS_ANDROID)
+        QString sAnswer = QString("<liveLatency>%1</liveLatency>").arg(pLiveView->latencyReport());
+        qint64 bytesSent = pPanelServerSocket->sendTextMessage(sAnswer);
+        if(bytesSent != sAnswer.length()) {
+            logMessage(logFile,
+                       Q_FUNC_INFO,
+                       QString("Unable to send %1").arg(sAnswer));
+        }
+        #endif
+    }// getLiveLatency
+
+    sToken = XML_Parse(sMessage, "getLatency");
+    if(sToken != sNoData) {
+        QString sAnswer = QString("<latency>%1</latency>").arg(pTracer->latencyReport());
+        qint64 bytesSent = pPanelServerSocket->sendTextMessage(sAnswer);
+        if(bytesSent != sAnswer.length()) {
+            logMessage(logFile,
+                       Q_FUNC_INFO,
+                       QString("Unable to send %1").arg(sAnswer));
+        }
+    }// getLatency
+
+    sToken = XML_Parse(sMessage, "getMetrics");
+    if(sToken != sNoData) {
+        getMetrics();
+    }// getMetrics
+
+    sToken = XML_Parse(sMessage, "saveTrace");
+    if(sToken != sNoData) {
+        if(pTracer->save(sTraceFile))
+            logMessage(logFile,
+                       Q_FUNC_INFO,
+                       QString("Score updates trace saved in %1").arg(sTraceFile));
+    }// saveTrace
+
+    sToken = XML_Parse(sMessage, "dumpTrace");
+    if(sToken != sNoData) {
+        dumpFlightRecorder();
+    }// dumpTrace
+
+    sToken = XML_Parse(sMessage, "capture");
+    if(sToken != sNoData) {
+        bCaptureEnabled = sToken.toInt() != 0;
+        pSettings->setValue("capture/enabled", bCaptureEnabled);
+        if(!bCaptureEnabled)
+            pCapture->stop();
+    }// capture
+
     sToken = XML_Parse(sMessage, "pan");
     if(sToken != sNoData) {
 #if defined(Q_PROCESSOR_ARM) && !defined(Q_OS_ANDROID)
@@ -1173,6 +1270,20 @@ ScorePanel::onTextMessageReceived(QString sMessage) {
         getPanelScoreOnly();
     }// getScoreOnly
 
+    sToken = XML_Parse(sMessage, "setOverlay");
+    if(sToken != sNoData) {
+        bool bOverlay = sToken.toInt() != 0;
+        pSettings->setValue("panel/overlay", bOverlay);
+        #if !defined(Q_PROCESSOR_ARM) & !defined(Q_OS_ANDROID)
+        pScoreOverlay->setOverlayMode(bOverlay);
+        #endif
+    }// setOverlay
+
+    sToken = XML_Parse(sMessage, "getSpotInfo");
+    if(sToken != sNoData) {
+        getSpotInfo();
+    }// getSpotInfo
+
     sToken = XML_Parse(sMessage, "setScoreOnly");
     if(sToken != sNoData) {
         #if !defined(Q_OS_ANDROID)
@@ -1197,15 +1308,16 @@ ScorePanel::onTextMessageReceived(QString sMessage) {
 
     sToken = XML_Parse(sMessage, "language");
     if(sToken != sNoData) {
-        MyApplication* application = static_cast<MyApplication *>(QApplication::instance());
-
-        QCoreApplication::removeTranslator(&application->Translator);
-        if(sToken == QString("English")) {
-            if(application->Translator.load(":/panelChooser_en"))
-                QCoreApplication::installTranslator(&application->Translator);
-        }
-        else {
+        // Not a MyApplication when the Panel is driven by tools/replay
+        MyApplication* application = qobject_cast<MyApplication *>(QApplication::instance());
+        if(sToken != QString("English"))
             sToken = QString("Italiano");
+        if(application) {
+            QCoreApplication::removeTranslator(&application->Translator);
+            if(sToken == QString("English")) {
+                if(application->Translator.load(":/panelChooser_en"))
+                    QCoreApplication::installTranslator(&application->Translator);
+            }
         }
         pSettings->setValue("language/current", sToken);
 #ifdef LOG_VERBOSE
@@ -1223,41 +1335,46 @@ ScorePanel::onTextMessageReceived(QString sMessage) {
  */
 void
 ScorePanel::startLiveCamera() {
-    if(!cameraPlayer) {
-        cameraPlayer = new QProcess(this);
-        connect(cameraPlayer, SIGNAL(finished(int, QProcess::ExitStatus)),
-                this, SLOT(onLiveClosed(int, QProcess::ExitStatus)));
-        QString sCommand = QString();
-        #ifdef Q_PROCESSOR_ARM
-        sCommand = QString("/usr/bin/raspivid -f -t 0 -awb auto --vflip --hflip");
-        #else
-        if(!spotList.isEmpty()) {
-            sCommand = "/usr/bin/cvlc --no-osd -f " + spotList.at(iCurrentSpot).absoluteFilePath() + " vlc://quit";
-            iCurrentSpot = (iCurrentSpot+1) % spotList.count();// Prepare Next Spot
-        }
-        #endif
-        if(sCommand != QString()) {
-            cameraPlayer->start(sCommand);
-            if(!cameraPlayer->waitForStarted(3000)) {
-                cameraPlayer->close();
-                logMessage(logFile,
-                           Q_FUNC_INFO,
-                           QString("Impossibile mandare lo spot."));
-                delete cameraPlayer;
-                cameraPlayer = Q_NULLPTR;
-            }
+    if(pLiveView->isActive() || cameraPlayer->isActive())
+        return;
+    // In process capture first: the lowest latency
+    QString sDevice = pSettings->value("camera/device", "/dev/video0").toString();
+    if(pLiveView->start(sDevice)) {
 #ifdef LOG_VERBOSE
-            else {
-                logMessage(logFile,
-                           Q_FUNC_INFO,
-                           QString("Live Show is started."));
-            }
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Live View is starting."));
+#endif
+        return;
+    }
+    // Otherwise an external player
+    QString sProgram;
+    QStringList arguments;
+    #ifdef Q_PROCESSOR_ARM
+    sProgram = QString("/usr/bin/raspivid");
+    arguments << "-f" << "-t" << "0" << "-awb" << "auto" << "--vflip" << "--hflip";
+    #else
+    if(!spotList.isEmpty()) {
+        sProgram = QString("/usr/bin/cvlc");
+        arguments << "--no-osd" << "-f"
+                  << spotList.at(iCurrentSpot).absoluteFilePath()
+                  << "vlc://quit";
+        iCurrentSpot = (iCurrentSpot+1) % spotList.count();// Prepare Next Spot
+    }
+    #endif
+    if(sProgram != QString()) {
+        // A failure to start is logged by the supervisor
+        cameraPlayer->start(sProgram, arguments);
+#ifdef LOG_VERBOSE
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Live Show is starting."));
 #endif
-        }
     }
 }
 
 
+
 /*!
  * \brief ScorePanel::getPanelScoreOnly
  * send a message indicating if the ScorePanel shows only the score
@@ -1277,6 +1394,73 @@ ScorePanel::getPanelScoreOnly() {
 }
 
 
+/*!
+ * \brief ScorePanel::getSpotInfo
+ * send the number of playable Spots and the length of their loop (ms)
+ *
+ * The durations come from the probe cache: no file is opened
+ * unless it changed since it has been probed.
+ */
+void
+ScorePanel::getSpotInfo() {
+    if(!pPanelServerSocket->isValid())
+        return;
+    int nSpots = 0;
+    qint64 loopLengthMs = 0;
+    QDir spotDir(sSpotDir);
+    if(spotDir.exists()) {
+        QStringList nameFilter(QStringList() << "*.mp4" << "*.MP4");
+        spotDir.setNameFilters(nameFilter);
+        spotDir.setFilter(QDir::Files);
+        QFileInfoList fileList = spotDir.entryInfoList();
+        MediaProbe probe(sSpotDir, logFile);
+        for(int i=0; i<fileList.count(); i++) {
+            mediaInfo info = probe.info(fileList.at(i).fileName());
+            if(info.bValid) {
+                nSpots++;
+                loopLengthMs += info.durationMs;
+            }
+        }
+        probe.save();
+    }
+    QString sMessage = QString("<spotInfo>%1,%2</spotInfo>").arg(nSpots).arg(loopLengthMs);
+    qint64 bytesSent = pPanelServerSocket->sendTextMessage(sMessage);
+    if(bytesSent != sMessage.length()) {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Unable to send %1").arg(sMessage));
+    }
+}
+
+
+/*!
+ * \brief ScorePanel::getMetrics
+ * send a snapshot of the Panel Metrics
+ *
+ * The message rate is computed since the previous request, so the
+ * Server can poll it periodically for a fleet health view.
+ */
+void
+ScorePanel::getMetrics() {
+    if(!pPanelServerSocket->isValid())
+        return;
+    qint64 nMessages = Metrics::value(Metrics::MessagesReceived);
+    qint64 elapsed = metricsTime.restart();
+    double rate = elapsed > 0 ? double(nMessages-lastMetricsMessages)*1000.0/double(elapsed) : 0.0;
+    lastMetricsMessages = nMessages;
+    QString sMessage = QString("<metrics>%1;rate=%2;pingMs=%3</metrics>")
+                       .arg(Metrics::snapshot())
+                       .arg(rate, 0, 'f', 1)
+                       .arg(pSession->lastRtt());
+    qint64 bytesSent = pPanelServerSocket->sendTextMessage(sMessage);
+    if(bytesSent != sMessage.length()) {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Unable to send %1").arg(sMessage));
+    }
+}
+
+
 /*!
  * \brief ScorePanel::startSpotLoop
  * Invoked to start a loop of Spots
@@ -1289,44 +1473,24 @@ ScorePanel::startSpotLoop() {
         QStringList nameFilter(QStringList() << "*.mp4" << "*.MP4");
         spotDir.setNameFilters(nameFilter);
         spotDir.setFilter(QDir::Files);
-        spotList = spotDir.entryInfoList();
+        MediaProbe probe(sSpotDir, logFile);
+        spotList = probe.playable(spotDir.entryInfoList());
+        probe.save();
     }
 #ifdef LOG_VERBOSE
     logMessage(logFile,
                Q_FUNC_INFO,
                QString("Found %1 spots").arg(spotList.count()));
 #endif
+#if !defined(Q_OS_ANDROID)
     if(!spotList.isEmpty()) {
-        iCurrentSpot = iCurrentSpot % spotList.count();
-        if(!videoPlayer) {
-            videoPlayer = new QProcess(this);
-            connect(videoPlayer, SIGNAL(finished(int, QProcess::ExitStatus)),
-                    this, SLOT(onStartNextSpot(int, QProcess::ExitStatus)));
-            QString sCommand;
-            #ifdef Q_PROCESSOR_ARM
-            sCommand = "/usr/bin/omxplayer -o hdmi -r " + spotList.at(iCurrentSpot).absoluteFilePath();
-            #else
-            sCommand = "/usr/bin/cvlc --no-osd -f " + spotList.at(iCurrentSpot).absoluteFilePath() + " vlc://quit";
-            #endif
-            videoPlayer->start(sCommand);
-#ifdef LOG_VERBOSE
+        if(!pSpotPlayer->startLoop()) {
             logMessage(logFile,
                        Q_FUNC_INFO,
-                       QString("Now playing: %1")
-                       .arg(spotList.at(iCurrentSpot).absoluteFilePath()));
-#endif
-            iCurrentSpot = (iCurrentSpot+1) % spotList.count();// Prepare Next Spot
-            if(!videoPlayer->waitForStarted(3000)) {
-                videoPlayer->close();
-                logMessage(logFile,
-                           Q_FUNC_INFO,
-                           QString("Impossibile mandare lo spot."));
-                videoPlayer->disconnect();
-                delete videoPlayer;
-                videoPlayer = Q_NULLPTR;
-            }
+                       QString("Impossibile mandare lo spot."));
         }
     }
+#endif
 }
 
 
@@ -1336,8 +1500,14 @@ ScorePanel::startSpotLoop() {
  */
 void
 ScorePanel::startSlideShow() {
-    if(videoPlayer || cameraPlayer)
+    if(cameraPlayer && cameraPlayer->isActive())
         return;// No Slide Show if movies are playing or camera is active
+    if(pLiveView && pLiveView->isActive())
+        return;
+#if !defined(Q_OS_ANDROID)
+    if(pSpotPlayer->isPlaying())
+        return;
+#endif
 #if defined(Q_PROCESSOR_ARM) & !defined(Q_OS_ANDROID)
     if(pMySlideWindow->isValid()) {
 #else
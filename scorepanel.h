@@ -27,6 +27,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QtGlobal>
 #include <QTranslator>
 #include <QTimer>
+#include <QElapsedTimer>
 
 #if defined(Q_PROCESSOR_ARM) & !defined(Q_OS_ANDROID)
     #include "slidewindow_interface.h"
@@ -45,7 +46,16 @@ QT_FORWARD_DECLARE_CLASS(QSettings)
 QT_FORWARD_DECLARE_CLASS(QFile)
 QT_FORWARD_DECLARE_CLASS(QUdpSocket)
 QT_FORWARD_DECLARE_CLASS(QWebSocket)
+QT_FORWARD_DECLARE_CLASS(PanelSession)
 QT_FORWARD_DECLARE_CLASS(SlideWindow)
+QT_FORWARD_DECLARE_CLASS(SpotPlayer)
+QT_FORWARD_DECLARE_CLASS(SpotProcessPlayer)
+QT_FORWARD_DECLARE_CLASS(ProcessSupervisor)
+QT_FORWARD_DECLARE_CLASS(LiveView)
+QT_FORWARD_DECLARE_CLASS(ScoreOverlay)
+QT_FORWARD_DECLARE_CLASS(ScoreModel)
+QT_FORWARD_DECLARE_CLASS(Tracer)
+QT_FORWARD_DECLARE_CLASS(ProtocolCapture)
 QT_FORWARD_DECLARE_CLASS(QGridLayout)
 QT_FORWARD_DECLARE_CLASS(UpdaterThread)
 QT_FORWARD_DECLARE_CLASS(FileUpdater)
@@ -72,17 +82,18 @@ signals:
 protected slots:
     void onTextMessageReceived(QString sMessage);
     void onBinaryMessageReceived(QByteArray baMessage);
+    void onScoreChanged();
 
 
 private slots:
-    void onPanelServerConnected();
-    void onPanelServerDisconnected();
-    void onPanelServerSocketError(QAbstractSocket::SocketError error);
-    void onTimeToRefreshStatus();
+    void onMessageArrived(QString sMessage);
+    void onBinaryMessageArrived(QByteArray baMessage);
+    void onSessionStarted(bool bResumed);
+    void onSessionLost();
     void onSlideShowClosed(int exitCode, QProcess::ExitStatus exitStatus);
-    void onSpotClosed(int exitCode, QProcess::ExitStatus exitStatus);
+    void onSpotPlayerClosed();
     void onLiveClosed(int exitCode, QProcess::ExitStatus exitStatus);
-    void onStartNextSpot(int exitCode, QProcess::ExitStatus exitStatus);
+    void onLiveViewClosed();
     void onCreateSpotUpdaterThread();
     void onCreateSlideUpdaterThread();
 
@@ -91,9 +102,12 @@ private slots:
 
 protected:
     virtual QGridLayout* createPanel();
+    bool event(QEvent *event);
+    void markDispatched();
 
     void buildLayout();
     void doProcessCleanup();
+    void closeSession();
     void closeSpotUpdaterThread();
     void closeSlideUpdaterThread();
 
@@ -108,21 +122,36 @@ protected:
      */
     bool               isScoreOnly;
     /*!
-     * \brief pPanelServerSocket The WebSocket to talk with the server
+     * \brief pPanelServerSocket The WebSocket to talk with the server (owned by pSession)
      */
     QWebSocket        *pPanelServerSocket;
     /*!
      * \brief logFile the file for message logging (if any)
      */
     QFile             *logFile;
+    /*!
+     * \brief pScoreModel The widget free score state (created by the derived Panels)
+     */
+    ScoreModel        *pScoreModel;
+    /*!
+     * \brief pTracer Timestamps the score updates (see Tracer)
+     */
+    Tracer            *pTracer;
     QTranslator        Translator;
 
 private:
-    bool               bStillConnected;
-    QTimer             refreshTimer;
-    QProcess          *slidePlayer;
-    QProcess          *videoPlayer;
-    QProcess          *cameraPlayer;
+    PanelSession      *pSession;
+    QString            sTraceFile;
+    ProtocolCapture   *pCapture;
+    bool               bCaptureEnabled;
+    QString            sCaptureFile;
+    QElapsedTimer      metricsTime;
+    qint64             lastMetricsMessages;
+    ProcessSupervisor *slidePlayer;
+    ProcessSupervisor *cameraPlayer;
+    LiveView          *pLiveView;
+    ScoreOverlay      *pScoreOverlay;
+    QTimer             overlayTimer;
     QString            sProcess;
     QString            sProcessArguments;
 
@@ -160,6 +189,11 @@ private:
 #else
     SlideWindow       *pMySlideWindow;
 #endif
+#if defined(Q_PROCESSOR_ARM) & !defined(Q_OS_ANDROID)
+    SpotProcessPlayer *pSpotPlayer;
+#elif !defined(Q_OS_ANDROID)
+    SpotPlayer        *pSpotPlayer;
+#endif
 
     unsigned           panPin;
     unsigned           tiltPin;
@@ -177,6 +211,10 @@ private:
     void               startSpotLoop();
     void               startSlideShow();
     void               getPanelScoreOnly();
+    void               getSpotInfo();
+    void               getMetrics();
+    void               dumpFlightRecorder();
+    bool               startCapture();
 
 private:
     QSettings         *pSettings;
@@ -0,0 +1,121 @@
+# Copyright (C) 2016  Gabriele Salvato
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# The Score Panel sources, shared by panelChooser.pro and by
+# the tools (tools/replay, tools/bench) that drive the real Panels.
+
+QT += core
+QT += gui
+QT += websockets
+QT += serialport
+QT += widgets
+greaterThan(QT_MAJOR_VERSION, 5): {
+    QT += opengl
+    QT += openglwidgets
+}
+contains(QMAKE_HOST.arch, "armv7l") || contains(QMAKE_HOST.arch, "armv6l"): {
+    QT += dbus
+}
+
+INCLUDEPATH += $$PWD
+
+SOURCES += $$PWD/myapplication.cpp
+SOURCES += $$PWD/timeoutwindow.cpp
+SOURCES += $$PWD/messagewindow.cpp
+SOURCES += $$PWD/scorepanel.cpp
+SOURCES += $$PWD/segnapuntibasket.cpp
+SOURCES += $$PWD/segnapuntivolley.cpp
+SOURCES += $$PWD/segnapuntihandball.cpp
+SOURCES += $$PWD/serverdiscoverer.cpp
+SOURCES += $$PWD/fileupdater.cpp
+SOURCES += $$PWD/utility.cpp
+SOURCES += $$PWD/asynclogger.cpp
+SOURCES += $$PWD/binarylog.cpp
+SOURCES += $$PWD/timedscorepanel.cpp
+SOURCES += $$PWD/processsupervisor.cpp
+SOURCES += $$PWD/mediaprobe.cpp
+SOURCES += $$PWD/scoreoverlay.cpp
+SOURCES += $$PWD/networkwatcher.cpp
+SOURCES += $$PWD/scoremodel.cpp
+SOURCES += $$PWD/panelsession.cpp
+SOURCES += $$PWD/headlesspanel.cpp
+SOURCES += $$PWD/tracer.cpp
+SOURCES += $$PWD/protocolcapture.cpp
+SOURCES += $$PWD/metrics.cpp
+contains(QMAKE_HOST.arch, "x86_64") {
+    QT += multimedia
+    QT += multimediawidgets
+    SOURCES += $$PWD/slidewindow.cpp
+    SOURCES += $$PWD/glslidewidget.cpp
+    SOURCES += $$PWD/slidetransition.cpp
+    SOURCES += $$PWD/slideplaylist.cpp
+    SOURCES += $$PWD/slideloader.cpp
+    SOURCES += $$PWD/spotplayer.cpp
+}
+
+
+HEADERS += $$PWD/myapplication.h
+HEADERS += $$PWD/build_number.h
+HEADERS += $$PWD/timeoutwindow.h
+HEADERS += $$PWD/messagewindow.h
+HEADERS += $$PWD/scorepanel.h
+HEADERS += $$PWD/segnapuntibasket.h
+HEADERS += $$PWD/segnapuntivolley.h
+HEADERS += $$PWD/segnapuntihandball.h
+HEADERS += $$PWD/serverdiscoverer.h
+HEADERS += $$PWD/fileupdater.h
+HEADERS += $$PWD/utility.h
+HEADERS += $$PWD/asynclogger.h
+HEADERS += $$PWD/binarylog.h
+HEADERS += $$PWD/timedscorepanel.h
+HEADERS += $$PWD/panelorientation.h
+HEADERS += $$PWD/processsupervisor.h
+HEADERS += $$PWD/mediaprobe.h
+HEADERS += $$PWD/scoreoverlay.h
+HEADERS += $$PWD/networkwatcher.h
+HEADERS += $$PWD/scoremodel.h
+HEADERS += $$PWD/panelsession.h
+HEADERS += $$PWD/headlesspanel.h
+HEADERS += $$PWD/tracer.h
+HEADERS += $$PWD/protocolcapture.h
+HEADERS += $$PWD/metrics.h
+HEADERS += $$PWD/sessionpolicy.h
+contains(QMAKE_HOST.arch, "x86_64") {
+    HEADERS += $$PWD/slidewindow.h
+    HEADERS += $$PWD/glslidewidget.h
+    HEADERS += $$PWD/slidetransition.h
+    HEADERS += $$PWD/slideplaylist.h
+    HEADERS += $$PWD/slideloader.h
+    HEADERS += $$PWD/spotplayer.h
+}
+contains(QMAKE_HOST.arch, "armv7l") || contains(QMAKE_HOST.arch, "armv6l"): {
+    SOURCES += $$PWD/spotprocessplayer.cpp
+    HEADERS += $$PWD/spotprocessplayer.h
+}
+linux:!android {
+    SOURCES += $$PWD/v4l2capture.cpp
+    SOURCES += $$PWD/liveview.cpp
+    HEADERS += $$PWD/v4l2capture.h
+    HEADERS += $$PWD/liveview.h
+}
+
+contains(QMAKE_HOST.arch, "armv7l") || contains(QMAKE_HOST.arch, "armv6l"): {
+    DBUS_INTERFACES += $$PWD/slidewindow.xml
+    INCLUDEPATH += /usr/local/include
+    LIBS += -L"/usr/local/lib" -lpigpiod_if2 # To include libpigpiod_if2.so from /usr/local/lib
+}
+
+RESOURCES += \
+    $$PWD/panelchooser.qrc
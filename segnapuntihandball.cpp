@@ -31,6 +31,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "utility.h"
 #include "segnapuntihandball.h"
+#include "scoremodel.h"
+#include "tracer.h"
 
 
 /*!
@@ -63,7 +65,8 @@ SegnapuntiHandball::SegnapuntiHandball(const QString& myServerUrl, QFile *myLogF
     pal.setColor(QPalette::BrightText,    Qt::white);
     setPalette(pal);
 
-    maxTeamNameLen = 15;
+    maxTeamNameLen = ScoreModel::maxTeamNameLen;
+    pScoreModel = new ScoreModel(HANDBALL_PANEL, this);
 
 #ifdef Q_OS_ANDROID
     iTimeoutFontSize   = 28;
@@ -285,53 +288,40 @@ SegnapuntiHandball::onBinaryMessageReceived(QByteArray baMessage) {
  */
 void
 SegnapuntiHandball::onTextMessageReceived(QString sMessage) {
-    QString sToken;
-    bool ok;
     int iVal;
-    QString sNoData = QString("NoData");
-
-    sToken = XML_Parse(sMessage, "team0");
-    if(sToken != sNoData){
-      team[0]->setText(sToken.left(maxTeamNameLen));
-      int width = QGuiApplication::primaryScreen()->geometry().width();
-      iVal = 100;
-      for(int i=12; i<100; i++) {
-          QFontMetrics f(QFont("Arial", i, QFont::Black));
-          int rW = f.horizontalAdvance(team[0]->text()+"  ");
-          if(rW > width/2) {
-              iVal = i-1;
-              break;
-          }
-      }
-      team[0]->setFont(QFont("Arial", iVal, QFont::Black));
-    }// team0
-
-    sToken = XML_Parse(sMessage, "team1");
-    if(sToken != sNoData){
-      team[1]->setText(sToken.left(maxTeamNameLen));
-      int width = QGuiApplication::primaryScreen()->geometry().width();
-      iVal = 100;
-      for(int i=12; i<100; i++) {
-          QFontMetrics f(QFont("Arial", i, QFont::Black));
-          int rW = f.horizontalAdvance(team[1]->text()+"  ");
-          if(rW > width/2) {
-              iVal = i-1;
-              break;
-          }
-      }
-      team[1]->setFont(QFont("Arial", iVal, QFont::Black));
-    }// team1
-
-    sToken = XML_Parse(sMessage, "period");
-    if(sToken != sNoData) {
-        QStringList sArgs = sToken.split(",", Qt::SkipEmptyParts);
-        iVal = sArgs.at(0).toInt(&ok);
-        if(!ok || iVal<0 || iVal>99)
-            iVal = 99;
-        period->display(iVal);
-        iVal = sArgs.at(1).toInt(&ok);
-        if(!ok || iVal<0 || iVal>30)
-            iVal = 30;
+    QStringList fields = pScoreModel->update(sMessage);
+    pTracer->mark(Tracer::Parsed);
+
+    for(int iTeam=0; iTeam<2; iTeam++) {
+        if(fields.contains(QString("team%1").arg(iTeam))) {
+            team[iTeam]->setText(pScoreModel->text(QString("team%1").arg(iTeam)));
+            int width = QGuiApplication::primaryScreen()->geometry().width();
+            iVal = 100;
+            for(int i=12; i<100; i++) {
+                QFontMetrics f(QFont("Arial", i, QFont::Black));
+                int rW = f.horizontalAdvance(team[iTeam]->text()+"  ");
+                if(rW > width/2) {
+                    iVal = i-1;
+                    break;
+                }
+            }
+            team[iTeam]->setFont(QFont("Arial", iVal, QFont::Black));
+        }
+        if(fields.contains(QString("timeout%1").arg(iTeam))) {
+            iVal = pScoreModel->value(QString("timeout%1").arg(iTeam));
+            timeout[iTeam]->clear();
+            QString sTimeout = QString();
+            for(int i=0; i<iVal; i++)
+                sTimeout += QString("* ");
+            timeout[iTeam]->setText(sTimeout);
+        }
+        if(fields.contains(QString("score%1").arg(iTeam)))
+            score[iTeam]->display(pScoreModel->value(QString("score%1").arg(iTeam)));
+    }
+
+    if(fields.contains("period")) {
+        period->display(pScoreModel->value("period"));
+        iVal = pScoreModel->value("periodTime");
 #ifndef Q_OS_ANDROID
         requestData.clear();
         requestData.append(startMarker);
@@ -346,47 +336,8 @@ SegnapuntiHandball::onTextMessageReceived(QString sMessage) {
 #endif
     }// period
 
-    sToken = XML_Parse(sMessage, "timeout0");
-    if(sToken != sNoData){
-        iVal = sToken.toInt(&ok);
-        if(ok && iVal>=0 && iVal<4) {
-            timeout[0]->clear();
-            QString sTimeout = QString();
-            for(int i=0; i<iVal; i++)
-                sTimeout += QString("* ");
-            timeout[0]->setText(sTimeout);
-        }
-    }// timeout0
-
-    sToken = XML_Parse(sMessage, "timeout1");
-    if(sToken != sNoData){
-        iVal = sToken.toInt(&ok);
-        if(ok && iVal>=0 && iVal<4) {
-            timeout[1]->clear();
-            QString sTimeout = QString();
-            for(int i=0; i<iVal; i++)
-                sTimeout += QString("* ");
-            timeout[1]->setText(sTimeout);
-        }
-    }// timeout1
-
-    sToken = XML_Parse(sMessage, "score0");
-    if(sToken != sNoData){
-      iVal = sToken.toInt(&ok);
-      if(!ok || iVal<0 || iVal>999)
-        iVal = 999;
-      score[0]->display(iVal);
-    }// score0
-
-    sToken = XML_Parse(sMessage, "score1");
-    if(sToken != sNoData){
-      iVal = sToken.toInt(&ok);
-      if(!ok || iVal<0 || iVal>999)
-        iVal = 999;
-      score[1]->display(iVal);
-    }// score1
-
     ScorePanel::onTextMessageReceived(sMessage);
+    markDispatched();
 }
 
 
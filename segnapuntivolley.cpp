@@ -28,6 +28,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "segnapuntivolley.h"
 #include "timeoutwindow.h"
+#include "scoremodel.h"
+#include "tracer.h"
 #include "utility.h"
 
 
@@ -57,7 +59,8 @@ SegnapuntiVolley::SegnapuntiVolley(const QString &myServerUrl, QFile *myLogFile)
     pal.setColor(QPalette::BrightText,    Qt::white);
     setPalette(pal);
 
-    maxTeamNameLen = 15;
+    maxTeamNameLen = ScoreModel::maxTeamNameLen;
+    pScoreModel = new ScoreModel(VOLLEY_PANEL, this);
 
 #ifdef Q_OS_ANDROID
     iTimeoutFontSize = 28;
@@ -178,71 +181,34 @@ SegnapuntiVolley::onTextMessageReceived(QString sMessage) {
     int iVal;
     QString sNoData = QString("NoData");
 
-    sToken = XML_Parse(sMessage, "team0");
-    if(sToken != sNoData){
-      team[0]->setText(sToken.left(maxTeamNameLen));
-      int width = QGuiApplication::primaryScreen()->geometry().width();
-      iVal = 100;
-      for(int i=12; i<100; i++) {
-          QFontMetrics f(QFont("Arial", i, QFont::Black));
-          int rW = f.horizontalAdvance(team[0]->text()+"  ");
-          if(rW > width/2) {
-              iVal = i-1;
-              break;
-          }
-      }
-      team[0]->setFont(QFont("Arial", iVal, QFont::Black));
-    }// team0
-
-    sToken = XML_Parse(sMessage, "team1");
-    if(sToken != sNoData){
-      team[1]->setText(sToken.left(maxTeamNameLen));
-      int width = QGuiApplication::primaryScreen()->geometry().width();
-      iVal = 100;
-      for(int i=12; i<100; i++) {
-          QFontMetrics f(QFont("Arial", i, QFont::Black));
-          int rW = f.horizontalAdvance(team[1]->text()+"  ");
-          if(rW > width/2) {
-              iVal = i-1;
-              break;
-          }
-      }
-      team[1]->setFont(QFont("Arial", iVal, QFont::Black));
-    }// team1
-
-    sToken = XML_Parse(sMessage, "set0");
-    if(sToken != sNoData){
-      iVal = sToken.toInt(&ok);
-      if(!ok || iVal<0 || iVal>3)
-        iVal = 8;
-      set[0]->display(iVal);
-    }// set0
-
-    sToken = XML_Parse(sMessage, "set1");
-    if(sToken != sNoData){
-      iVal = sToken.toInt(&ok);
-      if(!ok || iVal<0 || iVal>3)
-        iVal = 8;
-      set[1]->display(iVal);
-    }// set1
-
-    sToken = XML_Parse(sMessage, "timeout0");
-    if(sToken != sNoData){
-      iVal = sToken.toInt(&ok);
-      if(!ok || iVal<0 || iVal>2)
-        iVal = 8;
-      timeout[0]->display(iVal);
-    }// timeout0
-
-    sToken = XML_Parse(sMessage, "timeout1");
-    if(sToken != sNoData){
-      iVal = sToken.toInt(&ok);
-      if(!ok || iVal<0 || iVal>2)
-        iVal = 8;
-      timeout[1]->display(iVal);
-    }// timeout1
+    QStringList fields = pScoreModel->update(sMessage);
+    pTracer->mark(Tracer::Parsed);
+
+    for(int iTeam=0; iTeam<2; iTeam++) {
+        if(fields.contains(QString("team%1").arg(iTeam))) {
+            team[iTeam]->setText(pScoreModel->text(QString("team%1").arg(iTeam)));
+            int width = QGuiApplication::primaryScreen()->geometry().width();
+            iVal = 100;
+            for(int i=12; i<100; i++) {
+                QFontMetrics f(QFont("Arial", i, QFont::Black));
+                int rW = f.horizontalAdvance(team[iTeam]->text()+"  ");
+                if(rW > width/2) {
+                    iVal = i-1;
+                    break;
+                }
+            }
+            team[iTeam]->setFont(QFont("Arial", iVal, QFont::Black));
+        }
+        if(fields.contains(QString("set%1").arg(iTeam)))
+            set[iTeam]->display(pScoreModel->value(QString("set%1").arg(iTeam)));
+        if(fields.contains(QString("timeout%1").arg(iTeam)))
+            timeout[iTeam]->display(pScoreModel->value(QString("timeout%1").arg(iTeam)));
+        if(fields.contains(QString("score%1").arg(iTeam)))
+            score[iTeam]->display(pScoreModel->value(QString("score%1").arg(iTeam)));
+    }
 
 #if !defined(Q_OS_ANDROID)
+    // Commands, not part of the score
     sToken = XML_Parse(sMessage, "startTimeout");
     if(sToken != sNoData) {
         iVal = sToken.toInt(&ok);
@@ -259,28 +225,8 @@ SegnapuntiVolley::onTextMessageReceived(QString sMessage) {
     }// timeout1
 #endif
 
-    sToken = XML_Parse(sMessage, "score0");
-    if(sToken != sNoData){
-      iVal = sToken.toInt(&ok);
-      if(!ok || iVal<0 || iVal>99)
-        iVal = 99;
-      score[0]->display(iVal);
-    }// score0
-
-    sToken = XML_Parse(sMessage, "score1");
-    if(sToken != sNoData){
-      iVal = sToken.toInt(&ok);
-      if(!ok || iVal<0 || iVal>99)
-        iVal = 99;
-      score[1]->display(iVal);
-    }// score1
-
-    sToken = XML_Parse(sMessage, "servizio");
-    if(sToken != sNoData){
-      iVal = sToken.toInt(&ok);
-      if(!ok || iVal<-1 || iVal>1)
-        iVal = 0;
-      iServizio = iVal;
+    if(fields.contains("servizio")) {
+      iServizio = pScoreModel->value("servizio");
       if(iServizio == -1) {
         servizio[0]->setText(" ");
         servizio[1]->setText(" ");
@@ -294,6 +240,7 @@ SegnapuntiVolley::onTextMessageReceived(QString sMessage) {
     }// servizio
 
     ScorePanel::onTextMessageReceived(sMessage);
+    markDispatched();
 }
 
 
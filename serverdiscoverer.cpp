@@ -28,15 +28,18 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "serverdiscoverer.h"
 #include "messagewindow.h"
 #include "utility.h"
+#include "sessionpolicy.h"
 #include "scorepanel.h"
 #include "segnapuntivolley.h"
 #include "segnapuntibasket.h"
 #include "segnapuntihandball.h"
 
 #define DISCOVERY_PORT 45453
-#define SERVER_PORT    45454
 
 #define SERVER_CONNECTION_TIMEOUT 3000
+#define DISCOVERY_WINDOW           500 // ms to wait for more Servers after the first answer
+#define SELECTION_WINDOW           300 // ms to wait for slower Servers after the first handshake
+#define LAST_SERVER_RETRY          250 // ms between the direct connection attempts to the last Server
 
 /*!
  * \brief ServerDiscoverer::ServerDiscoverer
@@ -56,9 +59,24 @@ ServerDiscoverer::ServerDiscoverer(QFile *myLogFile, QObject *parent)
     , discoveryAddress(QHostAddress("224.0.0.1"))
     , pNoServerWindow(Q_NULLPTR)
     , pScorePanel(Q_NULLPTR)
+    , bChecking(false)
+    , bTypeProvisional(false)
 {
     pNoServerWindow = new MessageWindow(Q_NULLPTR);
     pNoServerWindow->setDisplayedText(tr("In Attesa della Connessione con il Server"));
+
+    discoveryWindowTimer.setSingleShot(true);
+    connect(&discoveryWindowTimer, SIGNAL(timeout()),
+            this, SLOT(onDiscoveryWindowClosed()));
+    selectionWindowTimer.setSingleShot(true);
+    connect(&selectionWindowTimer, SIGNAL(timeout()),
+            this, SLOT(onSelectionWindowClosed()));
+    lastServerRetryTimer.setSingleShot(true);
+    connect(&lastServerRetryTimer, SIGNAL(timeout()),
+            this, SLOT(onTryLastServer()));
+    panelTypeTimer.setSingleShot(true);
+    connect(&panelTypeTimer, SIGNAL(timeout()),
+            this, SLOT(onPanelTypeNotConfirmed()));
 }
 
 
@@ -79,6 +97,10 @@ ServerDiscoverer::Discover() {
     bool bStarted = false;
     QString sMessage = "<getServer>"+ QHostInfo::localHostName() + "</getServer>";
     QByteArray datagram = sMessage.toUtf8();
+    candidates.clear();
+    bChecking = false;
+    bTypeProvisional = false;
+    panelTypeTimer.stop();
 
     if(pNoServerWindow == Q_NULLPTR) {
         pNoServerWindow = new MessageWindow(Q_NULLPTR);
@@ -138,11 +160,90 @@ ServerDiscoverer::Discover() {
         connect(&serverConnectionTimeoutTimer, SIGNAL(timeout()),
                 this, SLOT(onServerConnectionTimeout()));
         serverConnectionTimeoutTimer.start(SERVER_CONNECTION_TIMEOUT);
+        // Meanwhile try the last Server we were connected to
+        onTryLastServer();
     }
     return bStarted;
 }
 
 
+/*!
+ * \brief ServerDiscoverer::onTryLastServer Connect directly to the last used Server
+ *
+ * It runs in parallel with the multicast discovery: if the last
+ * Server answers first it is chosen without waiting for the others.
+ * A refused connection (e.g. the Server is restarting) is retried
+ * every LAST_SERVER_RETRY ms until the discovery ends.
+ * The Panel type remembered in the settings is only provisional:
+ * the Server may have changed sport meanwhile (see confirmPanelType()).
+ */
+void
+ServerDiscoverer::onTryLastServer() {
+    if(bChecking)
+        return;// The discovery already found the Servers
+    QSettings settings("Gabriele Salvato", "Score Panel");
+    QString sLastUrl = settings.value("server/lastUrl", QString()).toString();
+    if(sLastUrl.isEmpty())
+        return;
+    int iCandidate = -1;
+    for(int i=0; i<candidates.count(); i++) {
+        if(candidates.at(i).serverUrl == sLastUrl)
+            iCandidate = i;
+    }
+    if(iCandidate < 0) {
+        serverCandidate candidate;
+        candidate.serverUrl = sLastUrl;
+        candidate.panelType = settings.value("server/lastPanelType", FIRST_PANEL).toInt();
+        candidate.pSocket   = Q_NULLPTR;
+        candidate.rtt       = -1;
+        candidate.bFailed   = false;
+        candidate.bConfirmed = false;
+        candidates.append(candidate);
+        iCandidate = candidates.count()-1;
+    }
+    if(candidates.at(iCandidate).rtt >= 0)
+        return;// Already connected
+    if(candidates.at(iCandidate).pSocket && !candidates.at(iCandidate).bFailed)
+        return;// The handshake is still pending
+#ifdef LOG_VERBOSE
+    logMessage(logFile,
+               Q_FUNC_INFO,
+               QString("Trying last Server: %1").arg(sLastUrl));
+#endif
+    openCandidate(candidates[iCandidate]);
+}
+
+
+/*!
+ * \brief ServerDiscoverer::openCandidate Open a socket toward a candidate Server
+ * \param candidate
+ *
+ * A previous socket of the same candidate (a failed attempt)
+ * is discarded, so that only one handshake at a time is pending.
+ */
+void
+ServerDiscoverer::openCandidate(serverCandidate& candidate) {
+    if(candidate.pSocket) {
+        serverSocketArray.removeAll(candidate.pSocket);
+        candidate.pSocket->disconnect();
+        candidate.pSocket->abort();
+        candidate.pSocket->deleteLater();
+        candidate.pSocket = Q_NULLPTR;
+    }
+    candidate.rtt     = -1;
+    candidate.bFailed = false;
+    candidate.pSocket = new QWebSocket();
+    serverSocketArray.append(candidate.pSocket);
+    connect(candidate.pSocket, SIGNAL(connected()),
+            this, SLOT(onPanelServerConnected()));
+    connect(candidate.pSocket, SIGNAL(error(QAbstractSocket::SocketError)),
+            this, SLOT(onPanelServerSocketError(QAbstractSocket::SocketError)));
+    candidate.pSocket->ignoreSslErrors();
+    candidate.handshake.start();
+    candidate.pSocket->open(QUrl(candidate.serverUrl));
+}
+
+
 /*!
  * \brief ServerDiscoverer::onDiscoverySocketError
  * \param socketError
@@ -162,6 +263,8 @@ ServerDiscoverer::onDiscoverySocketError(QAbstractSocket::SocketError socketErro
  * \brief ServerDiscoverer::onProcessDiscoveryPendingDatagrams
  *
  * A Panel Server sent back an answer...
+ * The answers are collected for DISCOVERY_WINDOW ms
+ * so that all the Servers on the network become candidates.
  */
 void
 ServerDiscoverer::onProcessDiscoveryPendingDatagrams() {
@@ -191,74 +294,296 @@ ServerDiscoverer::onProcessDiscoveryPendingDatagrams() {
         serverList = QStringList(sToken.split(";",Qt::SkipEmptyParts));
         if(serverList.isEmpty())
             return;
+        if(bTypeProvisional) {// The Panel of the last Server is already running
+            confirmPanelType(serverList);
+            return;
+        }
 #ifdef LOG_VERBOSE
         logMessage(logFile,
                    Q_FUNC_INFO,
                    QString("Found %1 addresses")
                    .arg(serverList.count()));
 #endif
-        // A well formed answer has been received.
+        addCandidates(serverList);
+        if(candidates.isEmpty() || discoveryWindowTimer.isActive())
+            return;
+        // A well formed answer has been received:
+        // wait a little for the other Servers (if any)
         serverConnectionTimeoutTimer.stop();
         serverConnectionTimeoutTimer.disconnect();
-        // Remove all the "discovery sockets" to avoid overlapping
+        discoveryWindowTimer.start(DISCOVERY_WINDOW);
+    }
+}
+
+
+/*!
+ * \brief ServerDiscoverer::addCandidates Add the answering Servers to the candidates
+ * \param addressList A list of "address,panelType" strings
+ */
+void
+ServerDiscoverer::addCandidates(QStringList addressList) {
+    for(int i=0; i<addressList.count(); i++) {
+        QStringList arguments = QStringList(addressList.at(i).split(",",Qt::SkipEmptyParts));
+        if(arguments.count() < 2)
+            continue;
+        QString sUrl = QString("ws://%1:%2").arg(arguments.at(0)).arg(serverPort);
+        bool bKnown = false;
+        for(int j=0; j<candidates.count(); j++) {
+            if(candidates.at(j).serverUrl == sUrl) {
+                // The Server tells which Panel it wants now
+                candidates[j].panelType  = arguments.at(1).toInt();
+                candidates[j].bConfirmed = true;
+                bKnown = true;
+                break;
+            }
+        }
+        if(bKnown)
+            continue;
+        serverCandidate candidate;
+        candidate.serverUrl = sUrl;
+        candidate.panelType = arguments.at(1).toInt();// Each Server its own Panel
+        candidate.pSocket   = Q_NULLPTR;
+        candidate.rtt       = -1;
+        candidate.bFailed   = false;
+        candidate.bConfirmed = true;
+        candidates.append(candidate);
+    }
+}
+
+
+/*!
+ * \brief ServerDiscoverer::confirmPanelType Check the Panel started with the remembered type
+ * \param addressList A list of "address,panelType" strings
+ *
+ * If the running Server now wants a different Panel, the Panel is rebuilt.
+ */
+void
+ServerDiscoverer::confirmPanelType(QStringList addressList) {
+    for(int i=0; i<addressList.count(); i++) {
+        QStringList arguments = QStringList(addressList.at(i).split(",",Qt::SkipEmptyParts));
+        if(arguments.count() < 2)
+            continue;
+        QString sUrl = QString("ws://%1:%2").arg(arguments.at(0)).arg(serverPort);
+        if(sUrl != serverUrl)
+            continue;
+        panelTypeTimer.stop();
+        bTypeProvisional = false;
         cleanDiscoverySockets();
-        checkServerAddresses();
+        int advertisedType = arguments.at(1).toInt();
+        if(advertisedType == panelType)
+            return;
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("%1 now wants Panel %2 (was %3): rebuilding the Panel")
+                   .arg(serverUrl)
+                   .arg(advertisedType)
+                   .arg(panelType));
+        panelType = advertisedType;
+        QSettings settings("Gabriele Salvato", "Score Panel");
+        settings.setValue("server/lastPanelType", panelType);
+        startPanel();
+        return;
     }
 }
 
 
+/*!
+ * \brief ServerDiscoverer::onPanelTypeNotConfirmed
+ * No discovery answer from the running Server: the remembered Panel type is kept
+ */
+void
+ServerDiscoverer::onPanelTypeNotConfirmed() {
+    bTypeProvisional = false;
+    cleanDiscoverySockets();
+    logMessage(logFile,
+               Q_FUNC_INFO,
+               QString("Panel type of %1 not confirmed by the discovery").arg(serverUrl));
+}
+
+
+/*!
+ * \brief ServerDiscoverer::onDiscoveryWindowClosed
+ * No more answers are awaited: check the candidates
+ */
+void
+ServerDiscoverer::onDiscoveryWindowClosed() {
+    // Remove all the "discovery sockets" to avoid overlapping
+    cleanDiscoverySockets();
+    checkServerAddresses();
+}
+
+
 /*!
  * \brief ServerDiscoverer::checkServerAddresses
- * Try to connect to all the Panel Server addresses
+ * Try to connect to all the candidate Servers measuring the handshake time
  */
 void
 ServerDiscoverer::checkServerAddresses() {
-    panelType = FIRST_PANEL;
     connect(&serverConnectionTimeoutTimer, SIGNAL(timeout()),
             this, SLOT(onServerConnectionTimeout()));
     serverConnectionTimeoutTimer.start(SERVER_CONNECTION_TIMEOUT);
-    for(int i=0; i<serverList.count(); i++) {
-        QStringList arguments = QStringList(serverList.at(i).split(",",Qt::SkipEmptyParts));
-        if(arguments.count() > 1) {
-            serverUrl= QString("ws://%1:%2").arg(arguments.at(0)).arg(serverPort);
-            // Last Panel Type will win (is this right ?)
-            panelType = arguments.at(1).toInt();
+    bChecking = true;
+    lastServerRetryTimer.stop();
+    for(int i=0; i<candidates.count(); i++) {
+        if(candidates.at(i).rtt >= 0)
+            continue;// Already connected (the last Server)
 #ifdef LOG_VERBOSE
-            logMessage(logFile,
-                       Q_FUNC_INFO,
-                       QString("Trying Server URL: %1")
-                       .arg(serverUrl));
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Trying Server URL: %1")
+                   .arg(candidates.at(i).serverUrl));
 #endif
-            pPanelServerSocket = new QWebSocket();
-            serverSocketArray.append(pPanelServerSocket);
-            connect(pPanelServerSocket, SIGNAL(connected()),
-                    this, SLOT(onPanelServerConnected()));
-            connect(pPanelServerSocket, SIGNAL(error(QAbstractSocket::SocketError)),
-                    this, SLOT(onPanelServerSocketError(QAbstractSocket::SocketError)));
-            pPanelServerSocket->ignoreSslErrors();
-            pPanelServerSocket->open(QUrl(serverUrl));
-        }
+        openCandidate(candidates[i]);
     }
 }
 
 
 /*!
- * \brief ServerDiscoverer::onPanelServerConnected First come ... first served !
+ * \brief ServerDiscoverer::candidateIndex
+ * \param pSocket The socket opened toward a candidate
+ * \return The candidate index (-1 if not found)
+ */
+int
+ServerDiscoverer::candidateIndex(QWebSocket *pSocket) {
+    for(int i=0; i<candidates.count(); i++) {
+        if(candidates.at(i).pSocket == pSocket)
+            return i;
+    }
+    return -1;
+}
+
+
+/*!
+ * \brief ServerDiscoverer::anyCandidateConnected
+ * \return true if at least a candidate completed the handshake
+ */
+bool
+ServerDiscoverer::anyCandidateConnected() {
+    for(int i=0; i<candidates.count(); i++) {
+        if(candidates.at(i).rtt >= 0)
+            return true;
+    }
+    return false;
+}
+
+
+/*!
+ * \brief ServerDiscoverer::onPanelServerConnected
+ * A candidate completed the handshake: its time is recorded.
+ *
+ * The choice is made when all the candidates have answered
+ * or SELECTION_WINDOW ms after the first connection.
  */
 void
 ServerDiscoverer::onPanelServerConnected() {
+    QWebSocket* pSocket = qobject_cast<QWebSocket*>(sender());
+    int iCandidate = candidateIndex(pSocket);
+    if(iCandidate < 0)
+        return;
+    candidates[iCandidate].rtt = candidates.at(iCandidate).handshake.elapsed();
 #ifdef LOG_VERBOSE
     logMessage(logFile,
                Q_FUNC_INFO,
-               QString("Connected to Server URL: %1")
-               .arg(serverUrl));
+               QString("Connected to Server URL: %1 in %2ms")
+               .arg(candidates.at(iCandidate).serverUrl)
+               .arg(candidates.at(iCandidate).rtt));
 #endif
+    if(!bChecking) {
+        // The last Server answered before the discovery: no reason to wait
+        // (the discovery sockets are kept to confirm its Panel type)
+        discoveryWindowTimer.stop();
+        selectServer();
+        return;
+    }
+    bool bAllDone = true;
+    for(int i=0; i<candidates.count(); i++) {
+        if(candidates.at(i).rtt < 0 && !candidates.at(i).bFailed)
+            bAllDone = false;
+    }
+    if(bAllDone)
+        selectServer();
+    else if(!selectionWindowTimer.isActive())
+        selectionWindowTimer.start(SELECTION_WINDOW);
+}
+
+
+/*!
+ * \brief ServerDiscoverer::onSelectionWindowClosed
+ * The slower candidates are not waited any more
+ */
+void
+ServerDiscoverer::onSelectionWindowClosed() {
+    if(anyCandidateConnected())
+        selectServer();
+}
+
+
+/*!
+ * \brief ServerDiscoverer::selectServer Choose the fastest Server
+ *
+ * The other connected candidates are remembered (fastest first)
+ * for an immediate failover.
+ */
+void
+ServerDiscoverer::selectServer() {
     serverConnectionTimeoutTimer.stop();
     serverConnectionTimeoutTimer.disconnect();
-    QWebSocket* pSocket = qobject_cast<QWebSocket*>(sender());
-    serverUrl = pSocket->requestUrl().toString();
+    selectionWindowTimer.stop();
+    lastServerRetryTimer.stop();
+    bChecking = false;
     cleanServerSockets();
 
+    QVector<serverCandidate> connected;
+    for(int i=0; i<candidates.count(); i++) {
+        if(candidates.at(i).rtt < 0)
+            continue;
+        serverCandidate candidate = candidates.at(i);
+        candidate.pSocket = Q_NULLPTR;
+        // Keep the list sorted by handshake time (then by URL, to be consistent)
+        int j = 0;
+        while(j < connected.count() &&
+              (connected.at(j).rtt < candidate.rtt ||
+               (connected.at(j).rtt == candidate.rtt && connected.at(j).serverUrl < candidate.serverUrl)))
+            j++;
+        connected.insert(j, candidate);
+    }
+    candidates.clear();
+    if(connected.isEmpty()) {
+        restartDiscovery();
+        return;
+    }
+    serverUrl = connected.first().serverUrl;
+    panelType = connected.first().panelType;
+    bool bConfirmed = connected.first().bConfirmed;
+    connected.removeFirst();
+    fallbackServers = connected;
+    // To reconnect at once the next time
+    QSettings settings("Gabriele Salvato", "Score Panel");
+    settings.setValue("server/lastUrl", serverUrl);
+    settings.setValue("server/lastPanelType", panelType);
+    logMessage(logFile,
+               Q_FUNC_INFO,
+               QString("Selected Server %1 (%2 other candidates)")
+               .arg(serverUrl)
+               .arg(fallbackServers.count()));
+    startPanel();
+    if(!pScorePanel)
+        return;// Discovery restarted
+    // A remembered Panel type waits for the discovery answer
+    if(!bConfirmed && !discoverySocketArray.isEmpty()) {
+        bTypeProvisional = true;
+        panelTypeTimer.start(SERVER_CONNECTION_TIMEOUT);
+    }
+    else
+        cleanDiscoverySockets();
+}
+
+
+/*!
+ * \brief ServerDiscoverer::startPanel Create and show the Panel for the chosen Server
+ */
+void
+ServerDiscoverer::startPanel() {
     // Delete old Panel instance to prevent memory leaks
     if(pScorePanel) {
         pScorePanel->disconnect();
@@ -274,6 +599,15 @@ ServerDiscoverer::onPanelServerConnected() {
     else if(panelType == HANDBALL_PANEL) {
         pScorePanel = new SegnapuntiHandball(serverUrl, logFile);
     }
+    else {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Unknown Panel Type %1 from %2")
+                   .arg(panelType)
+                   .arg(serverUrl));
+        restartDiscovery();
+        return;
+    }
     connect(pScorePanel, SIGNAL(panelClosed()),
             this, SLOT(onPanelClosed()));
 
@@ -289,12 +623,27 @@ ServerDiscoverer::onPanelServerConnected() {
  */
 void
 ServerDiscoverer::onPanelServerSocketError(QAbstractSocket::SocketError error) {
+    QWebSocket* pSocket = qobject_cast<QWebSocket*>(sender());
     logMessage(logFile,
                Q_FUNC_INFO,
                QString("%1 %2 Error %3")
-               .arg(pPanelServerSocket->requestUrl().toString())
-               .arg(pPanelServerSocket->errorString())
+               .arg(pSocket->requestUrl().toString())
+               .arg(pSocket->errorString())
                .arg(error));
+    int iCandidate = candidateIndex(pSocket);
+    if(iCandidate < 0)
+        return;
+    candidates[iCandidate].bFailed = true;
+    if(!bChecking) {// The last Server is not ready yet: retry while discovering
+        lastServerRetryTimer.start(LAST_SERVER_RETRY);
+        return;
+    }
+    for(int i=0; i<candidates.count(); i++) {
+        if(candidates.at(i).rtt < 0 && !candidates.at(i).bFailed)
+            return;// Still waiting for someone
+    }
+    if(anyCandidateConnected())
+        selectServer();
 }
 
 
@@ -307,6 +656,24 @@ void
 ServerDiscoverer::onServerConnectionTimeout() {
     serverConnectionTimeoutTimer.stop();
     serverConnectionTimeoutTimer.disconnect();
+    if(anyCandidateConnected()) {
+        selectServer();
+        return;
+    }
+    restartDiscovery();
+}
+
+
+/*!
+ * \brief ServerDiscoverer::restartDiscovery Start again from the multicast discovery
+ */
+void
+ServerDiscoverer::restartDiscovery() {
+    discoveryWindowTimer.stop();
+    selectionWindowTimer.stop();
+    lastServerRetryTimer.stop();
+    panelTypeTimer.stop();
+    bTypeProvisional = false;
     if(pNoServerWindow == Q_NULLPTR) {
         pNoServerWindow = new MessageWindow(Q_NULLPTR);
         pNoServerWindow->setDisplayedText(tr("In Attesa della Connessione con il Server"));
@@ -316,6 +683,7 @@ ServerDiscoverer::onServerConnectionTimeout() {
         pNoServerWindow->showFullScreen();
     cleanDiscoverySockets();
     cleanServerSockets();
+    candidates.clear();
     // Restart the discovery process
     if(!Discover()) {
         delete pNoServerWindow;
@@ -327,6 +695,9 @@ ServerDiscoverer::onServerConnectionTimeout() {
 
 /*!
  * \brief ServerDiscoverer::onPanelClosed Invoked from the Score Panel when it closes
+ *
+ * The Servers that lost the last selection are tried first:
+ * the multicast discovery is needed only if none of them answers.
  */
 void
 ServerDiscoverer::onPanelClosed() {
@@ -337,13 +708,27 @@ ServerDiscoverer::onPanelClosed() {
     // No other window should obscure this one
     if(!pNoServerWindow->isVisible())
         pNoServerWindow->showFullScreen();
+    panelTypeTimer.stop();
+    bTypeProvisional = false;
     cleanDiscoverySockets();
     cleanServerSockets();
-    if(!Discover()) {
-        delete pNoServerWindow;
-        pNoServerWindow = Q_NULLPTR;
-        emit checkNetwork();
+    if(!fallbackServers.isEmpty()) {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Failing over to %1 known Servers")
+                   .arg(fallbackServers.count()));
+        candidates = fallbackServers;
+        fallbackServers.clear();
+        // Their handshake times are old: all of them are checked again
+        for(int i=0; i<candidates.count(); i++) {
+            candidates[i].rtt     = -1;
+            candidates[i].bFailed = false;
+            candidates[i].pSocket = Q_NULLPTR;
+        }
+        checkServerAddresses();
+        return;
     }
+    restartDiscovery();
 }
 
 
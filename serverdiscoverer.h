@@ -26,6 +26,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QSslError>
 #include <QTimer>
 #include <QSslError>
+#include <QElapsedTimer>
 
 QT_FORWARD_DECLARE_CLASS(QUdpSocket)
 QT_FORWARD_DECLARE_CLASS(QWebSocket)
@@ -49,7 +50,11 @@ private slots:
     void onPanelServerConnected();
     void onPanelServerSocketError(QAbstractSocket::SocketError error);
     void onServerConnectionTimeout();
+    void onDiscoveryWindowClosed();
+    void onSelectionWindowClosed();
+    void onTryLastServer();
     void onPanelClosed();
+    void onPanelTypeNotConfirmed();
 
 public:
     bool Discover();
@@ -60,8 +65,29 @@ protected:
 private:
     void cleanDiscoverySockets();
     void cleanServerSockets();
+    void addCandidates(QStringList addressList);
+    void confirmPanelType(QStringList addressList);
+    int  candidateIndex(QWebSocket *pSocket);
+    bool anyCandidateConnected();
+    void selectServer();
+    void startPanel();
+    void restartDiscovery();
 
 private:
+    /*!
+     * \brief A Panel Server answering the discovery
+     */
+    struct serverCandidate {
+        QString       serverUrl; /*!< \brief The Server URL */
+        int           panelType; /*!< \brief The Panel the Server wants */
+        QWebSocket   *pSocket;   /*!< \brief The socket used to measure the handshake */
+        QElapsedTimer handshake; /*!< \brief Started when the socket is opened */
+        qint64        rtt;       /*!< \brief The handshake time in ms (-1 if not connected) */
+        bool          bFailed;   /*!< \brief The connection failed */
+        bool          bConfirmed;/*!< \brief panelType comes from a discovery answer (not from the settings) */
+    };
+    void openCandidate(serverCandidate& candidate);
+
     QFile               *logFile;
     QList<QHostAddress>  broadcastAddress;
     QVector<QUdpSocket*> discoverySocketArray;
@@ -71,9 +97,16 @@ private:
     QHostAddress         discoveryAddress;
     int                  panelType;
     QStringList          serverList;
-    QWebSocket          *pPanelServerSocket;
+    QVector<serverCandidate> candidates;
+    QVector<serverCandidate> fallbackServers;
     QString              serverUrl;
     QTimer               serverConnectionTimeoutTimer;
+    QTimer               discoveryWindowTimer;
+    QTimer               selectionWindowTimer;
+    QTimer               lastServerRetryTimer;
+    QTimer               panelTypeTimer;
+    bool                 bChecking;
+    bool                 bTypeProvisional;
     MessageWindow       *pNoServerWindow;
     ScorePanel          *pScorePanel;
 };
@@ -0,0 +1,36 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef SESSIONPOLICY_H
+#define SESSIONPOLICY_H
+
+// How a Panel keeps its session with the Server
+// (shared with the tools that simulate the Panels)
+
+#define SERVER_PORT           45454
+#define SPOT_UPDATE_PORT      45455
+#define SLIDE_UPDATE_PORT     45456
+
+#define RESUME_FIRST_DELAY      100 // ms before the second reconnection attempt
+#define RESUME_MAX_DELAY       2000 // ms (the maximum backoff)
+#define RESUME_TIMEOUT        30000 // ms before giving up with the Server
+
+#define PING_MIN_INTERVAL      3000 // ms between two liveness checks...
+#define PING_JITTER            2000 // ...plus a random amount to spread the Panels
+
+#endif // SESSIONPOLICY_H
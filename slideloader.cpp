@@ -0,0 +1,63 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QPainter>
+
+#include "slideloader.h"
+
+
+/*!
+ * \brief SlideLoader::SlideLoader Decodes the slides on its own thread
+ * \param parent
+ */
+SlideLoader::SlideLoader(QObject *parent)
+    : QObject(parent)
+{
+}
+
+
+/*!
+ * \brief SlideLoader::loadSlide Decode an image and compose the slide to show
+ * \param sFileName The image file
+ * \param slideSize The size of the slide
+ *
+ * The image is scaled to fit the slide and centered on a white background.
+ * A null slide is returned if the image can't be decoded.
+ */
+void
+SlideLoader::loadSlide(QString sFileName, QSize slideSize) {
+    QImage image(sFileName);
+    if(image.isNull() || slideSize.isEmpty()) {
+        emit slideLoaded(sFileName, slideSize, QImage());
+        return;
+    }
+    QImage scaledImage = image.scaled(slideSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    QImage slide(slideSize, QImage::Format_ARGB32_Premultiplied);
+
+    int x = (slideSize.width()-scaledImage.width())/2;
+    int y = (slideSize.height()-scaledImage.height())/2;
+
+    QPainter painter(&slide);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.fillRect(slide.rect(), Qt::white);
+    painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    painter.drawImage(x, y, scaledImage);
+    painter.end();
+
+    emit slideLoaded(sFileName, slideSize, slide);
+}
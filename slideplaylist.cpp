@@ -0,0 +1,361 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QDir>
+#include <QFileInfo>
+#include <QThread>
+#include <QSettings>
+
+#include "slideplaylist.h"
+#include "slideloader.h"
+#include "utility.h"
+
+
+#define PREFETCH_DEPTH      3   // Slides decoded ahead of the next one
+#define MEMORY_BUDGET_MB    128 // Memory for the decoded slides
+
+
+/*!
+ * \brief SlidePlaylist::SlidePlaylist The ordered list of the slides to show
+ * \param myLogFile The File for message logging (if any)
+ * \param parent
+ *
+ * The slides are decoded, in display order, by a SlideLoader running
+ * on its own thread and kept in a LRU cache bounded by a memory budget.
+ */
+SlidePlaylist::SlidePlaylist(QFile *myLogFile, QObject *parent)
+    : QObject(parent)
+    , logFile(myLogFile)
+    , pLoaderThread(Q_NULLPTR)
+    , pLoader(Q_NULLPTR)
+{
+    sSlideDir = QDir::homePath();// Just to have a default location
+
+    QSettings settings("Gabriele Salvato", "Score Panel");
+    prefetchDepth = settings.value("slides/prefetch", PREFETCH_DEPTH).toInt();
+    budgetMB      = settings.value("slides/memoryMB", MEMORY_BUDGET_MB).toInt();
+    updateMaxCost();
+
+    pLoaderThread = new QThread();
+    pLoader = new SlideLoader();
+    pLoader->moveToThread(pLoaderThread);
+    connect(pLoaderThread, SIGNAL(finished()),
+            pLoader, SLOT(deleteLater()));
+    connect(this, SIGNAL(loadSlide(QString,QSize)),
+            pLoader, SLOT(loadSlide(QString,QSize)));
+    connect(pLoader, SIGNAL(slideLoaded(QString,QSize,QImage)),
+            this, SLOT(onSlideLoaded(QString,QSize,QImage)));
+    pLoaderThread->start(QThread::LowPriority);
+}
+
+
+/*!
+ * \brief SlidePlaylist::~SlidePlaylist
+ */
+SlidePlaylist::~SlidePlaylist() {
+    pLoaderThread->quit();
+    pLoaderThread->wait();
+    delete pLoaderThread;
+}
+
+
+/*!
+ * \brief SlidePlaylist::setSlideDir
+ * \param sNewDir The directory of the slides
+ */
+void
+SlidePlaylist::setSlideDir(QString sNewDir) {
+    if(sNewDir == sSlideDir)
+        return;
+    sSlideDir = sNewDir;
+    badFiles.clear();
+    update();
+}
+
+
+/*!
+ * \brief SlidePlaylist::setSlideSize
+ * \param newSize The size of the slides to show
+ *
+ * The slides decoded with a different size are discarded.
+ */
+void
+SlidePlaylist::setSlideSize(QSize newSize) {
+    if(newSize == slideSize)
+        return;
+    slideSize = newSize;
+    cache.clear();
+    pendingFiles.clear();// Results of the older size will be dropped
+    updateMaxCost();
+}
+
+
+/*!
+ * \brief SlidePlaylist::setPrefetch
+ * \param newDepth Number of slides to decode ahead of the next one
+ * \param newBudgetMB Memory (in MB) for the decoded slides
+ */
+void
+SlidePlaylist::setPrefetch(int newDepth, int newBudgetMB) {
+    prefetchDepth = qMax(0, newDepth);
+    budgetMB      = qMax(1, newBudgetMB);
+    updateMaxCost();
+    QSettings settings("Gabriele Salvato", "Score Panel");
+    settings.setValue("slides/prefetch", prefetchDepth);
+    settings.setValue("slides/memoryMB", budgetMB);
+}
+
+
+/*!
+ * \brief SlidePlaylist::slideCost
+ * \return The memory (in KB) taken by a decoded slide
+ */
+int
+SlidePlaylist::slideCost() {
+    return qMax(1, slideSize.width()*slideSize.height()*4/1024);
+}
+
+
+/*!
+ * \brief SlidePlaylist::updateMaxCost Apply the memory budget to the cache (cost in KB)
+ *
+ * Whatever the budget, the present and the next slide must fit
+ * together: otherwise they would evict each other and
+ * the loader would decode them forever.
+ */
+void
+SlidePlaylist::updateMaxCost() {
+    cache.setMaxCost(qMax(budgetMB*1024, 2*slideCost()));
+}
+
+
+/*!
+ * \brief SlidePlaylist::setPlaylist Set the order of the slides
+ * \param sPlaylist "file[,dwell ms[,transition]];file[,...]"
+ *
+ * An empty playlist means: all the images in the slide directory.
+ */
+void
+SlidePlaylist::setPlaylist(QString sPlaylist) {
+    requestedList.clear();
+    QStringList items = sPlaylist.split(";", Qt::SkipEmptyParts);
+    for(int i=0; i<items.count(); i++) {
+        QStringList fields = items.at(i).split(",");
+        slideEntry entry;
+        entry.sFileName  = fields.at(0).trimmed();
+        entry.dwellTime  = -1;
+        entry.transition = -1;
+        bool ok;
+        if(fields.count() > 1) {
+            entry.dwellTime = fields.at(1).toInt(&ok);
+            if(!ok || entry.dwellTime <= 0)
+                entry.dwellTime = -1;
+        }
+        if(fields.count() > 2) {
+            entry.transition = fields.at(2).toInt(&ok);
+            if(!ok || entry.transition < 0)
+                entry.transition = -1;
+        }
+        if(!entry.sFileName.isEmpty())
+            requestedList.append(entry);
+    }
+    badFiles.clear();
+    update();
+#ifdef LOG_VERBOSE
+    logMessage(logFile,
+               Q_FUNC_INFO,
+               QString("%1 slides in the playlist").arg(entries.count()));
+#endif
+}
+
+
+/*!
+ * \brief SlidePlaylist::update Rebuild the playlist from the slides present on disk
+ *
+ * To be called from time to time since the slides may be updated
+ * while the show is running.
+ */
+void
+SlidePlaylist::update() {
+    QDir slideDir(sSlideDir);
+    entries.clear();
+    if(!slideDir.exists())
+        return;
+    QVector<slideEntry> candidates;
+    if(requestedList.isEmpty()) {
+        QStringList nameFilter = QStringList()
+                << "*.jpg" << "*.jpeg" << "*.png"
+                << "*.JPG" << "*.JPEG" << "*.PNG";
+        slideDir.setNameFilters(nameFilter);
+        slideDir.setFilter(QDir::Files);
+        QFileInfoList slideList = slideDir.entryInfoList();
+        for(int i=0; i<slideList.count(); i++) {
+            slideEntry entry;
+            entry.sFileName  = slideList.at(i).absoluteFilePath();
+            entry.dwellTime  = -1;
+            entry.transition = -1;
+            candidates.append(entry);
+        }
+    }
+    else {
+        for(int i=0; i<requestedList.count(); i++) {
+            slideEntry entry = requestedList.at(i);
+            entry.sFileName = slideDir.absoluteFilePath(entry.sFileName);
+            candidates.append(entry);
+        }
+    }
+    for(int i=0; i<candidates.count(); i++) {
+        QFileInfo fileInfo(candidates.at(i).sFileName);
+        if(!fileInfo.exists())
+            continue;
+        if(badFiles.contains(fileInfo.absoluteFilePath())) {
+            // Retry only if the file has been changed
+            if(badFiles.value(fileInfo.absoluteFilePath()) == fileInfo.lastModified())
+                continue;
+            badFiles.remove(fileInfo.absoluteFilePath());
+            cache.remove(fileInfo.absoluteFilePath());
+        }
+        entries.append(candidates.at(i));
+    }
+}
+
+
+/*!
+ * \brief SlidePlaylist::count
+ * \return The number of slides in the playlist
+ */
+int
+SlidePlaylist::count() {
+    return entries.count();
+}
+
+
+/*!
+ * \brief SlidePlaylist::slide
+ * \param index Position in the playlist
+ * \return The decoded slide or a null image if it is not ready yet
+ *
+ * A slide not yet decoded is requested to the loader and
+ * slideReady() will be emitted when available.
+ */
+QImage
+SlidePlaylist::slide(int index) {
+    if(index < 0 || index >= entries.count())
+        return QImage();
+    QString sFileName = entries.at(index).sFileName;
+    QImage* pSlide = cache.object(sFileName);// Refresh the LRU order too
+    if(pSlide)
+        return *pSlide;
+    requestSlide(sFileName);
+    return QImage();
+}
+
+
+/*!
+ * \brief SlidePlaylist::dwellTime
+ * \param index Position in the playlist
+ * \return The show time (ms) of the slide or -1 for the default
+ */
+int
+SlidePlaylist::dwellTime(int index) {
+    if(index < 0 || index >= entries.count())
+        return -1;
+    return entries.at(index).dwellTime;
+}
+
+
+/*!
+ * \brief SlidePlaylist::transition
+ * \param index Position in the playlist
+ * \return The transition leading to the slide or -1 for the default
+ */
+int
+SlidePlaylist::transition(int index) {
+    if(index < 0 || index >= entries.count())
+        return -1;
+    return entries.at(index).transition;
+}
+
+
+/*!
+ * \brief SlidePlaylist::prefetch Request the slides that will be shown after the present one
+ * \param fromIndex The present slide
+ *
+ * The depth is limited so that the prefetched slides, the present
+ * and the next one stay in the memory budget.
+ */
+void
+SlidePlaylist::prefetch(int fromIndex) {
+    int nSlides = entries.count();
+    if(nSlides == 0 || slideSize.isEmpty())
+        return;
+    int nToLoad = qMin(2+prefetchDepth, qMax(2, cache.maxCost()/slideCost()));
+    nToLoad = qMin(nToLoad, nSlides);
+    for(int i=0; i<nToLoad; i++) {
+        QString sFileName = entries.at((fromIndex+i) % nSlides).sFileName;
+        if(!cache.contains(sFileName))
+            requestSlide(sFileName);
+    }
+}
+
+
+/*!
+ * \brief SlidePlaylist::requestSlide Ask the loader for a slide (only once)
+ * \param sFileName The image file
+ */
+void
+SlidePlaylist::requestSlide(QString sFileName) {
+    if(pendingFiles.contains(sFileName) || slideSize.isEmpty())
+        return;
+    pendingFiles.insert(sFileName);
+    emit loadSlide(sFileName, slideSize);
+}
+
+
+/*!
+ * \brief SlidePlaylist::onSlideLoaded A slide has been decoded by the loader
+ * \param sFileName The image file
+ * \param loadedSize The size requested for the slide
+ * \param loadedSlide The slide (null if the image can't be decoded)
+ */
+void
+SlidePlaylist::onSlideLoaded(QString sFileName, QSize loadedSize, QImage loadedSlide) {
+    if(loadedSize != slideSize)
+        return;// Requested before a resize
+    pendingFiles.remove(sFileName);
+    if(loadedSlide.isNull()) {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Unable to decode %1").arg(sFileName));
+        badFiles.insert(sFileName, QFileInfo(sFileName).lastModified());
+        update();// Drop it from the playlist
+    }
+    else {
+        int cost = qMax(qint64(1), qint64(loadedSlide.sizeInBytes()/1024));
+        if(!cache.insert(sFileName, new QImage(loadedSlide), int(cost))) {
+            // Asking it again would only loop on the same rejection
+            logMessage(logFile,
+                       Q_FUNC_INFO,
+                       QString("%1 (%2 KB) exceeds the slide memory budget")
+                       .arg(sFileName)
+                       .arg(cost));
+            return;
+        }
+    }
+    emit slideReady();
+}
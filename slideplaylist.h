@@ -0,0 +1,91 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef SLIDEPLAYLIST_H
+#define SLIDEPLAYLIST_H
+
+#include <QObject>
+#include <QCache>
+#include <QImage>
+#include <QSet>
+#include <QHash>
+#include <QDateTime>
+#include <QSize>
+#include <QVector>
+
+
+QT_FORWARD_DECLARE_CLASS(QFile)
+QT_FORWARD_DECLARE_CLASS(QThread)
+QT_FORWARD_DECLARE_CLASS(SlideLoader)
+
+
+class SlidePlaylist : public QObject
+{
+    Q_OBJECT
+
+public:
+    SlidePlaylist(QFile *myLogFile = Q_NULLPTR, QObject *parent = Q_NULLPTR);
+    ~SlidePlaylist();
+    void setSlideDir(QString sNewDir);
+    void setSlideSize(QSize newSize);
+    void setPrefetch(int newDepth, int newBudgetMB);
+    void setPlaylist(QString sPlaylist);
+    void update();
+    int count();
+    QImage slide(int index);
+    int dwellTime(int index);
+    int transition(int index);
+    void prefetch(int fromIndex);
+
+signals:
+    void slideReady();/*!< A requested slide has been decoded (or has been dropped) */
+    void loadSlide(QString sFileName, QSize slideSize);
+
+private slots:
+    void onSlideLoaded(QString sFileName, QSize loadedSize, QImage loadedSlide);
+
+private:
+    void requestSlide(QString sFileName);
+    int  slideCost();
+    void updateMaxCost();
+
+private:
+    /*!
+     * \brief The slideEntry struct An element of the playlist
+     */
+    struct slideEntry {
+        QString sFileName; /*!< Absolute path of the image */
+        int dwellTime;     /*!< Show time (ms) or -1 for the default */
+        int transition;    /*!< SlideWindow::transitionMode or -1 for the default */
+    };
+
+    QFile* logFile;
+    QString sSlideDir;
+    QVector<slideEntry> requestedList;
+    QVector<slideEntry> entries;
+    QCache<QString, QImage> cache;
+    QSet<QString> pendingFiles;
+    QHash<QString, QDateTime> badFiles;
+    QSize slideSize;
+    int prefetchDepth;
+    int budgetMB;
+    QThread* pLoaderThread;
+    SlideLoader* pLoader;
+};
+
+#endif // SLIDEPLAYLIST_H
@@ -0,0 +1,272 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QPainter>
+#include <QRandomGenerator>
+
+#include "slidetransition.h"
+#include "slidewindow.h"
+#include "glslidewidget.h"
+
+
+#define BLINDS_STRIPES    12 // Number of stripes of the Blinds transition
+#define DISSOLVE_BLOCK    32 // Size (in pixels) of the Dissolve blocks
+
+
+/*!
+ * \brief SlideTransition::create Factory of the slide transitions
+ * \param mode One of the SlideWindow::transitionMode values
+ * \return The transition (Abrupt for unknown modes)
+ */
+SlideTransition*
+SlideTransition::create(int mode) {
+    switch(mode) {
+    case SlideWindow::transition_FromLeft:
+        return new FromLeftTransition();
+    case SlideWindow::transition_Fade:
+        return new FadeTransition();
+    case SlideWindow::transition_Fold:
+        return new FoldTransition();
+    case SlideWindow::transition_Blinds:
+        return new BlindsTransition();
+    case SlideWindow::transition_Dissolve:
+        return new DissolveTransition();
+    default:
+        return new AbruptTransition();
+    }
+}
+
+
+/*!
+ * \brief SlideTransition::SlideTransition
+ */
+SlideTransition::SlideTransition()
+    : width(0)
+    , height(0)
+{
+}
+
+
+/*!
+ * \brief SlideTransition::~SlideTransition
+ */
+SlideTransition::~SlideTransition() {
+}
+
+
+/*!
+ * \brief SlideTransition::isAnimated
+ * \return false if the slides have to be swapped without a transition
+ */
+bool
+SlideTransition::isAnimated() {
+    return true;
+}
+
+
+/*!
+ * \brief SlideTransition::glTransition
+ * \return The GLSlideWidget::glTransition able to render it or -1 if none
+ */
+int
+SlideTransition::glTransition() {
+    return -1;
+}
+
+
+/*!
+ * \brief SlideTransition::prepare Called once per transition
+ * \param present The slide shown at the transition start
+ * \param next The slide shown at the transition end
+ *
+ * The lookup tables of the transition have to be computed here
+ * and not in renderStep().
+ */
+void
+SlideTransition::prepare(const QPixmap& present, const QPixmap& next) {
+    presentPixmap = present;
+    nextPixmap    = next;
+    width         = present.width();
+    height        = present.height();
+}
+
+
+/*!
+ * \brief AbruptTransition::isAnimated
+ * \return false: the slides are simply swapped
+ */
+bool
+AbruptTransition::isAnimated() {
+    return false;
+}
+
+
+/*!
+ * \brief AbruptTransition::renderStep
+ * \param t The transition progress (0.0 - 1.0)
+ * \param out The painter to render the step on
+ */
+void
+AbruptTransition::renderStep(double t, QPainter* out) {
+    out->drawPixmap(0, 0, t < 1.0 ? presentPixmap : nextPixmap);
+}
+
+
+/*!
+ * \brief FromLeftTransition::renderStep The next slide pushes the present one to the right
+ * \param t The transition progress (0.0 - 1.0)
+ * \param out The painter to render the step on
+ */
+void
+FromLeftTransition::renderStep(double t, QPainter* out) {
+    int nextWidth = int(width*t+0.5);
+    out->drawPixmap(QRect(0, 0, nextWidth, height),
+                    nextPixmap,
+                    QRect(width-nextWidth, 0, nextWidth, height));
+    out->drawPixmap(QRect(nextWidth, 0, width-nextWidth, height),
+                    presentPixmap,
+                    QRect(0, 0, width-nextWidth, height));
+}
+
+
+/*!
+ * \brief FadeTransition::glTransition
+ * \return The shader able to render the Fade
+ */
+int
+FadeTransition::glTransition() {
+    return GLSlideWidget::glTransition_Fade;
+}
+
+
+/*!
+ * \brief FadeTransition::renderStep Cross fade of the two slides
+ * \param t The transition progress (0.0 - 1.0)
+ * \param out The painter to render the step on
+ */
+void
+FadeTransition::renderStep(double t, QPainter* out) {
+    out->drawPixmap(0, 0, presentPixmap);
+    out->setOpacity(t);
+    out->drawPixmap(0, 0, nextPixmap);
+    out->setOpacity(1.0);
+}
+
+
+/*!
+ * \brief FoldTransition::glTransition
+ * \return The shader able to render the Fold (FromLeft on the CPU)
+ */
+int
+FoldTransition::glTransition() {
+    return GLSlideWidget::glTransition_Fold;
+}
+
+
+/*!
+ * \brief BlindsTransition::prepare Compute the stripes once per transition
+ * \param present The slide shown at the transition start
+ * \param next The slide shown at the transition end
+ */
+void
+BlindsTransition::prepare(const QPixmap& present, const QPixmap& next) {
+    SlideTransition::prepare(present, next);
+    stripes.clear();
+    stripes.reserve(BLINDS_STRIPES);
+    for(int i=0; i<BLINDS_STRIPES; i++) {
+        int x0 = (width*i)/BLINDS_STRIPES;
+        int x1 = (width*(i+1))/BLINDS_STRIPES;
+        stripes.append(QRect(x0, 0, x1-x0, height));
+    }
+}
+
+
+/*!
+ * \brief BlindsTransition::renderStep The next slide opens like venetian blinds
+ * \param t The transition progress (0.0 - 1.0)
+ * \param out The painter to render the step on
+ */
+void
+BlindsTransition::renderStep(double t, QPainter* out) {
+    out->drawPixmap(0, 0, presentPixmap);
+    for(int i=0; i<stripes.count(); i++) {
+        const QRect& stripe = stripes.at(i);
+        int w = int(stripe.width()*t+0.5);
+        if(w > 0)
+            out->drawPixmap(stripe.x(), stripe.y(), nextPixmap,
+                            stripe.x(), stripe.y(), w, stripe.height());
+    }
+}
+
+
+/*!
+ * \brief DissolveTransition::prepare Compute, once per transition, the order of the blocks
+ * \param present The slide shown at the transition start
+ * \param next The slide shown at the transition end
+ *
+ * A new order for each transition, from a generator of its own
+ * (the global rand() sequence is left alone).
+ */
+void
+DissolveTransition::prepare(const QPixmap& present, const QPixmap& next) {
+    SlideTransition::prepare(present, next);
+    blocks.clear();
+    for(int y=0; y<height; y+=DISSOLVE_BLOCK) {
+        for(int x=0; x<width; x+=DISSOLVE_BLOCK) {
+            blocks.append(QRect(x, y,
+                                qMin(DISSOLVE_BLOCK, width-x),
+                                qMin(DISSOLVE_BLOCK, height-y)));
+        }
+    }
+    // Fisher-Yates shuffle
+    QRandomGenerator generator(QRandomGenerator::global()->generate());
+    for(int i=blocks.count()-1; i>0; i--) {
+        int j = int(generator.bounded(i+1));
+        qSwap(blocks[i], blocks[j]);
+    }
+}
+
+
+/*!
+ * \brief DissolveTransition::renderStep The next slide appears block by block
+ * \param t The transition progress (0.0 - 1.0)
+ * \param out The painter to render the step on
+ *
+ * The image depends on t alone (a repaint gives the same step):
+ * the first blocks of the order are revealed. The slide covering
+ * most of the step is drawn whole, so at most half of the blocks
+ * are drawn over it.
+ */
+void
+DissolveTransition::renderStep(double t, QPainter* out) {
+    int nBlocks = qBound(0, int(blocks.count()*t+0.5), blocks.count());
+    if(nBlocks <= blocks.count()/2) {
+        out->drawPixmap(0, 0, presentPixmap);
+        for(int i=0; i<nBlocks; i++) {
+            const QRect& block = blocks.at(i);
+            out->drawPixmap(block.topLeft(), nextPixmap, block);
+        }
+    }
+    else {
+        out->drawPixmap(0, 0, nextPixmap);
+        for(int i=nBlocks; i<blocks.count(); i++) {
+            const QRect& block = blocks.at(i);
+            out->drawPixmap(block.topLeft(), presentPixmap, block);
+        }
+    }
+}
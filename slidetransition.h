@@ -0,0 +1,102 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef SLIDETRANSITION_H
+#define SLIDETRANSITION_H
+
+#include <QPixmap>
+#include <QVector>
+#include <QRect>
+
+
+QT_FORWARD_DECLARE_CLASS(QPainter)
+
+
+class SlideTransition
+{
+public:
+    static SlideTransition* create(int mode);
+    virtual ~SlideTransition();
+    virtual bool isAnimated();
+    virtual int glTransition();
+    virtual void prepare(const QPixmap& present, const QPixmap& next);
+    virtual void renderStep(double t, QPainter* out) = 0;
+
+protected:
+    SlideTransition();
+
+protected:
+    QPixmap presentPixmap;
+    QPixmap nextPixmap;
+    int width;
+    int height;
+};
+
+
+class AbruptTransition : public SlideTransition
+{
+public:
+    bool isAnimated();
+    void renderStep(double t, QPainter* out);
+};
+
+
+class FromLeftTransition : public SlideTransition
+{
+public:
+    void renderStep(double t, QPainter* out);
+};
+
+
+class FadeTransition : public SlideTransition
+{
+public:
+    int glTransition();
+    void renderStep(double t, QPainter* out);
+};
+
+
+class FoldTransition : public FromLeftTransition
+{
+public:
+    int glTransition();
+};
+
+
+class BlindsTransition : public SlideTransition
+{
+public:
+    void prepare(const QPixmap& present, const QPixmap& next);
+    void renderStep(double t, QPainter* out);
+
+private:
+    QVector<QRect> stripes;
+};
+
+
+class DissolveTransition : public SlideTransition
+{
+public:
+    void prepare(const QPixmap& present, const QPixmap& next);
+    void renderStep(double t, QPainter* out);
+
+private:
+    QVector<QRect> blocks;
+};
+
+#endif // SLIDETRANSITION_H
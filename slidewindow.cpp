@@ -20,31 +20,46 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QDebug>
 #include <QPainter>
 #include <QApplication>
+#include <QSettings>
 
 #include "slidewindow.h"
+#include "glslidewidget.h"
+#include "slidetransition.h"
+#include "slideplaylist.h"
+#include "utility.h"
+#include "metrics.h"
+#include "binarylog.h"
 
 
 #define STEADY_SHOW_TIME       5000// Change slide time
 #define TRANSITION_TIME        3000 // Transition duration
-#define TRANSITION_GRANULARITY 30   // Steps to complete transition
+#define FRAME_INTERVAL         16   // Frame period (msec) when not paced by the GPU
 
 
 /*!
  * \brief SlideWindow::SlideWindow Slide Window constructor for Ubuntu
+ * \param myLogFile The File for message logging (if any)
  * \param parent
  */
-SlideWindow::SlideWindow(QWidget *parent)
+SlideWindow::SlideWindow(QFile *myLogFile, QWidget *parent)
     : QLabel(tr("In Attesa delle Slides"))
-    , pPresentImage(Q_NULLPTR)
-    , pNextImage(Q_NULLPTR)
-    , pPresentImageToShow(Q_NULLPTR)
-    , pNextImageToShow(Q_NULLPTR)
-    , pShownImage(Q_NULLPTR)
+    , logFile(myLogFile)
+    , pPlaylist(Q_NULLPTR)
+    , nextPixmapKey(0)
+    , pGLWidget(Q_NULLPTR)
+    , pTransition(Q_NULLPTR)
     , iCurrentSlide(0)
+    , iNextSlide(0)
+    , bNextPending(false)
+    , bWaitingSlide(false)
     , steadyShowTime(STEADY_SHOW_TIME)
     , transitionTime(TRANSITION_TIME)
-    , transitionGranularity(TRANSITION_GRANULARITY)
-    , transitionStepNumber(0)
+    , transitionProgress(0.0)
+    , bInTransition(false)
+    , frameCount(0)
+    , lateFrames(0)
+    , maxFrameTime(0)
+    , totalFrameTime(0)
 #ifdef Q_OS_ANDROID
     , transitionType(transition_Abrupt)
 #else
@@ -52,18 +67,46 @@ SlideWindow::SlideWindow(QWidget *parent)
 //    , transitionType(transition_FromLeft)
     , transitionType(transition_Fade)
 #endif
+    , activeTransition(transitionType)
     , bRunning(false)
 {
     Q_UNUSED(parent);
 
-    sSlideDir = QDir::homePath();// Just to have a default location
     setAlignment(Qt::AlignCenter);
     setMinimumSize(QSize(320, 240));
 
+    pTransition = SlideTransition::create(activeTransition);
+
+    // The slides are decoded ahead of time on a separate thread
+    pPlaylist = new SlidePlaylist(logFile, this);
+    pPlaylist->setSlideDir(QDir::homePath());// Just to have a default location
+    connect(pPlaylist, SIGNAL(slideReady()),
+            this, SLOT(onSlideReady()));
+
+    // The transition progress is computed from the elapsed time:
+    // the timer only asks for a new frame.
+    transitionTimer.setTimerType(Qt::PreciseTimer);
+
     connect(&transitionTimer, SIGNAL(timeout()),
             this, SLOT(onTransitionTimeElapsed()));
     connect(&showTimer, SIGNAL(timeout()),
             this, SLOT(onNewSlideTimer()));
+
+#ifndef Q_OS_ANDROID
+    // Fade and Fold transitions are rendered by the GPU (if any).
+    // The CPU composition remains as a fallback.
+    QSettings settings("Gabriele Salvato", "Score Panel");
+    if(settings.value("slides/openGL", true).toBool()) {
+        pGLWidget = new GLSlideWidget(logFile, this);
+        pGLWidget->hide();
+        connect(pGLWidget, SIGNAL(glUnavailable()),
+                this, SLOT(onGLUnavailable()));
+        // On the GPU the next frame is requested as soon as
+        // the previous one has been swapped (vsync paced)
+        connect(pGLWidget, SIGNAL(frameSwapped()),
+                this, SLOT(onTransitionTimeElapsed()));
+    }
+#endif
 }
 
 
@@ -71,11 +114,7 @@ SlideWindow::SlideWindow(QWidget *parent)
  * \brief SlideWindow::~SlideWindow
  */
 SlideWindow::~SlideWindow() {
-    if(pPresentImageToShow) delete pPresentImageToShow;
-    if(pNextImageToShow)    delete pNextImageToShow;
-    if(pShownImage)         delete pShownImage;
-    if(pPresentImage)       delete pPresentImage;
-    if(pNextImage)          delete pNextImage;
+    if(pTransition) delete pTransition;
 }
 
 
@@ -85,106 +124,73 @@ SlideWindow::~SlideWindow() {
  */
 void
 SlideWindow::setSlideDir(QString sNewDir) {
-    sSlideDir = sNewDir;
+    pPlaylist->setSlideDir(sNewDir);
 }
 
 
 /*!
- * \brief SlideWindow::isReady
- * \return
+ * \brief SlideWindow::setPlaylist Set the order, show times and transitions of the slides
+ * \param sPlaylist "file[,dwell ms[,transition]];file[,...]" (empty for all the slides)
+ *
+ * The new playlist starts from its first slide.
  */
-bool
-SlideWindow::isReady() {
-    return (pPresentImage != Q_NULLPTR && pNextImage != Q_NULLPTR);
+void
+SlideWindow::setPlaylist(QString sPlaylist) {
+    pPlaylist->setPlaylist(sPlaylist);
+    if(bInTransition) {
+        transitionTimer.stop();
+        bInTransition = false;
+    }
+    iCurrentSlide = 0;
+    presentSlide = QImage();
+    nextSlide    = QImage();
+    loadSlides();
+    if(bRunning)
+        showTimer.start(slideDwellTime());
 }
 
 
 /*!
- * \brief SlideWindow::updateSlideList
+ * \brief SlideWindow::setPrefetch
+ * \param newDepth Number of slides decoded ahead of the next one
+ * \param newBudgetMB Memory (in MB) for the decoded slides
  */
 void
-SlideWindow::updateSlideList() {
-    // Update slide list just in case we are updating the slide directory...
-    slideList = QFileInfoList();
-    QDir slideDir(sSlideDir);
-    if(slideDir.exists()) {
-        QStringList nameFilter = QStringList()
-                << "*.jpg" << "*.jpeg" << "*.png"
-                << "*.JPG" << "*.JPEG" << "*.PNG";
-        slideDir.setNameFilters(nameFilter);
-        slideDir.setFilter(QDir::Files);
-        slideList = slideDir.entryInfoList();
-    }
+SlideWindow::setPrefetch(int newDepth, int newBudgetMB) {
+    pPlaylist->setPrefetch(newDepth, newBudgetMB);
+    pPlaylist->prefetch(iCurrentSlide);
+}
+
+
+/*!
+ * \brief SlideWindow::isReady
+ * \return
+ */
+bool
+SlideWindow::isReady() {
+    return (!presentSlide.isNull() && !nextSlide.isNull());
 }
 
 
 /*!
- * \brief SlideWindow::addNewImage
- * \param image
+ * \brief SlideWindow::loadSlides Show the present slide and get the next one
+ *
+ * Slides not yet decoded will be picked up by onSlideReady().
  */
 void
-SlideWindow::addNewImage(QImage image) {
-    QImage* pImage = new QImage(image);
-    if(pPresentImage == Q_NULLPTR) {// That's the first image...
-        pPresentImage = pImage;
-        pNextImage    = Q_NULLPTR;
-        updateSlideList();
-        if(slideList.count() > 1) {
-            iCurrentSlide += 1;
-            iCurrentSlide = iCurrentSlide % slideList.count();
-            pNextImage = new QImage(slideList.at(iCurrentSlide).absoluteFilePath());
-        }
-    }
-    else if(pNextImage == Q_NULLPTR) {
-        pNextImage    = pImage;
-
-        QImage scaledPresentImage = pPresentImage->scaled(size(), Qt::KeepAspectRatio);
-        QImage scaledNextImage    = pNextImage->scaled(size(), Qt::KeepAspectRatio);
-
-        if(pPresentImageToShow) delete pPresentImageToShow;
-        if(pNextImageToShow)    delete pNextImageToShow;
-        if(pShownImage)         delete pShownImage;
-
-        pPresentImageToShow = new QImage(size(), QImage::Format_ARGB32_Premultiplied);
-        pNextImageToShow    = new QImage(size(), QImage::Format_ARGB32_Premultiplied);
-        pShownImage         = new QImage(size(), QImage::Format_ARGB32_Premultiplied);
-
-        int x = (size().width()-scaledPresentImage.width())/2;
-        int y = (size().height()-scaledPresentImage.height())/2;
-
-        QPainter presentPainter(pPresentImageToShow);
-        presentPainter.setCompositionMode(QPainter::CompositionMode_Source);
-        presentPainter.fillRect(rect(), Qt::white);
-        presentPainter.setCompositionMode(QPainter::CompositionMode_SourceOver);
-        presentPainter.drawImage(x, y, scaledPresentImage);
-        presentPainter.end();
-
-        x = (size().width()-scaledNextImage.width())/2;
-        y = (size().height()-scaledNextImage.height())/2;
-
-        QPainter nextPainter(pNextImageToShow);
-        nextPainter.setCompositionMode(QPainter::CompositionMode_Source);
-        nextPainter.fillRect(rect(), Qt::white);
-        nextPainter.setCompositionMode(QPainter::CompositionMode_SourceOver);
-        nextPainter.drawImage(x, y, scaledNextImage);
-        nextPainter.end();
-
-        computeRegions(&rectSourcePresent, &rectDestinationPresent,
-                       &rectSourceNext,    &rectDestinationNext);
-
-        QPainter painter(pShownImage);
-        painter.setCompositionMode(QPainter::CompositionMode_Source);
-        painter.drawImage(rectDestinationNext, *pNextImageToShow, rectSourceNext);
-        painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
-        painter.drawImage(rectDestinationPresent, *pPresentImageToShow, rectSourcePresent);
-        painter.end();
-
-        setPixmap(QPixmap::fromImage(*pShownImage));
-    }
-    else {
-        delete pPresentImage;
-        pPresentImage = pNextImage;
-        pNextImage = pImage;
+SlideWindow::loadSlides() {
+    int nSlides = pPlaylist->count();
+    if(nSlides == 0)
+        return;
+    iCurrentSlide = iCurrentSlide % nSlides;
+    iNextSlide    = (iCurrentSlide+1) % nSlides;
+    presentSlide  = pPlaylist->slide(iCurrentSlide);
+    nextSlide     = pPlaylist->slide(iNextSlide);
+    bNextPending  = false;
+    pPlaylist->prefetch(iCurrentSlide);
+    if(isReady()) {
+        prepareTransition();
+        showTransitionStep();
     }
 }
 
@@ -194,21 +200,11 @@ SlideWindow::addNewImage(QImage image) {
  */
 void
 SlideWindow::startSlideShow() {
-    updateSlideList();
-    if(slideList.count() > 0) {
-        if(pPresentImage == Q_NULLPTR) {// That's the first image...
-            addNewImage(QImage(slideList.at(0).absoluteFilePath()));
-            iCurrentSlide = 0;
-            if(slideList.count() > 1) {
-                addNewImage(QImage(slideList.at(1).absoluteFilePath()));
-                iCurrentSlide = 1;
-            }
-            else {// Only one image is in the directory
-                addNewImage(*pPresentImage);
-            }
-        }
-    }
-    showTimer.start(steadyShowTime);
+    pPlaylist->setSlideSize(size());
+    pPlaylist->update();
+    if(!isReady())
+        loadSlides();
+    showTimer.start(slideDwellTime());
     bRunning = true;
 }
 
@@ -220,6 +216,8 @@ void
 SlideWindow::stopSlideShow() {
     showTimer.stop();
     transitionTimer.stop();
+    bInTransition = false;
+    bWaitingSlide = false;
     bRunning = false;
 }
 
@@ -231,6 +229,8 @@ void
 SlideWindow::pauseSlideShow() {
     showTimer.stop();
     transitionTimer.stop();
+    bInTransition = false;
+    bWaitingSlide = false;
     bRunning = false;
 }
 
@@ -246,25 +246,38 @@ SlideWindow::isRunning() {
 
 
 /*!
- * \brief SlideWindow::computeRegions
- * \param sourcePresent
- * \param destinationPresent
- * \param sourceNext
- * \param destinationNext
+ * \brief SlideWindow::setTransitionMode Select the default transition between the slides
+ * \param newMode One of the transitionMode values
+ * \return false if the mode is unknown
+ *
+ * A running transition is completed with the previous mode.
+ * The transitions given in the playlist take precedence.
  */
-void
-SlideWindow::computeRegions(QRect* sourcePresent, QRect* destinationPresent,
-               QRect* sourceNext,    QRect* destinationNext) {
-    double percent = double(transitionStepNumber)/double(transitionGranularity);
-    *sourcePresent = QRect(0, 0,
-                           int(width()*(1.0-percent)+0.5), height());
-    *destinationPresent = *sourcePresent;
-    destinationPresent->translate(width()*percent, 0);
-
-    *sourceNext = QRect(int(double(width())*(1.0-percent)+0.5), 0,
-                        int(width()*percent+0.5), height());
-    *destinationNext = QRect(0, 0,
-                             int(width()*percent+0.5), height());
+bool
+SlideWindow::setTransitionMode(int newMode) {
+    if(newMode < transition_Abrupt || newMode > transition_Dissolve)
+        return false;
+    if(newMode == transitionType)
+        return true;
+    transitionType = transitionMode(newMode);
+    if(!bInTransition && isReady()) {
+        prepareTransition();
+        showTransitionStep();
+    }
+    return true;
+}
+
+
+/*!
+ * \brief SlideWindow::slideDwellTime
+ * \return The show time (ms) of the present slide
+ */
+int
+SlideWindow::slideDwellTime() {
+    int dwellTime = pPlaylist->dwellTime(iCurrentSlide);
+    if(dwellTime <= 0)
+        dwellTime = steadyShowTime;
+    return dwellTime;
 }
 
 
@@ -288,192 +301,311 @@ SlideWindow::keyPressEvent(QKeyEvent *event) {
 /*!
  * \brief SlideWindow::resizeEvent
  * \param event
+ *
+ * The slides have to be decoded again at the new size.
  */
 void
 SlideWindow::resizeEvent(QResizeEvent *event) {
     mySize = event->size();
-    if(pPresentImage==Q_NULLPTR || pNextImage==Q_NULLPTR) {
-        event->accept();
+    if(pGLWidget)
+        pGLWidget->setGeometry(rect());
+    pPlaylist->setSlideSize(size());
+    if(bInTransition) {
+        transitionTimer.stop();
+        bInTransition = false;
+        if(bRunning)
+            showTimer.start(slideDwellTime());
+    }
+    presentSlide = QImage();
+    nextSlide    = QImage();
+    loadSlides();
+    event->accept();
+}
+
+
+/*!
+ * \brief SlideWindow::onSlideReady A slide has been decoded
+ */
+void
+SlideWindow::onSlideReady() {
+    if(bInTransition)
+        return;// Will be picked up at the transition end
+    if(!isReady()) {
+        loadSlides();
         return;
     }
-    QImage scaledPresentImage = pPresentImage->scaled(size(), Qt::KeepAspectRatio);
-    QImage scaledNextImage    = pNextImage->scaled(size(), Qt::KeepAspectRatio);
-
-    if(pPresentImageToShow) delete pPresentImageToShow;
-    if(pNextImageToShow)    delete pNextImageToShow;
-    if(pShownImage)         delete pShownImage;
-
-    pPresentImageToShow = new QImage(size(), QImage::Format_ARGB32_Premultiplied);
-    pNextImageToShow    = new QImage(size(), QImage::Format_ARGB32_Premultiplied);
-    pShownImage         = new QImage(size(), QImage::Format_ARGB32_Premultiplied);
-
-    int x = (size().width()-scaledPresentImage.width())/2;
-    int y = (size().height()-scaledPresentImage.height())/2;
-
-    QPainter presentPainter(pPresentImageToShow);
-    presentPainter.setCompositionMode(QPainter::CompositionMode_Source);
-    presentPainter.fillRect(rect(), Qt::white);
-    presentPainter.setCompositionMode(QPainter::CompositionMode_SourceOver);
-    presentPainter.drawImage(x, y, scaledPresentImage);
-    presentPainter.end();
-
-    x = (size().width()-scaledNextImage.width())/2;
-    y = (size().height()-scaledNextImage.height())/2;
-
-    QPainter nextPainter(pNextImageToShow);
-    nextPainter.setCompositionMode(QPainter::CompositionMode_Source);
-    nextPainter.fillRect(rect(), Qt::white);
-    nextPainter.setCompositionMode(QPainter::CompositionMode_SourceOver);
-    nextPainter.drawImage(x, y, scaledNextImage);
-    nextPainter.end();
-
-    computeRegions(&rectSourcePresent, &rectDestinationPresent,
-                   &rectSourceNext,    &rectDestinationNext);
-
-    QPainter painter(pShownImage);
-    painter.setCompositionMode(QPainter::CompositionMode_Source);
-    painter.drawImage(rectDestinationNext, *pNextImageToShow, rectSourceNext);
-    painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
-    painter.drawImage(rectDestinationPresent, *pPresentImageToShow, rectSourcePresent);
-    painter.end();
-
-    setPixmap(QPixmap::fromImage(*pShownImage));
+    if(!bNextPending)
+        return;
+    if(pPlaylist->count() > 0)
+        iNextSlide = iNextSlide % pPlaylist->count();
+    QImage slide = pPlaylist->slide(iNextSlide);
+    if(slide.isNull())
+        return;
+    nextSlide = slide;
+    bNextPending = false;
+    prepareTransition();
+    if(bWaitingSlide) {
+        bWaitingSlide = false;
+        onNewSlideTimer();
+    }
 }
 
 
 /*!
  * \brief SlideWindow::onNewSlideTimer
+ *
+ * The transition starts only if the next slide has already been decoded:
+ * otherwise the present slide is kept until onSlideReady().
  */
 void
 SlideWindow::onNewSlideTimer() {
-    updateSlideList();
-    if(slideList.count() == 0) {// Still no slides !
+    pPlaylist->update();
+    if(pPlaylist->count() == 0) {// Still no slides !
         return;
     }
-    if(pPresentImage == Q_NULLPTR) {// That's the first image...
-        addNewImage(QImage(slideList.at(0).absoluteFilePath()));
-        iCurrentSlide = 0;
-    }
-    if(pPresentImage == Q_NULLPTR) {
-        if(slideList.count() > 1) {
-            addNewImage(QImage(slideList.at(1).absoluteFilePath()));
-            iCurrentSlide = 1;
-        }
-        else {// Only one image is in the directory
-            addNewImage(*pPresentImage);
-        }
+    if(!isReady()) {// Still waiting for the first slides
+        loadSlides();
+        return;
     }
-    if(transitionType == transition_FromLeft) {
+    if(bNextPending) {
         showTimer.stop();
-        transitionStepNumber = 0;
-        transitionTimer.start(int(double(transitionTime)/double(transitionGranularity)));
+        bWaitingSlide = true;
+        return;
     }
-    else if(transitionType == transition_Abrupt) {
-        transitionStepNumber = 0;
-        if(pPresentImageToShow) delete pPresentImageToShow;
-        *pPresentImage = *pNextImage;
-        pPresentImageToShow = pNextImageToShow;
-        if(slideList.count() == 0) {
-            return;
-        }
-        iCurrentSlide += 1;
-        iCurrentSlide = iCurrentSlide % slideList.count();
-        addNewImage(QImage(slideList.at(iCurrentSlide).absoluteFilePath()));
-        QImage scaledNextImage = pNextImage->scaled(size(), Qt::KeepAspectRatio);
-        pNextImageToShow = new QImage(size(), QImage::Format_ARGB32_Premultiplied);
-
-        if(pShownImage) delete pShownImage;
-        pShownImage = new QImage(size(), QImage::Format_ARGB32_Premultiplied);
-        int x = (size().width()-scaledNextImage.width())/2;
-        int y = (size().height()-scaledNextImage.height())/2;
-
-        QPainter nextPainter(pNextImageToShow);
-        nextPainter.setCompositionMode(QPainter::CompositionMode_Source);
-        nextPainter.fillRect(rect(), Qt::white);
-        nextPainter.setCompositionMode(QPainter::CompositionMode_SourceOver);
-        nextPainter.drawImage(x, y, scaledNextImage);
-        nextPainter.end();
-
-        computeRegions(&rectSourcePresent, &rectDestinationPresent,
-                       &rectSourceNext,    &rectDestinationNext);
-        QPainter painter(pShownImage);
-        painter.setCompositionMode(QPainter::CompositionMode_Source);
-        painter.drawImage(rectDestinationNext, *pNextImageToShow, rectSourceNext);
-        painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
-        painter.drawImage(rectDestinationPresent, *pPresentImageToShow, rectSourcePresent);
-        painter.end();
-
-        setPixmap(QPixmap::fromImage(*pShownImage));
+    if(pTransition->isAnimated()) {
+        startTransition();
     }
-    else if (transitionType == transition_Fade) {
-        showTimer.stop();
-        transitionStepNumber = 0;
-        transitionTimer.start(int(double(transitionTime)/double(transitionGranularity)));
+    else {
+        advanceSlide();
+        showTransitionStep();
+        showTimer.start(slideDwellTime());
+    }
+}
+
+
+/*!
+ * \brief SlideWindow::advanceSlide The next slide becomes the present one
+ *
+ * The slide after it should have already been prefetched.
+ */
+void
+SlideWindow::advanceSlide() {
+    transitionProgress = 0.0;
+    presentSlide  = nextSlide;
+    iCurrentSlide = iNextSlide;
+    pPlaylist->update();
+    int nSlides = pPlaylist->count();
+    if(nSlides == 0) {// Slides removed: keep showing the last one
+        prepareTransition();
+        return;
     }
-    // else if (transitionType == other types...
+    iCurrentSlide = iCurrentSlide % nSlides;
+    iNextSlide    = (iCurrentSlide+1) % nSlides;
+    nextSlide     = pPlaylist->slide(iNextSlide);
+    bNextPending  = nextSlide.isNull();
+    if(bNextPending) {
+        nextSlide = presentSlide;
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Slide %1 not yet decoded").arg(iNextSlide));
+    }
+    pPlaylist->prefetch(iCurrentSlide);
+    prepareTransition();
+}
+
+
+/*!
+ * \brief SlideWindow::startTransition Start a transition from the present slide to the next
+ *
+ * The transition lasts transitionTime msec whatever the frame rate:
+ * if the frames can't be produced in time they are simply fewer.
+ */
+void
+SlideWindow::startTransition() {
+    showTimer.stop();
+    transitionProgress = 0.0;
+    frameCount     = 0;
+    lateFrames     = 0;
+    maxFrameTime   = 0;
+    totalFrameTime = 0;
+    bInTransition  = true;
+    transitionClock.start();
+    frameClock.start();
+    if(isGLTransition())
+        onTransitionTimeElapsed();// Then paced by frameSwapped()
+    else
+        transitionTimer.start(FRAME_INTERVAL);
+}
+
+
+/*!
+ * \brief SlideWindow::logFrameTimings Log the frame timings of the last transition
+ *
+ * Always logged if some frame took more than two frame periods.
+ */
+void
+SlideWindow::logFrameTimings() {
+    if(frameCount < 2)
+        return;
+    QString sMessage = QString("%1 frames in %2 ms: mean %3 ms, max %4 ms, %5 late")
+                       .arg(frameCount)
+                       .arg(transitionClock.elapsed())
+                       .arg(double(totalFrameTime)/double(frameCount-1), 0, 'f', 1)
+                       .arg(maxFrameTime)
+                       .arg(lateFrames);
+#ifndef LOG_VERBOSE
+    if(lateFrames > 0)
+#endif
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   sMessage);
 }
 
 
 /*!
- * \brief SlideWindow::onTransitionTimeElapsed
+ * \brief SlideWindow::onTransitionTimeElapsed Produce a new frame of the transition
  */
 void
 SlideWindow::onTransitionTimeElapsed() {
-    if(pPresentImage==Q_NULLPTR ||
-       pNextImage==Q_NULLPTR ||
-       pShownImage==Q_NULLPTR) return;
-    transitionStepNumber++;
-    if(transitionStepNumber > transitionGranularity) {
+    if(!bInTransition) return;
+    if(!isReady()) return;
+    qint64 frameTime = frameClock.restart();
+    if(frameCount > 0) {
+        totalFrameTime += frameTime;
+        maxFrameTime = qMax(maxFrameTime, frameTime);
+        if(frameTime > 2*FRAME_INTERVAL) {
+            lateFrames++;
+            Metrics::add(Metrics::SlideLateFrames);
+        }
+        BinaryLog::record(BinaryLog::SlideFrame, frameCount, frameTime);
+#if defined(LOG_VERBOSE) && !defined(LOG_BINARY)
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Frame %1: %2 ms").arg(frameCount).arg(frameTime));
+#endif
+    }
+    frameCount++;
+    Metrics::add(Metrics::SlideFrames);
+    transitionProgress = double(transitionClock.elapsed())/double(transitionTime);
+    if(transitionProgress >= 1.0) {
         transitionTimer.stop();
-        transitionStepNumber = 0;
-        if(pPresentImageToShow) delete pPresentImageToShow;
-        *pPresentImage = *pNextImage;
-        pPresentImageToShow = pNextImageToShow;
-        updateSlideList();
-        if(slideList.count() == 0) {
-            return;
+        bInTransition = false;
+        logFrameTimings();
+        advanceSlide();
+        showTimer.start(slideDwellTime());
+    }
+    showTransitionStep();
+}
+
+
+/*!
+ * \brief SlideWindow::isGLTransition
+ * \return true if the present transition is rendered with OpenGL
+ */
+bool
+SlideWindow::isGLTransition() {
+    return pGLWidget != Q_NULLPTR &&
+           pGLWidget->isUsable() &&
+           pTransition->glTransition() >= 0;
+}
+
+
+/*!
+ * \brief SlideWindow::prepareTransition Prepare the two slides of the next transition
+ *
+ * The slides are handed to the GPU or converted, only once per transition,
+ * into the two pixmaps given to the transition engine.
+ * The transition leading to the next slide is selected here.
+ */
+void
+SlideWindow::prepareTransition() {
+    if(!bInTransition) {
+        int newTransition = pPlaylist->transition(iNextSlide);
+        if(newTransition < transition_Abrupt || newTransition > transition_Dissolve)
+            newTransition = transitionType;
+        if(newTransition != activeTransition) {
+            delete pTransition;
+            pTransition = SlideTransition::create(newTransition);
+            activeTransition = newTransition;
         }
-        iCurrentSlide += 1;
-        iCurrentSlide = iCurrentSlide % slideList.count();
-        addNewImage(QImage(slideList.at(iCurrentSlide).absoluteFilePath()));
-
-        QImage scaledNextImage = pNextImage->scaled(size(), Qt::KeepAspectRatio);
-        pNextImageToShow    = new QImage(size(), QImage::Format_ARGB32_Premultiplied);
-
-        if(pShownImage) delete pShownImage;
-        pShownImage = new QImage(size(), QImage::Format_ARGB32_Premultiplied);
-        int x = (size().width()-scaledNextImage.width())/2;
-        int y = (size().height()-scaledNextImage.height())/2;
-
-        QPainter nextPainter(pNextImageToShow);
-        nextPainter.setCompositionMode(QPainter::CompositionMode_Source);
-        nextPainter.fillRect(rect(), Qt::white);
-        nextPainter.setCompositionMode(QPainter::CompositionMode_SourceOver);
-        nextPainter.drawImage(x, y, scaledNextImage);
-        nextPainter.end();
-
-        showTimer.start(steadyShowTime);
     }
-    if(transitionType == transition_FromLeft) {
-        computeRegions(&rectSourcePresent, &rectDestinationPresent,
-                       &rectSourceNext,    &rectDestinationNext);
-        QPainter painter(pShownImage);
-        painter.setCompositionMode(QPainter::CompositionMode_Source);
-        painter.drawImage(rectDestinationNext, *pNextImageToShow, rectSourceNext);
-        painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
-        painter.drawImage(rectDestinationPresent, *pPresentImageToShow, rectSourcePresent);
-        painter.end();
+    if(isGLTransition()) {
+        pGLWidget->setTransition(pTransition->glTransition());
+        pGLWidget->setSlides(presentSlide, nextSlide);
+        pGLWidget->setGeometry(rect());
+        if(!pGLWidget->isVisible())
+            pGLWidget->show();
+        presentPixmap = QPixmap();
+        nextPixmap    = QPixmap();
+        nextPixmapKey = 0;
+        return;
     }
-    else if (transitionType == transition_Fade) {
-        QPainter painter(pShownImage);
-        qreal opacity = qreal(transitionStepNumber)/qreal(transitionGranularity);
-        painter.setOpacity(opacity);
-        painter.setCompositionMode(QPainter::CompositionMode_Source);
-        painter.drawImage(0, 0, *pNextImageToShow);
-        painter.setOpacity(1.0-opacity);
-        painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
-        painter.drawImage(0, 0, *pPresentImageToShow);
-        painter.end();
+    if(pGLWidget)
+        pGLWidget->hide();
+    // The previous "next" slide is now the "present" one: reuse its pixmap
+    if(!nextPixmap.isNull() && presentSlide.cacheKey() == nextPixmapKey)
+        presentPixmap = nextPixmap;
+    else
+        presentPixmap = QPixmap::fromImage(presentSlide);
+    if(nextSlide.cacheKey() == presentSlide.cacheKey())
+        nextPixmap = presentPixmap;
+    else
+        nextPixmap = QPixmap::fromImage(nextSlide);
+    nextPixmapKey = nextSlide.cacheKey();
+    pTransition->prepare(presentPixmap, nextPixmap);
+}
+
+
+/*!
+ * \brief SlideWindow::showTransitionStep Show the present step of the transition
+ *
+ * On the GPU only the progress has to be updated, otherwise
+ * a repaint is scheduled.
+ */
+void
+SlideWindow::showTransitionStep() {
+    if(isGLTransition()) {
+        pGLWidget->setProgress(transitionProgress);
+        return;
+    }
+    update();
+}
+
+
+/*!
+ * \brief SlideWindow::paintEvent Render the present step of the transition
+ * \param event The paint event
+ */
+void
+SlideWindow::paintEvent(QPaintEvent *event) {
+    if(isGLTransition() && pGLWidget->isVisible()) {
+        event->accept();
+        return;
+    }
+    if(presentPixmap.isNull() || nextPixmap.isNull()) {
+        QLabel::paintEvent(event);// "In Attesa delle Slides"
+        return;
+    }
+    QPainter painter(this);
+    pTransition->renderStep(transitionProgress, &painter);
+}
+
+
+/*!
+ * \brief SlideWindow::onGLUnavailable Fall back to the CPU composition
+ */
+void
+SlideWindow::onGLUnavailable() {
+    if(pGLWidget) {
+        pGLWidget->disconnect();
+        pGLWidget->hide();
+        pGLWidget->deleteLater();
+        pGLWidget = Q_NULLPTR;
     }
-    setPixmap(QPixmap::fromImage(*pShownImage));
+    if(isReady())
+        prepareTransition();
+    // No more frameSwapped(): the timer will pace the frames
+    if(bInTransition)
+        transitionTimer.start(FRAME_INTERVAL);
+    showTransitionStep();
 }
@@ -21,26 +21,34 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QTimer>
 #include <QLabel>
-#include <QFileInfoList>
+#include <QImage>
+#include <QElapsedTimer>
 
 #include <qevent.h>
 
 
+QT_FORWARD_DECLARE_CLASS(QFile)
+QT_FORWARD_DECLARE_CLASS(GLSlideWidget)
+QT_FORWARD_DECLARE_CLASS(SlideTransition)
+QT_FORWARD_DECLARE_CLASS(SlidePlaylist)
+
 class SlideWindow : public QLabel
 {
     Q_OBJECT
 
 public:
-    SlideWindow(QWidget *parent = Q_NULLPTR);
+    SlideWindow(QFile *myLogFile = Q_NULLPTR, QWidget *parent = Q_NULLPTR);
     ~SlideWindow();
     void setSlideDir(QString sNewDir);
     void keyPressEvent(QKeyEvent *event);
-    void addNewImage(QImage image);
     void startSlideShow();
     void stopSlideShow();
     void pauseSlideShow();
     bool isReady();
     bool isRunning();
+    bool setTransitionMode(int newMode);
+    void setPlaylist(QString sPlaylist);
+    void setPrefetch(int newDepth, int newBudgetMB);
 
 public:
     /*!
@@ -49,42 +57,64 @@ public:
     enum transitionMode {
         transition_Abrupt,/*!< Abrupt transition */
         transition_FromLeft,/*!< Enter from Left */
-        transition_Fade/*!< Fade Out - Fade In */
+        transition_Fade,/*!< Fade Out - Fade In */
+        transition_Fold,/*!< Page Fold (From Left without OpenGL) */
+        transition_Blinds,/*!< Venetian Blinds */
+        transition_Dissolve/*!< Random blocks */
     };
 
 private:
-    void computeRegions(QRect* sourcePresent, QRect* destinationPresent, QRect* sourceNext, QRect* destinationNext);
-    void updateSlideList();
+    void loadSlides();
+    void advanceSlide();
+    int slideDwellTime();
+    bool isGLTransition();
+    void prepareTransition();
+    void startTransition();
+    void logFrameTimings();
+    void showTransitionStep();
 
 public slots:
     void onNewSlideTimer();
     void onTransitionTimeElapsed();
     void resizeEvent(QResizeEvent *event);
+    void paintEvent(QPaintEvent *event);
+
+private slots:
+    void onGLUnavailable();
+    void onSlideReady();
 
 private:
-    QString sSlideDir;
-    QFileInfoList slideList;
-    QImage* pPresentImage;
-    QImage* pNextImage;
-    QImage* pPresentImageToShow;
-    QImage* pNextImageToShow;
-    QImage* pShownImage;
+    QFile* logFile;
+    SlidePlaylist* pPlaylist;
+    QImage presentSlide;
+    QImage nextSlide;
+    QPixmap presentPixmap;
+    QPixmap nextPixmap;
+    qint64 nextPixmapKey;
+    GLSlideWidget* pGLWidget;
+    SlideTransition* pTransition;
 
     QTimer showTimer;
     QTimer transitionTimer;
 
     int iCurrentSlide;
+    int iNextSlide;
+    bool bNextPending;
+    bool bWaitingSlide;
     int steadyShowTime;
     int transitionTime;
-    int transitionGranularity;
-    int transitionStepNumber;
+    double transitionProgress;
+    bool bInTransition;
+    QElapsedTimer transitionClock;
+    QElapsedTimer frameClock;
+    int frameCount;
+    int lateFrames;
+    qint64 maxFrameTime;
+    qint64 totalFrameTime;
     QSize mySize;
-    QRect rectSourcePresent;
-    QRect rectSourceNext;
-    QRect rectDestinationPresent;
-    QRect rectDestinationNext;
 
     transitionMode transitionType;
+    int activeTransition;
     bool bRunning;
 };
 
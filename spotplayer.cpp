@@ -0,0 +1,409 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QDir>
+#include <QUrl>
+#include <QKeyEvent>
+#include <QStackedLayout>
+#include <QVideoWidget>
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    #include <QAudioOutput>
+#endif
+
+#include "spotplayer.h"
+#include "utility.h"
+#include "mediaprobe.h"
+
+
+#define STALL_MARGIN   5000 // ms beyond the probed duration before giving up a spot
+#define STALL_FALLBACK 300000 // ms before giving up a spot with unknown duration
+
+
+/*!
+ * \brief SpotPlayer::SpotPlayer In-process player for the spot loop
+ * \param myLogFile The File for message logging (if any)
+ * \param parent
+ *
+ * Two media players are used alternately: while one is playing
+ * the other has already opened the next spot, so the switch
+ * between two spots needs no process start nor decoder set up.
+ */
+SpotPlayer::SpotPlayer(QFile *myLogFile, QWidget *parent)
+    : QWidget(parent)
+    , logFile(myLogFile)
+    , iActive(0)
+    , iCurrentSpot(0)
+    , nFailures(0)
+    , bPlaying(false)
+{
+    QPalette pal(palette());
+    pal.setColor(QPalette::Window, Qt::black);
+    setPalette(pal);
+    setAutoFillBackground(true);
+
+    pLayout = new QStackedLayout();
+    pLayout->setContentsMargins(0, 0, 0, 0);
+    for(int i=0; i<2; i++) {
+        bLoadFailed[i] = false;
+        pVideoWidget[i] = new QVideoWidget();
+        pVideoWidget[i]->setAspectRatioMode(Qt::KeepAspectRatio);
+        pLayout->addWidget(pVideoWidget[i]);
+
+        pPlayer[i] = new QMediaPlayer(this);
+        pPlayer[i]->setVideoOutput(pVideoWidget[i]);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        pAudioOutput[i] = new QAudioOutput(this);
+        pPlayer[i]->setAudioOutput(pAudioOutput[i]);
+        connect(pPlayer[i], SIGNAL(errorOccurred(QMediaPlayer::Error,QString)),
+                this, SLOT(onPlayerError()));
+#else
+        connect(pPlayer[i], SIGNAL(error(QMediaPlayer::Error)),
+                this, SLOT(onPlayerError()));
+#endif
+        connect(pPlayer[i], SIGNAL(mediaStatusChanged(QMediaPlayer::MediaStatus)),
+                this, SLOT(onMediaStatusChanged(QMediaPlayer::MediaStatus)));
+    }
+    setLayout(pLayout);
+
+    stallTimer.setSingleShot(true);
+    connect(&stallTimer, SIGNAL(timeout()),
+            this, SLOT(onSpotStalled()));
+}
+
+
+/*!
+ * \brief SpotPlayer::~SpotPlayer
+ */
+SpotPlayer::~SpotPlayer() {
+    for(int i=0; i<2; i++) {
+        pPlayer[i]->disconnect();
+        pPlayer[i]->stop();
+    }
+}
+
+
+/*!
+ * \brief SpotPlayer::setSpotDir
+ * \param sNewDir The directory of the spots
+ */
+void
+SpotPlayer::setSpotDir(QString sNewDir) {
+    sSpotDir = sNewDir;
+}
+
+
+/*!
+ * \brief SpotPlayer::isPlaying
+ * \return true if the spot loop is running
+ */
+bool
+SpotPlayer::isPlaying() {
+    return bPlaying;
+}
+
+
+/*!
+ * \brief SpotPlayer::updateSpotList Rebuild the spot list and their durations
+ *
+ * It reads (and possibly probes) the spot directory, so it is done
+ * only when the loop starts or the spots have been updated (see
+ * refreshSpotList()), never while switching between two spots.
+ */
+void
+SpotPlayer::updateSpotList() {
+    spotList = QFileInfoList();
+    spotDuration.clear();
+    QDir spotDir(sSpotDir);
+    if(spotDir.exists()) {
+        QStringList nameFilter(QStringList() << "*.mp4" << "*.MP4");
+        spotDir.setNameFilters(nameFilter);
+        spotDir.setFilter(QDir::Files);
+        MediaProbe probe(sSpotDir, logFile);
+        spotList = probe.playable(spotDir.entryInfoList());
+        for(int i=0; i<spotList.count(); i++)
+            spotDuration.insert(spotList.at(i).absoluteFilePath(),
+                                probe.info(spotList.at(i).fileName()).durationMs);
+        probe.save();
+    }
+}
+
+
+/*!
+ * \brief SpotPlayer::refreshSpotList The spot directory has been updated
+ *
+ * The running loop continues from the spot on screen with the new
+ * list: the next spot is opened again only if it has changed.
+ */
+void
+SpotPlayer::refreshSpotList() {
+    updateSpotList();
+#ifdef LOG_VERBOSE
+    logMessage(logFile,
+               Q_FUNC_INFO,
+               QString("Found %1 spots").arg(spotList.count()));
+#endif
+    if(!bPlaying || spotList.isEmpty())
+        return;// An empty list stops the loop at the next switch
+    iCurrentSpot = iCurrentSpot % spotList.count();
+    for(int i=0; i<spotList.count(); i++) {
+        if(spotList.at(i).absoluteFilePath() == sLoadedSpot[iActive]) {
+            iCurrentSpot = i;
+            break;
+        }
+    }
+    preloadNext();
+}
+
+
+/*!
+ * \brief SpotPlayer::loadSpot Open a spot without playing it
+ * \param iPlayer The player to use
+ * \param sSpot The spot file
+ */
+void
+SpotPlayer::loadSpot(int iPlayer, QString sSpot) {
+    sLoadedSpot[iPlayer] = sSpot;
+    bLoadFailed[iPlayer] = false;
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    pPlayer[iPlayer]->setSource(QUrl::fromLocalFile(sSpot));
+#else
+    pPlayer[iPlayer]->setMedia(QUrl::fromLocalFile(sSpot));
+#endif
+}
+
+
+/*!
+ * \brief SpotPlayer::preloadNext Open the spot following the present one on the idle player
+ */
+void
+SpotPlayer::preloadNext() {
+    if(spotList.isEmpty())
+        return;
+    int iIdle = 1 - iActive;
+    QString sNextSpot = spotList.at((iCurrentSpot+1) % spotList.count()).absoluteFilePath();
+    if(sLoadedSpot[iIdle] != sNextSpot)
+        loadSpot(iIdle, sNextSpot);
+}
+
+
+/*!
+ * \brief SpotPlayer::startLoop Start playing all the spots in a loop
+ * \return false if there are no spots to play
+ */
+bool
+SpotPlayer::startLoop() {
+    if(bPlaying)
+        return true;
+    updateSpotList();
+#ifdef LOG_VERBOSE
+    logMessage(logFile,
+               Q_FUNC_INFO,
+               QString("Found %1 spots").arg(spotList.count()));
+#endif
+    if(spotList.isEmpty())
+        return false;
+    bPlaying  = true;
+    nFailures = 0;
+    iCurrentSpot = iCurrentSpot % spotList.count();
+    QString sSpot = spotList.at(iCurrentSpot).absoluteFilePath();
+    if(sLoadedSpot[iActive] != sSpot)
+        loadSpot(iActive, sSpot);
+    pLayout->setCurrentIndex(iActive);
+    pPlayer[iActive]->play();
+    watchActiveSpot();
+    showFullScreen();
+#ifdef LOG_VERBOSE
+    logMessage(logFile,
+               Q_FUNC_INFO,
+               QString("Now playing: %1").arg(sSpot));
+#endif
+    preloadNext();
+    return true;
+}
+
+
+/*!
+ * \brief SpotPlayer::advance Switch to the (already opened) next spot
+ */
+void
+SpotPlayer::advance() {
+    if(spotList.isEmpty()) {
+#ifdef LOG_VERBOSE
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("No spots available !"));
+#endif
+        stopLoop();
+        return;
+    }
+    iCurrentSpot = (iCurrentSpot+1) % spotList.count();
+    QString sSpot = spotList.at(iCurrentSpot).absoluteFilePath();
+    int iIdle = 1 - iActive;
+    if(bLoadFailed[iIdle] && (sLoadedSpot[iIdle] == sSpot)) {
+        // Its preload failed: once active it would report nothing more
+        nFailures++;
+        if(nFailures >= spotList.count()) {
+            stopLoop();// No playable spots
+            return;
+        }
+        iCurrentSpot = (iCurrentSpot+1) % spotList.count();
+        sSpot = spotList.at(iCurrentSpot).absoluteFilePath();
+    }
+    if(sLoadedSpot[iIdle] != sSpot)// The spot list has been changed
+        loadSpot(iIdle, sSpot);
+    pPlayer[iIdle]->play();
+    pLayout->setCurrentIndex(iIdle);
+    pPlayer[iActive]->stop();
+    iActive = iIdle;
+    watchActiveSpot();
+#ifdef LOG_VERBOSE
+    logMessage(logFile,
+               Q_FUNC_INFO,
+               QString("Now playing: %1").arg(sSpot));
+#endif
+    preloadNext();
+}
+
+
+/*!
+ * \brief SpotPlayer::watchActiveSpot Arm the stall watchdog with the probed duration
+ *
+ * Spots whose duration is not known get a generous fallback, so
+ * that a spot that never reports its end can't stop the loop.
+ */
+void
+SpotPlayer::watchActiveSpot() {
+    qint64 durationMs = spotDuration.value(sLoadedSpot[iActive], 0);
+    if(durationMs > 0)
+        stallTimer.start(int(durationMs + STALL_MARGIN));
+    else
+        stallTimer.start(STALL_FALLBACK);
+}
+
+
+/*!
+ * \brief SpotPlayer::onSpotStalled The active spot lasted longer than its duration
+ */
+void
+SpotPlayer::onSpotStalled() {
+    if(!bPlaying)
+        return;
+    logMessage(logFile,
+               Q_FUNC_INFO,
+               QString("%1 stalled: skipped").arg(sLoadedSpot[iActive]));
+    advance();
+}
+
+
+/*!
+ * \brief SpotPlayer::nextSpot Skip to the next spot
+ */
+void
+SpotPlayer::nextSpot() {
+    if(bPlaying)
+        advance();
+}
+
+
+/*!
+ * \brief SpotPlayer::stop Stop playing without notifying
+ */
+void
+SpotPlayer::stop() {
+    bPlaying = false;
+    stallTimer.stop();
+    for(int i=0; i<2; i++)
+        pPlayer[i]->stop();
+    hide();
+}
+
+
+/*!
+ * \brief SpotPlayer::stopLoop Stop playing and emit spotLoopClosed()
+ */
+void
+SpotPlayer::stopLoop() {
+    if(!bPlaying)
+        return;
+    stop();
+    emit spotLoopClosed();
+}
+
+
+/*!
+ * \brief SpotPlayer::onMediaStatusChanged
+ * \param status The new status of the player that emitted the signal
+ */
+void
+SpotPlayer::onMediaStatusChanged(QMediaPlayer::MediaStatus status) {
+    if(sender() != pPlayer[iActive]) {// The idle player is just preloading
+        if(status == QMediaPlayer::InvalidMedia) {
+            int iIdle = 1 - iActive;
+            bLoadFailed[iIdle] = true;// advance() will skip it
+            logMessage(logFile,
+                       Q_FUNC_INFO,
+                       QString("Unable to preload %1").arg(sLoadedSpot[iIdle]));
+        }
+        return;
+    }
+    if(!bPlaying)
+        return;
+    if(status == QMediaPlayer::EndOfMedia) {
+        nFailures = 0;
+        advance();
+    }
+    else if(status == QMediaPlayer::InvalidMedia) {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Unable to play %1").arg(sLoadedSpot[iActive]));
+        nFailures++;
+        if(nFailures >= spotList.count())
+            stopLoop();// No playable spots
+        else
+            advance();
+    }
+}
+
+
+/*!
+ * \brief SpotPlayer::onPlayerError
+ */
+void
+SpotPlayer::onPlayerError() {
+    QMediaPlayer* pSender = qobject_cast<QMediaPlayer*>(sender());
+    if(pSender) {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Player error: %1").arg(pSender->errorString()));
+    }
+}
+
+
+/*!
+ * \brief SpotPlayer::keyPressEvent
+ * \param event
+ */
+void
+SpotPlayer::keyPressEvent(QKeyEvent *event) {
+    if(event->key() == Qt::Key_Escape) {
+        stopLoop();
+        event->accept();
+        return;
+    }
+    QWidget::keyPressEvent(event);
+}
@@ -0,0 +1,88 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef SPOTPLAYER_H
+#define SPOTPLAYER_H
+
+#include <QWidget>
+#include <QFileInfoList>
+#include <QMediaPlayer>
+#include <QTimer>
+#include <QHash>
+
+
+QT_FORWARD_DECLARE_CLASS(QFile)
+QT_FORWARD_DECLARE_CLASS(QStackedLayout)
+QT_FORWARD_DECLARE_CLASS(QVideoWidget)
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+QT_FORWARD_DECLARE_CLASS(QAudioOutput)
+#endif
+
+
+class SpotPlayer : public QWidget
+{
+    Q_OBJECT
+
+public:
+    SpotPlayer(QFile *myLogFile = Q_NULLPTR, QWidget *parent = Q_NULLPTR);
+    ~SpotPlayer();
+    void setSpotDir(QString sNewDir);
+    void refreshSpotList();
+    bool startLoop();
+    void nextSpot();
+    void stopLoop();
+    void stop();
+    bool isPlaying();
+    void keyPressEvent(QKeyEvent *event);
+
+signals:
+    void spotLoopClosed();/*!< The loop has ended (no more spots or stopLoop()) */
+
+private slots:
+    void onMediaStatusChanged(QMediaPlayer::MediaStatus status);
+    void onPlayerError();
+    void onSpotStalled();
+
+private:
+    void updateSpotList();
+    void loadSpot(int iPlayer, QString sSpot);
+    void preloadNext();
+    void advance();
+    void watchActiveSpot();
+
+private:
+    QFile*          logFile;
+    QString         sSpotDir;
+    QFileInfoList   spotList;
+    QHash<QString,qint64> spotDuration;
+    QStackedLayout* pLayout;
+    QMediaPlayer*   pPlayer[2];
+    QVideoWidget*   pVideoWidget[2];
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    QAudioOutput*   pAudioOutput[2];
+#endif
+    QString         sLoadedSpot[2];
+    bool            bLoadFailed[2];
+    int             iActive;
+    int             iCurrentSpot;
+    int             nFailures;
+    bool            bPlaying;
+    QTimer          stallTimer;
+};
+
+#endif // SPOTPLAYER_H
@@ -0,0 +1,443 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QDir>
+#include <QSettings>
+#include <QFile>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+
+#include "spotprocessplayer.h"
+#include "processsupervisor.h"
+#include "utility.h"
+#include "mediaprobe.h"
+
+
+#define SPOT_PLAYER       "/usr/bin/omxplayer"
+#define PLAYER_SERVICE    "org.mpris.MediaPlayer2.omxplayer"
+#define PLAYER_PATH       "/org/mpris/MediaPlayer2"
+#define PLAYER_BUS        "omxplayer" // Our name for the connection to the player bus
+#define POSITION_INTERVAL 250 // ms between two checks of the playing position
+
+
+/*!
+ * \brief SpotProcessPlayer::SpotProcessPlayer A long-lived omxplayer driven through D-Bus
+ * \param myLogFile The File for message logging (if any)
+ * \param parent
+ *
+ * omxplayer is the only player using the Raspberry hardware decoder
+ * but it holds no playlist: a single instance, started at the first
+ * spot loop and kept for the whole session, loops on the present
+ * spot while we follow its position (asynchronous D-Bus calls) and
+ * open the next spot with OpenUri when the present one ends.
+ * No process is started between two spots.
+ * endspotloop pauses and hides the player, ready for the next loop.
+ */
+SpotProcessPlayer::SpotProcessPlayer(QFile *myLogFile, QObject *parent)
+    : QObject(parent)
+    , logFile(myLogFile)
+    , pPlayer(Q_NULLPTR)
+    , bBusConnected(false)
+    , iCurrentSpot(0)
+    , spotSerial(0)
+    , bPlaying(false)
+    , bPositionPending(false)
+    , lastPositionMs(0)
+{
+    pPlayer = new ProcessSupervisor(QString("Spot Player"), logFile, this);
+    connect(pPlayer, SIGNAL(finished(int, QProcess::ExitStatus)),
+            this, SLOT(onPlayerFinished(int, QProcess::ExitStatus)));
+    connect(pPlayer, SIGNAL(failedToStart()),
+            this, SLOT(onPlayerFailedToStart()));
+    connect(&positionTimer, SIGNAL(timeout()),
+            this, SLOT(onTimeToCheckPosition()));
+    endTimer.setSingleShot(true);
+    connect(&endTimer, SIGNAL(timeout()),
+            this, SLOT(onSpotEnded()));
+}
+
+
+/*!
+ * \brief SpotProcessPlayer::~SpotProcessPlayer
+ *
+ * A player still running is asked to quit and its supervisor,
+ * detached from us, outlives this object: it escalates if the
+ * player doesn't quit and is deleted when the process is over.
+ */
+SpotProcessPlayer::~SpotProcessPlayer() {
+    positionTimer.stop();
+    endTimer.stop();
+    if(bBusConnected)
+        QDBusConnection::disconnectFromBus(PLAYER_BUS);
+    pPlayer->disconnect(this);
+    if(pPlayer->isActive()) {
+        pPlayer->setParent(Q_NULLPTR);
+        connect(pPlayer, SIGNAL(finished(int, QProcess::ExitStatus)),
+                pPlayer, SLOT(deleteLater()));
+        connect(pPlayer, SIGNAL(failedToStart()),
+                pPlayer, SLOT(deleteLater()));
+        pPlayer->stop("q");
+    }
+    pPlayer = Q_NULLPTR;
+}
+
+
+/*!
+ * \brief SpotProcessPlayer::setSpotDir
+ * \param sNewDir The directory of the spots
+ */
+void
+SpotProcessPlayer::setSpotDir(QString sNewDir) {
+    sSpotDir = sNewDir;
+}
+
+
+/*!
+ * \brief SpotProcessPlayer::isPlaying
+ * \return true if the spot loop is running
+ */
+bool
+SpotProcessPlayer::isPlaying() {
+    return bPlaying;
+}
+
+
+/*!
+ * \brief SpotProcessPlayer::updateSpotList Rebuild the spot list and their durations
+ */
+void
+SpotProcessPlayer::updateSpotList() {
+    spotList = QFileInfoList();
+    spotDuration.clear();
+    QDir spotDir(sSpotDir);
+    if(spotDir.exists()) {
+        QStringList nameFilter(QStringList() << "*.mp4" << "*.MP4");
+        spotDir.setNameFilters(nameFilter);
+        spotDir.setFilter(QDir::Files);
+        MediaProbe probe(sSpotDir, logFile);
+        spotList = probe.playable(spotDir.entryInfoList());
+        for(int i=0; i<spotList.count(); i++)
+            spotDuration.insert(spotList.at(i).absoluteFilePath(),
+                                probe.info(spotList.at(i).fileName()).durationMs);
+        probe.save();
+    }
+}
+
+
+/*!
+ * \brief SpotProcessPlayer::refreshSpotList The spot directory has been updated
+ *
+ * The loop continues from the spot on screen with the new list.
+ */
+void
+SpotProcessPlayer::refreshSpotList() {
+    updateSpotList();
+    if(spotList.isEmpty())
+        return;// An empty list stops the loop at the next switch
+    iCurrentSpot = iCurrentSpot % spotList.count();
+    for(int i=0; i<spotList.count(); i++) {
+        if(spotList.at(i).absoluteFilePath() == sPlayingSpot) {
+            iCurrentSpot = i;
+            break;
+        }
+    }
+}
+
+
+/*!
+ * \brief SpotProcessPlayer::startPlayer Start the player with the first spot (only once per session)
+ * \param sFirstSpot
+ */
+void
+SpotProcessPlayer::startPlayer(QString sFirstSpot) {
+    QSettings settings("Gabriele Salvato", "Score Panel");
+    QString sProgram = settings.value("spots/player", SPOT_PLAYER).toString();
+    QStringList arguments;
+    arguments << "--loop"// Never exits by itself: we decide when to switch
+              << "--no-osd"
+              << "-o" << "hdmi"
+              << "-r"
+              << "--dbus_name" << PLAYER_SERVICE
+              << sFirstSpot;
+    pPlayer->start(sProgram, arguments);
+#ifdef LOG_VERBOSE
+    logMessage(logFile,
+               Q_FUNC_INFO,
+               QString("Starting %1").arg(sProgram));
+#endif
+}
+
+
+/*!
+ * \brief SpotProcessPlayer::connectToPlayer Connect to the bus of the player
+ * \return false if the bus is not available (yet)
+ *
+ * The omxplayer launcher runs a private session bus
+ * whose address is left in /tmp/omxplayerdbus.<user>
+ */
+bool
+SpotProcessPlayer::connectToPlayer() {
+    if(bBusConnected)
+        return true;
+    QString sUser = QString::fromLocal8Bit(qgetenv("USER"));
+    if(sUser.isEmpty())
+        sUser = QString("root");
+    QFile addressFile(QString("/tmp/omxplayerdbus.%1").arg(sUser));
+    if(!addressFile.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+    QString sAddress = QString::fromLocal8Bit(addressFile.readAll()).trimmed();
+    if(sAddress.isEmpty())
+        return false;
+    QDBusConnection bus = QDBusConnection::connectToBus(sAddress, PLAYER_BUS);
+    if(!bus.isConnected()) {
+        QDBusConnection::disconnectFromBus(PLAYER_BUS);
+        return false;
+    }
+    bBusConnected = true;
+    return true;
+}
+
+
+/*!
+ * \brief SpotProcessPlayer::callPlayer Send a command to the player (without waiting)
+ * \param sMethod A method of the MPRIS Player interface of omxplayer
+ * \param argument Its argument (if any)
+ */
+void
+SpotProcessPlayer::callPlayer(QString sMethod, QVariant argument) {
+    if(!connectToPlayer()) {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Player bus not available: %1 not sent").arg(sMethod));
+        return;
+    }
+    QDBusMessage message = QDBusMessage::createMethodCall(PLAYER_SERVICE,
+                                                          PLAYER_PATH,
+                                                          "org.mpris.MediaPlayer2.Player",
+                                                          sMethod);
+    if(argument.isValid())
+        message << argument;
+    QDBusConnection(PLAYER_BUS).asyncCall(message);
+}
+
+
+/*!
+ * \brief SpotProcessPlayer::openSpot Play the current spot and follow its position
+ */
+void
+SpotProcessPlayer::openSpot() {
+    sPlayingSpot = spotList.at(iCurrentSpot).absoluteFilePath();
+    if(!pPlayer->isActive())
+        startPlayer(sPlayingSpot);
+    else
+        callPlayer(QString("OpenUri"), sPlayingSpot);
+    spotSerial++;// The position replies of the previous spot are ignored
+    lastPositionMs = 0;
+    endTimer.stop();
+    positionTimer.start(POSITION_INTERVAL);
+#ifdef LOG_VERBOSE
+    logMessage(logFile,
+               Q_FUNC_INFO,
+               QString("Now playing: %1").arg(sPlayingSpot));
+#endif
+}
+
+
+/*!
+ * \brief SpotProcessPlayer::advance Switch the running player to the next spot
+ */
+void
+SpotProcessPlayer::advance() {
+    if(spotList.isEmpty()) {
+        stopLoop();
+        return;
+    }
+    iCurrentSpot = (iCurrentSpot+1) % spotList.count();
+    openSpot();
+}
+
+
+/*!
+ * \brief SpotProcessPlayer::startLoop Play all the spots in a loop
+ * \return false if there are no spots to play
+ */
+bool
+SpotProcessPlayer::startLoop() {
+    if(bPlaying)
+        return true;
+    updateSpotList();
+    if(spotList.isEmpty())
+        return false;
+    bPlaying = true;
+    iCurrentSpot = iCurrentSpot % spotList.count();
+    bool bResume = pPlayer->isActive();
+    openSpot();
+    if(bResume) {// Paused and hidden by the previous stop()
+        callPlayer(QString("Play"));
+        callPlayer(QString("UnHideVideo"));
+    }
+    return true;
+}
+
+
+/*!
+ * \brief SpotProcessPlayer::nextSpot Skip to the next spot
+ */
+void
+SpotProcessPlayer::nextSpot() {
+    if(bPlaying)
+        advance();
+}
+
+
+/*!
+ * \brief SpotProcessPlayer::stop Stop playing without notifying
+ *
+ * The player process stays alive (paused and hidden), ready for the next loop.
+ */
+void
+SpotProcessPlayer::stop() {
+    if(!bPlaying)
+        return;
+    bPlaying = false;
+    positionTimer.stop();
+    endTimer.stop();
+    callPlayer(QString("Pause"));
+    callPlayer(QString("HideVideo"));
+}
+
+
+/*!
+ * \brief SpotProcessPlayer::stopLoop Stop playing and emit spotLoopClosed()
+ */
+void
+SpotProcessPlayer::stopLoop() {
+    if(!bPlaying)
+        return;
+    stop();
+    emit spotLoopClosed();
+}
+
+
+/*!
+ * \brief SpotProcessPlayer::closeLoop The loop can't go on (the player has gone)
+ */
+void
+SpotProcessPlayer::closeLoop() {
+    bPlaying = false;
+    positionTimer.stop();
+    endTimer.stop();
+    //To avoid a blank screen that sometime appear at the end of omxplayer
+    ProcessSupervisor::runDetached(QString("xrefresh"), QStringList() << "-display" << ":0");
+    emit spotLoopClosed();
+}
+
+
+/*!
+ * \brief SpotProcessPlayer::onTimeToCheckPosition Ask the player where it is
+ */
+void
+SpotProcessPlayer::onTimeToCheckPosition() {
+    if(bPositionPending || !connectToPlayer())
+        return;// Still waiting or the player bus is not up yet
+    QDBusMessage message = QDBusMessage::createMethodCall(PLAYER_SERVICE,
+                                                          PLAYER_PATH,
+                                                          "org.freedesktop.DBus.Properties",
+                                                          "Position");
+    QDBusPendingCallWatcher* pWatcher = new QDBusPendingCallWatcher(QDBusConnection(PLAYER_BUS).asyncCall(message), this);
+    pWatcher->setProperty("spotSerial", spotSerial);
+    connect(pWatcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
+            this, SLOT(onPositionReply(QDBusPendingCallWatcher*)));
+    bPositionPending = true;
+}
+
+
+/*!
+ * \brief SpotProcessPlayer::onPositionReply Switch spot when the present one is over
+ * \param pWatcher The pending Position call
+ *
+ * The switch is timed on the probed duration; a position going
+ * back (the player looped) means that the spot is over anyway.
+ */
+void
+SpotProcessPlayer::onPositionReply(QDBusPendingCallWatcher *pWatcher) {
+    pWatcher->deleteLater();
+    bPositionPending = false;
+    if(!bPlaying || pWatcher->property("spotSerial").toInt() != spotSerial)
+        return;// Not about the spot on screen
+    QDBusPendingReply<qint64> reply = *pWatcher;
+    if(reply.isError())
+        return;// Not ready yet: asked again at the next check
+    qint64 positionMs = reply.value()/1000;// us
+    if(positionMs+POSITION_INTERVAL < lastPositionMs) {
+        advance();
+        return;
+    }
+    lastPositionMs = positionMs;
+    qint64 durationMs = spotDuration.value(sPlayingSpot, 0);
+    if(durationMs > 0 && durationMs-positionMs <= POSITION_INTERVAL) {
+        positionTimer.stop();
+        endTimer.start(int(qMax(qint64(0), durationMs-positionMs)));
+    }
+}
+
+
+/*!
+ * \brief SpotProcessPlayer::onSpotEnded
+ */
+void
+SpotProcessPlayer::onSpotEnded() {
+    if(bPlaying)
+        advance();
+}
+
+
+/*!
+ * \brief SpotProcessPlayer::onPlayerFinished The player process exited
+ * \param exitCode
+ * \param exitStatus
+ */
+void
+SpotProcessPlayer::onPlayerFinished(int exitCode, QProcess::ExitStatus exitStatus) {
+    if(bBusConnected) {// The next player may have a new bus
+        QDBusConnection::disconnectFromBus(PLAYER_BUS);
+        bBusConnected = false;
+    }
+    bPositionPending = false;
+    logMessage(logFile,
+               Q_FUNC_INFO,
+               QString("Spot player exited with code %1 (%2)")
+               .arg(exitCode)
+               .arg(exitStatus == QProcess::NormalExit ? "normal" : "crash"));
+    if(bPlaying)
+        closeLoop();
+    else//To avoid a blank screen that sometime appear at the end of omxplayer
+        ProcessSupervisor::runDetached(QString("xrefresh"), QStringList() << "-display" << ":0");
+}
+
+
+/*!
+ * \brief SpotProcessPlayer::onPlayerFailedToStart
+ */
+void
+SpotProcessPlayer::onPlayerFailedToStart() {
+    if(bPlaying)
+        closeLoop();
+}
@@ -0,0 +1,86 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef SPOTPROCESSPLAYER_H
+#define SPOTPROCESSPLAYER_H
+
+#include <QObject>
+#include <QProcess>
+#include <QFileInfoList>
+#include <QHash>
+#include <QTimer>
+#include <QVariant>
+
+
+QT_FORWARD_DECLARE_CLASS(QFile)
+QT_FORWARD_DECLARE_CLASS(QDBusPendingCallWatcher)
+QT_FORWARD_DECLARE_CLASS(ProcessSupervisor)
+
+
+class SpotProcessPlayer : public QObject
+{
+    Q_OBJECT
+
+public:
+    SpotProcessPlayer(QFile *myLogFile = Q_NULLPTR, QObject *parent = Q_NULLPTR);
+    ~SpotProcessPlayer();
+    void setSpotDir(QString sNewDir);
+    void refreshSpotList();
+    bool startLoop();
+    void nextSpot();
+    void stopLoop();
+    void stop();
+    bool isPlaying();
+
+signals:
+    void spotLoopClosed();/*!< The loop has ended (no more spots, player exited or stopLoop()) */
+
+private slots:
+    void onPlayerFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void onPlayerFailedToStart();
+    void onTimeToCheckPosition();
+    void onPositionReply(QDBusPendingCallWatcher *pWatcher);
+    void onSpotEnded();
+
+private:
+    void updateSpotList();
+    void startPlayer(QString sFirstSpot);
+    bool connectToPlayer();
+    void callPlayer(QString sMethod, QVariant argument = QVariant());
+    void openSpot();
+    void advance();
+    void closeLoop();
+
+private:
+    QFile*             logFile;
+    ProcessSupervisor* pPlayer;
+    bool               bBusConnected;
+    QString            sSpotDir;
+    QFileInfoList      spotList;
+    QHash<QString,qint64> spotDuration;
+    QString            sPlayingSpot;
+    int                iCurrentSpot;
+    int                spotSerial;
+    bool               bPlaying;
+    bool               bPositionPending;
+    qint64             lastPositionMs;
+    QTimer             positionTimer;
+    QTimer             endTimer;
+};
+
+#endif // SPOTPROCESSPLAYER_H
@@ -39,6 +39,9 @@ TimedScorePanel::TimedScorePanel(QString myServerUrl, QFile *myLogFile, QWidget
     baudRate = QSerialPort::Baud115200;
     waitTimeout = 1000;
     responseData.clear();
+    // The time shown is part of the score overlay too
+    connect(this, SIGNAL(newTimeValue(QString)),
+            this, SLOT(onScoreChanged()));
     ConnectToArduino();
 #endif
 }
@@ -0,0 +1,22 @@
+# Microbenchmarks of the Score Panel hot paths.
+# Build with: qmake && make
+# It is a plain tool (not a test target): run it on the reference
+# machine and compare with the stored baseline (see main.cpp).
+
+CONFIG += c++11
+CONFIG -= app_bundle
+
+TARGET = bench
+TEMPLATE = app
+
+DEFINES += QT_DEPRECATED_WARNINGS
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+include(../../scorepanel.pri)
+
+SOURCES += main.cpp
+SOURCES += benchrunner.cpp
+SOURCES += benchcases.cpp
+
+HEADERS += benchrunner.h
+HEADERS += benchcases.h
@@ -0,0 +1,298 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QImage>
+#include <QPixmap>
+#include <QPainter>
+#include <QFile>
+
+#include "benchcases.h"
+#include "benchrunner.h"
+#include "segnapuntihandball.h"
+#include "scoremodel.h"
+#include "fileupdater.h"
+#include "utility.h"
+#if !defined(Q_PROCESSOR_ARM) & !defined(Q_OS_ANDROID)
+    #include "slidewindow.h"
+    #include "slidetransition.h"
+    #include "slideloader.h"
+#endif
+
+
+// Nobody listens there: the Panels just keep trying to reconnect
+#define NO_SERVER_URL "ws://127.0.0.1:9"
+
+
+/*!
+ * \brief BenchVolley::BenchVolley
+ */
+BenchVolley::BenchVolley(const QString &myServerUrl)
+    : SegnapuntiVolley(myServerUrl, Q_NULLPTR)
+{
+}
+
+
+/*!
+ * \brief BenchBasket::BenchBasket
+ */
+BenchBasket::BenchBasket(const QString &myServerUrl)
+    : SegnapuntiBasket(myServerUrl, Q_NULLPTR)
+{
+}
+
+
+/*!
+ * \brief The messageContext struct Two messages alternated, so that every call changes the score
+ */
+struct messageContext {
+    QObject    *pTarget;
+    ScoreModel *pModel;
+    QString     sMessage[2];
+    int         iNext;
+};
+
+
+static void
+benchXmlParse(void *pContext) {
+    messageContext *pCtx = static_cast<messageContext*>(pContext);
+    XML_Parse(pCtx->sMessage[0], "servizio");
+}
+
+
+static void
+benchModelUpdate(void *pContext) {
+    messageContext *pCtx = static_cast<messageContext*>(pContext);
+    pCtx->pModel->update(pCtx->sMessage[pCtx->iNext]);
+    pCtx->iNext = 1-pCtx->iNext;
+}
+
+
+static void
+benchTextMessage(void *pContext) {
+    messageContext *pCtx = static_cast<messageContext*>(pContext);
+    QMetaObject::invokeMethod(pCtx->pTarget, "onTextMessageReceived", Qt::DirectConnection,
+                              Q_ARG(QString, pCtx->sMessage[pCtx->iNext]));
+    pCtx->iNext = 1-pCtx->iNext;
+}
+
+
+static void
+benchFontSizes(void *pContext) {
+    static_cast<BenchVolley*>(pContext)->buildFontSizes();
+}
+
+
+#ifndef Q_OS_ANDROID
+/*!
+ * \brief The serialContext struct An encoded Arduino "Time" answer
+ */
+struct serialContext {
+    BenchBasket *pPanel;
+    QByteArray   baResponse;
+    QByteArray   baCommand;
+};
+
+
+static void
+benchDecodeResponse(void *pContext) {
+    serialContext *pCtx = static_cast<serialContext*>(pContext);
+    pCtx->pPanel->decodeResponse(pCtx->baResponse);
+}
+
+
+static void
+benchExecuteCommand(void *pContext) {
+    serialContext *pCtx = static_cast<serialContext*>(pContext);
+    pCtx->pPanel->executeCommand(pCtx->baCommand);
+}
+#endif
+
+
+#if !defined(Q_PROCESSOR_ARM) & !defined(Q_OS_ANDROID)
+/*!
+ * \brief The slideContext struct
+ */
+struct slideContext {
+    SlideLoader     *pLoader;
+    QString          sSlideFile;
+    QSize            slideSize;
+    SlideTransition *pTransition;
+    QPixmap         *pTarget;
+    double           t;
+};
+
+
+static void
+benchSlideCompose(void *pContext) {
+    slideContext *pCtx = static_cast<slideContext*>(pContext);
+    pCtx->pLoader->loadSlide(pCtx->sSlideFile, pCtx->slideSize);
+}
+
+
+static void
+benchTransitionStep(void *pContext) {
+    slideContext *pCtx = static_cast<slideContext*>(pContext);
+    QPainter painter(pCtx->pTarget);
+    pCtx->pTransition->renderStep(pCtx->t, &painter);
+    pCtx->t += 0.01;
+    if(pCtx->t > 1.0) pCtx->t = 0.0;
+}
+#endif
+
+
+/*!
+ * \brief The chunkContext struct
+ */
+struct chunkContext {
+    FileUpdater *pUpdater;
+    QByteArray   baChunk;
+    QString      sTempFile;
+    int          nChunks;
+};
+
+
+static void
+benchChunkWrite(void *pContext) {
+    chunkContext *pCtx = static_cast<chunkContext*>(pContext);
+    QMetaObject::invokeMethod(pCtx->pUpdater, "onProcessBinaryFrame", Qt::DirectConnection,
+                              Q_ARG(QByteArray, pCtx->baChunk),
+                              Q_ARG(bool, false));
+    // The file is opened in Append mode: keep it (and the disk) small
+    if(++pCtx->nChunks % 64 == 0)
+        QFile::resize(pCtx->sTempFile, 0);
+}
+
+
+/*!
+ * \brief runAllBenchmarks
+ * \param pRunner
+ * \param pWorkDir Where the benchmarks can write their files
+ */
+void
+runAllBenchmarks(BenchRunner *pRunner, QTemporaryDir *pWorkDir) {
+    QString sVolley[2] = {
+        "<team0>Locali</team0><team1>Ospiti</team1><set0>1</set0><set1>2</set1>"
+        "<timeout0>1</timeout0><timeout1>0</timeout1><score0>23</score0><score1>24</score1>"
+        "<servizio>0</servizio>",
+        "<team0>Locali</team0><team1>Ospiti</team1><set0>1</set0><set1>2</set1>"
+        "<timeout0>1</timeout0><timeout1>0</timeout1><score0>24</score0><score1>24</score1>"
+        "<servizio>1</servizio>"
+    };
+    QString sBasket[2] = {
+        "<team0>Locali</team0><team1>Ospiti</team1><period>2,10</period>"
+        "<timeout0>1</timeout0><timeout1>2</timeout1><score0>54</score0><score1>61</score1>"
+        "<possess>0</possess><fauls0>3</fauls0><fauls1>4</fauls1><bonus0>0</bonus0><bonus1>0</bonus1>",
+        "<team0>Locali</team0><team1>Ospiti</team1><period>2,10</period>"
+        "<timeout0>1</timeout0><timeout1>2</timeout1><score0>56</score0><score1>61</score1>"
+        "<possess>1</possess><fauls0>3</fauls0><fauls1>5</fauls1><bonus0>0</bonus0><bonus1>1</bonus1>"
+    };
+    QString sHandball[2] = {
+        "<team0>Locali</team0><team1>Ospiti</team1><period>1,30</period>"
+        "<timeout0>0</timeout0><timeout1>1</timeout1><score0>12</score0><score1>11</score1>",
+        "<team0>Locali</team0><team1>Ospiti</team1><period>1,30</period>"
+        "<timeout0>0</timeout0><timeout1>1</timeout1><score0>12</score0><score1>12</score1>"
+    };
+
+    // Protocol (widget free)
+    ScoreModel volleyModel(VOLLEY_PANEL);
+    messageContext ctx = { Q_NULLPTR, &volleyModel, { sVolley[0], sVolley[1] }, 0 };
+    pRunner->run("xml_parse", benchXmlParse, &ctx);
+    pRunner->run("model_volley", benchModelUpdate, &ctx);
+    ScoreModel basketModel(BASKET_PANEL);
+    ctx = { Q_NULLPTR, &basketModel, { sBasket[0], sBasket[1] }, 0 };
+    pRunner->run("model_basket", benchModelUpdate, &ctx);
+    ScoreModel handballModel(HANDBALL_PANEL);
+    ctx = { Q_NULLPTR, &handballModel, { sHandball[0], sHandball[1] }, 0 };
+    pRunner->run("model_handball", benchModelUpdate, &ctx);
+
+    // The Panels message handlers
+    BenchVolley volleyPanel(NO_SERVER_URL);
+    volleyPanel.showFullScreen();
+    ctx = { &volleyPanel, Q_NULLPTR, { sVolley[0], sVolley[1] }, 0 };
+    pRunner->run("volley_message", benchTextMessage, &ctx);
+    pRunner->run("volley_font_sizes", benchFontSizes, &volleyPanel);
+
+    BenchBasket basketPanel(NO_SERVER_URL);
+    basketPanel.showFullScreen();
+    ctx = { &basketPanel, Q_NULLPTR, { sBasket[0], sBasket[1] }, 0 };
+    pRunner->run("basket_message", benchTextMessage, &ctx);
+
+    SegnapuntiHandball handballPanel(NO_SERVER_URL, Q_NULLPTR);
+    handballPanel.showFullScreen();
+    ctx = { &handballPanel, Q_NULLPTR, { sHandball[0], sHandball[1] }, 0 };
+    pRunner->run("handball_message", benchTextMessage, &ctx);
+
+#ifndef Q_OS_ANDROID
+    // Arduino "Time" answer: length (+2), command, 4 bytes LSB first
+    serialContext serial;
+    serial.pPanel = &basketPanel;
+    quint32 time = 12345;
+    serial.baResponse.append(char(0xFF));// startMarker
+    serial.baResponse.append(char(8));
+    serial.baResponse.append(char(Time));
+    for(int i=0; i<4; i++)
+        serial.baResponse.append(char((time >> (8*i)) & 0xFF));
+    serial.baResponse.append(char(0xFE));// endMarker
+    serial.baCommand = basketPanel.decodeResponse(serial.baResponse);
+    pRunner->run("decode_response", benchDecodeResponse, &serial);
+    pRunner->run("execute_command", benchExecuteCommand, &serial);
+#endif
+
+#if !defined(Q_PROCESSOR_ARM) & !defined(Q_OS_ANDROID)
+    // Slides: composition of a 4:3 photo on a Full HD slide and transition steps
+    slideContext slides;
+    SlideLoader loader;
+    QImage photo(2048, 1536, QImage::Format_RGB32);
+    photo.fill(Qt::darkGreen);
+    slides.sSlideFile = pWorkDir->filePath("slide.jpg");
+    photo.save(slides.sSlideFile);
+    slides.pLoader   = &loader;
+    slides.slideSize = QSize(1920, 1080);
+    pRunner->run("slide_compose", benchSlideCompose, &slides);
+
+    QPixmap present(slides.slideSize);
+    QPixmap next(slides.slideSize);
+    QPixmap target(slides.slideSize);
+    present.fill(Qt::blue);
+    next.fill(Qt::red);
+    slides.pTarget = &target;
+    int modes[3] = { SlideWindow::transition_Fade,
+                     SlideWindow::transition_Blinds,
+                     SlideWindow::transition_Dissolve };
+    QString sNames[3] = { "fade_step", "blinds_step", "dissolve_step" };
+    for(int i=0; i<3; i++) {
+        slides.pTransition = SlideTransition::create(modes[i]);
+        slides.pTransition->prepare(present, next);
+        slides.t = 0.0;
+        pRunner->run(sNames[i], benchTransitionStep, &slides);
+        delete slides.pTransition;
+    }
+#endif
+
+    // FileUpdater: a 512 KB chunk appended to the file being received
+    FileUpdater updater(QString("Bench"), QUrl(NO_SERVER_URL));
+    updater.setDestination(pWorkDir->path()+QString("/"), QString("*.bin"));
+    QByteArray header(1024, '\0');
+    QByteArray sHeader = QByteArray("bench.bin,1000000000");
+    header.replace(0, sHeader.size(), sHeader);
+    QMetaObject::invokeMethod(&updater, "onProcessBinaryFrame", Qt::DirectConnection,
+                              Q_ARG(QByteArray, header),
+                              Q_ARG(bool, false));
+    chunkContext chunk = { &updater, QByteArray(512*1024, 'x'), pWorkDir->filePath("bench.bin.temp"), 0 };
+    pRunner->run("fileupdater_chunk", benchChunkWrite, &chunk);
+}
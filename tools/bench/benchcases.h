@@ -0,0 +1,59 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef BENCHCASES_H
+#define BENCHCASES_H
+
+#include <QString>
+#include <QTemporaryDir>
+
+#include "segnapuntivolley.h"
+#include "segnapuntibasket.h"
+
+
+class BenchRunner;
+
+
+/*!
+ * \brief The BenchVolley class Exposes the protected hot paths of the Volley Panel
+ */
+class BenchVolley : public SegnapuntiVolley
+{
+public:
+    BenchVolley(const QString &myServerUrl);
+    using SegnapuntiVolley::buildFontSizes;
+};
+
+
+/*!
+ * \brief The BenchBasket class Exposes the protected hot paths of the Basket Panel
+ */
+class BenchBasket : public SegnapuntiBasket
+{
+public:
+    BenchBasket(const QString &myServerUrl);
+#ifndef Q_OS_ANDROID
+    using SegnapuntiBasket::decodeResponse;
+    using SegnapuntiBasket::executeCommand;
+#endif
+};
+
+
+void runAllBenchmarks(BenchRunner *pRunner, QTemporaryDir *pWorkDir);
+
+#endif // BENCHCASES_H
@@ -0,0 +1,163 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QElapsedTimer>
+#include <QFile>
+#include <QVector>
+#include <algorithm>
+
+#include "benchrunner.h"
+
+
+/*!
+ * \brief BenchRunner::BenchRunner A minimal benchmark harness
+ * \param myMinRoundMs The shortest duration of a measure round
+ * \param myRounds The number of rounds (the median is taken)
+ *
+ * Every benchmark is first run to estimate its cost, then the
+ * iterations are scaled to last at least myMinRoundMs per round.
+ */
+BenchRunner::BenchRunner(int myMinRoundMs, int myRounds)
+    : minRoundMs(qMax(10, myMinRoundMs))
+    , rounds(qMax(1, myRounds))
+{
+}
+
+
+/*!
+ * \brief BenchRunner::setFilter Run only the benchmarks whose name contains the filter
+ */
+void
+BenchRunner::setFilter(QString sNewFilter) {
+    sFilter = sNewFilter;
+}
+
+
+/*!
+ * \brief BenchRunner::run Measure a benchmark
+ * \param sName Its name (used in the baselines)
+ * \param function One operation
+ * \param pContext What the function operates on
+ */
+void
+BenchRunner::run(QString sName, benchFunction function, void *pContext) {
+    if(!sFilter.isEmpty() && !sName.contains(sFilter))
+        return;
+    QElapsedTimer timer;
+    // Warm up and estimate
+    qint64 iterations = 1;
+    for(;;) {
+        timer.start();
+        for(qint64 i=0; i<iterations; i++)
+            function(pContext);
+        qint64 ns = timer.nsecsElapsed();
+        if(ns >= qint64(minRoundMs)*100000 || iterations >= (qint64(1) << 30))
+            break;
+        iterations *= 2;
+    }
+    // Measure
+    QVector<double> samples;
+    for(int r=0; r<rounds; r++) {
+        timer.start();
+        qint64 done = 0;
+        do {
+            for(qint64 i=0; i<iterations; i++)
+                function(pContext);
+            done += iterations;
+        } while(timer.elapsed() < minRoundMs);
+        samples.append(double(timer.nsecsElapsed())/double(done));
+    }
+    std::sort(samples.begin(), samples.end());
+    benchResult result;
+    result.sName      = sName;
+    result.iterations = iterations;
+    result.nsPerOp    = samples.at(samples.count()/2);
+    results.append(result);
+}
+
+
+/*!
+ * \brief BenchRunner::report Print the results
+ */
+void
+BenchRunner::report(QTextStream& out) {
+    for(int i=0; i<results.count(); i++) {
+        out << QString("%1 %2 ns/op")
+               .arg(results.at(i).sName, -28)
+               .arg(results.at(i).nsPerOp, 12, 'f', 1)
+            << Qt::endl;
+    }
+}
+
+
+/*!
+ * \brief BenchRunner::save Write the results as a baseline ("name ns/op" per line)
+ */
+bool
+BenchRunner::save(QString sFileName) {
+    QFile file(sFileName);
+    if(!file.open(QIODevice::WriteOnly|QIODevice::Text))
+        return false;
+    QTextStream out(&file);
+    for(int i=0; i<results.count(); i++)
+        out << results.at(i).sName << " " << QString::number(results.at(i).nsPerOp, 'f', 1) << "\n";
+    return true;
+}
+
+
+/*!
+ * \brief BenchRunner::compare Compare with a stored baseline
+ * \param sFileName The baseline
+ * \param tolerance The accepted slow down (0.15 = 15%)
+ * \param out Where to print the differences
+ * \return false if a benchmark is slower than the tolerance
+ */
+bool
+BenchRunner::compare(QString sFileName, double tolerance, QTextStream& out) {
+    QFile file(sFileName);
+    if(!file.open(QIODevice::ReadOnly|QIODevice::Text)) {
+        out << "Unable to open the baseline " << sFileName << Qt::endl;
+        return false;
+    }
+    QMap<QString, double> baseline;
+    QTextStream in(&file);
+    while(!in.atEnd()) {
+        QStringList fields = in.readLine().split(" ", Qt::SkipEmptyParts);
+        if(fields.count() == 2)
+            baseline.insert(fields.at(0), fields.at(1).toDouble());
+    }
+    bool bOk = true;
+    for(int i=0; i<results.count(); i++) {
+        const benchResult& result = results.at(i);
+        if(!baseline.contains(result.sName) || baseline.value(result.sName) <= 0.0) {
+            out << QString("%1 (no baseline)").arg(result.sName, -28) << Qt::endl;
+            continue;
+        }
+        double change = result.nsPerOp/baseline.value(result.sName) - 1.0;
+        bool bSlower = change > tolerance;
+        out << QString("%1 %2%3%")
+               .arg(result.sName, -28)
+               .arg(change >= 0.0 ? "+" : "")
+               .arg(change*100.0, 0, 'f', 1)
+            << (bSlower ? "  SLOWER" : "")
+            << Qt::endl;
+        if(bSlower)
+            bOk = false;
+    }
+    return bOk;
+}
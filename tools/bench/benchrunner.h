@@ -0,0 +1,58 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef BENCHRUNNER_H
+#define BENCHRUNNER_H
+
+#include <QString>
+#include <QList>
+#include <QMap>
+#include <QTextStream>
+
+
+typedef void (*benchFunction)(void *pContext);
+
+
+/*!
+ * \brief The benchResult struct The outcome of a benchmark
+ */
+struct benchResult {
+    QString sName;     /*!< The benchmark name */
+    qint64  iterations;/*!< Iterations of the fastest round */
+    double  nsPerOp;   /*!< Median over the rounds */
+};
+
+
+class BenchRunner
+{
+public:
+    BenchRunner(int myMinRoundMs = 200, int myRounds = 5);
+    void setFilter(QString sNewFilter);
+    void run(QString sName, benchFunction function, void *pContext);
+    void report(QTextStream& out);
+    bool save(QString sFileName);
+    bool compare(QString sFileName, double tolerance, QTextStream& out);
+
+private:
+    int                minRoundMs;
+    int                rounds;
+    QString            sFilter;
+    QList<benchResult> results;
+};
+
+#endif // BENCHRUNNER_H
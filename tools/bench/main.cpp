@@ -0,0 +1,104 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <cstring>
+
+#include "benchrunner.h"
+#include "benchcases.h"
+
+
+static void
+quietHandler(QtMsgType type, const QMessageLogContext &context, const QString &sMessage) {
+    Q_UNUSED(context)
+    if(type == QtFatalMsg)
+        QTextStream(stderr) << sMessage << Qt::endl;
+}
+
+
+/*!
+ * \brief main Microbenchmarks of the Panel hot paths
+ *
+ * <pre>./bench [--filter name] [--save file] [--baseline file] [--tolerance 0.15]</pre>
+ *
+ * The Panels run offscreen (unless --onscreen) and with empty
+ * settings. The baselines are plain "name ns/op" files and none is
+ * kept in the repository: the timings only mean something on the
+ * machine that recorded them. Record one with --save before a change
+ * (on the Raspberry for the figures that matter) and check the change
+ * against it with --baseline on the same machine (the exit code is 1
+ * when a benchmark is slower than the tolerance).
+ */
+int
+main(int argc, char *argv[]) {
+    bool bOnScreen = false;
+    for(int i=1; i<argc; i++) {
+        if(!strcmp(argv[i], "--onscreen"))
+            bOnScreen = true;
+    }
+    if(!bOnScreen)
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QTemporaryDir workDir;
+    if(workDir.isValid())
+        qputenv("XDG_CONFIG_HOME", workDir.path().toUtf8());
+
+    QApplication a(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Score Panel microbenchmarks");
+    parser.addHelpOption();
+    QCommandLineOption filterOption("filter", "Run only the benchmarks containing this text.", "name");
+    QCommandLineOption saveOption("save", "Save the results as a baseline.", "file");
+    QCommandLineOption baselineOption("baseline", "Compare with a baseline.", "file");
+    QCommandLineOption toleranceOption("tolerance", "Accepted slow down (fraction).", "t", "0.15");
+    QCommandLineOption roundOption("round-ms", "Duration of a measure round.", "ms", "200");
+    QCommandLineOption onScreenOption("onscreen", "Show the Panels on the display.");
+    parser.addOption(filterOption);
+    parser.addOption(saveOption);
+    parser.addOption(baselineOption);
+    parser.addOption(toleranceOption);
+    parser.addOption(roundOption);
+    parser.addOption(onScreenOption);
+    parser.process(a);
+
+    // The Panels log a lot: keep the output readable
+    qInstallMessageHandler(quietHandler);
+
+    BenchRunner runner(parser.value(roundOption).toInt());
+    runner.setFilter(parser.value(filterOption));
+    runAllBenchmarks(&runner, &workDir);
+
+    QTextStream out(stdout);
+    runner.report(out);
+    int result = 0;
+    if(parser.isSet(saveOption)) {
+        if(!runner.save(parser.value(saveOption))) {
+            out << "Unable to save " << parser.value(saveOption) << Qt::endl;
+            result = 1;
+        }
+    }
+    if(parser.isSet(baselineOption)) {
+        out << Qt::endl;
+        if(!runner.compare(parser.value(baselineOption), parser.value(toleranceOption).toDouble(), out))
+            result = 1;
+    }
+    qInstallMessageHandler(Q_NULLPTR);
+    return result;
+}
@@ -0,0 +1,129 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QCoreApplication>
+#include <QTextStream>
+
+#include "loadrunner.h"
+#include "loadstatistics.h"
+#include "stubcontroller.h"
+#include "simulatedpanel.h"
+#include "utility.h"
+
+
+/*!
+ * \brief LoadRunner::LoadRunner Drives a whole load test
+ * \param myParameters
+ * \param parent
+ */
+LoadRunner::LoadRunner(loadParameters myParameters, QObject *parent)
+    : QObject(parent)
+    , parameters(myParameters)
+{
+    pStats = new LoadStatistics(parameters.nPanels);
+    pController = new StubController(parameters.port, parameters.pushInterval, pStats, this);
+    for(int i=0; i<parameters.nFiles; i++)
+        pController->addFile(QString("file%1.bin").arg(i), qint64(parameters.fileSizeKB)*1024);
+    connect(&restartTimer, SIGNAL(timeout()),
+            this, SLOT(onTimeToRestart()));
+}
+
+
+/*!
+ * \brief LoadRunner::~LoadRunner
+ */
+LoadRunner::~LoadRunner() {
+    for(int i=0; i<panels.count(); i++)
+        delete panels.at(i);
+    panels.clear();
+    delete pController;
+    pController = Q_NULLPTR;
+    delete pStats;
+}
+
+
+/*!
+ * \brief LoadRunner::start Start the controller and then all the Panels
+ * \return false if the controller can't listen
+ */
+bool
+LoadRunner::start() {
+    if(!pController->listen())
+        return false;
+    QString sUrl = QString("ws://127.0.0.1:%1").arg(parameters.port);
+    for(int i=0; i<parameters.nPanels; i++) {
+        SimulatedPanel* pPanel = new SimulatedPanel(i, sUrl, pStats);
+        panels.append(pPanel);
+        pPanel->start();
+    }
+    runTime.start();
+    if(parameters.restartEvery > 0)
+        restartTimer.start(parameters.restartEvery*1000);
+    // Transfers start once the connection storm is over
+    QTimer::singleShot(1000, this, SLOT(onTimeToStartTransfers()));
+    QTimer::singleShot(parameters.durationS*1000, this, SLOT(onTimeToStop()));
+    return true;
+}
+
+
+/*!
+ * \brief LoadRunner::onTimeToRestart Simulate a controller restart
+ */
+void
+LoadRunner::onTimeToRestart() {
+    pController->shutDown();
+    pStats->controllerRestarted();
+    QTimer::singleShot(parameters.restartDown, this, SLOT(onTimeToListen()));
+}
+
+
+/*!
+ * \brief LoadRunner::onTimeToListen The controller is back
+ */
+void
+LoadRunner::onTimeToListen() {
+    if(!pController->listen()) {
+        logMessage(Q_NULLPTR,
+                   Q_FUNC_INFO,
+                   QString("Unable to restart the controller"));
+    }
+}
+
+
+/*!
+ * \brief LoadRunner::onTimeToStartTransfers Start the concurrent FileUpdaters
+ */
+void
+LoadRunner::onTimeToStartTransfers() {
+    int nTransfers = qMin(parameters.nTransfers, panels.count());
+    for(int i=0; i<nTransfers; i++)
+        panels.at(i)->startTransfer(pController->fileServerUrl());
+}
+
+
+/*!
+ * \brief LoadRunner::onTimeToStop Print the report and exit
+ */
+void
+LoadRunner::onTimeToStop() {
+    restartTimer.stop();
+    QTextStream out(stdout);
+    pStats->report(out, runTime.elapsed());
+    out.flush();
+    QCoreApplication::quit();
+}
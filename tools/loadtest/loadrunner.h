@@ -0,0 +1,73 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef LOADRUNNER_H
+#define LOADRUNNER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVector>
+
+
+class StubController;
+class SimulatedPanel;
+class LoadStatistics;
+
+
+/*!
+ * \brief The loadParameters struct The load test knobs (see main.cpp)
+ */
+struct loadParameters {
+    int     nPanels;       /*!< Simulated Panels */
+    int     durationS;     /*!< Test duration */
+    int     pushInterval;  /*!< Score updates period (ms) */
+    int     restartEvery;  /*!< Controller restart period (s), 0 = never */
+    int     restartDown;   /*!< How long the controller stays down (ms) */
+    int     nTransfers;    /*!< Concurrent file transfers */
+    int     nFiles;        /*!< Files to transfer */
+    int     fileSizeKB;    /*!< Size of each file */
+    quint16 port;          /*!< Stub controller port */
+};
+
+
+class LoadRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    LoadRunner(loadParameters myParameters, QObject *parent = Q_NULLPTR);
+    ~LoadRunner();
+    bool start();
+
+private slots:
+    void onTimeToRestart();
+    void onTimeToListen();
+    void onTimeToStartTransfers();
+    void onTimeToStop();
+
+private:
+    loadParameters           parameters;
+    LoadStatistics*          pStats;
+    StubController*          pController;
+    QVector<SimulatedPanel*> panels;
+    QTimer                   restartTimer;
+    QElapsedTimer            runTime;
+};
+
+#endif // LOADRUNNER_H
@@ -0,0 +1,209 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <algorithm>
+
+#include "loadstatistics.h"
+
+
+#define ACCEPT_BUCKET 100000 // us: the window used for the connection rate
+
+
+// A single clock for the stand-in controller and the Panels
+static QElapsedTimer clock0;
+
+
+/*!
+ * \brief LoadStatistics::LoadStatistics Collects the load test results
+ * \param nSimulatedPanels The number of simulated Panels
+ *
+ * Everything runs in the GUI thread apart the file transfers,
+ * whose results are delivered through queued signals.
+ */
+LoadStatistics::LoadStatistics(int nSimulatedPanels)
+    : nPanels(nSimulatedPanels)
+    , nConnected(0)
+    , nMessages(0)
+    , restartUs(0)
+    , bRecovering(false)
+    , bucketStartUs(0)
+    , bucketAccepts(0)
+    , peakAcceptsPerSecond(0)
+    , nAccepts(0)
+    , transferredBytes(0)
+    , transferMs(0)
+    , nTransfers(0)
+    , nFailedTransfers(0)
+{
+    if(!clock0.isValid())
+        clock0.start();
+}
+
+
+/*!
+ * \brief LoadStatistics::nowUs
+ * \return The time (us) since the start of the test
+ */
+qint64
+LoadStatistics::nowUs() {
+    if(!clock0.isValid())
+        clock0.start();
+    return clock0.nsecsElapsed()/1000;
+}
+
+
+/*!
+ * \brief LoadStatistics::messageReceived A Panel received a score update
+ * \param sentUs When the controller sent it
+ */
+void
+LoadStatistics::messageReceived(qint64 sentUs) {
+    nMessages++;
+    latencyUs.append(nowUs()-sentUs);
+}
+
+
+/*!
+ * \brief LoadStatistics::pongReceived
+ * \param rtt The ping round trip time
+ */
+void
+LoadStatistics::pongReceived(qint64 rtt) {
+    rttMs.append(rtt);
+}
+
+
+/*!
+ * \brief LoadStatistics::panelConnected
+ */
+void
+LoadStatistics::panelConnected() {
+    nConnected++;
+    if(bRecovering && nConnected == nPanels) {
+        recoveryMs.append((nowUs()-restartUs)/1000);
+        bRecovering = false;
+    }
+}
+
+
+/*!
+ * \brief LoadStatistics::panelDisconnected
+ */
+void
+LoadStatistics::panelDisconnected() {
+    nConnected--;
+}
+
+
+/*!
+ * \brief LoadStatistics::connectionAccepted The controller accepted a connection
+ */
+void
+LoadStatistics::connectionAccepted() {
+    nAccepts++;
+    qint64 now = nowUs();
+    if(now-bucketStartUs > ACCEPT_BUCKET) {
+        bucketStartUs = now;
+        bucketAccepts = 0;
+    }
+    bucketAccepts++;
+    peakAcceptsPerSecond = qMax(peakAcceptsPerSecond,
+                                int(bucketAccepts * (1000000/ACCEPT_BUCKET)));
+}
+
+
+/*!
+ * \brief LoadStatistics::controllerRestarted The controller dropped all the Panels
+ */
+void
+LoadStatistics::controllerRestarted() {
+    restartUs   = nowUs();
+    bRecovering = true;
+}
+
+
+/*!
+ * \brief LoadStatistics::transferDone
+ * \param bytes The bytes transferred
+ * \param elapsedMs The transfer time
+ * \param bOk false if the transfer failed
+ */
+void
+LoadStatistics::transferDone(qint64 bytes, qint64 elapsedMs, bool bOk) {
+    if(!bOk) {
+        nFailedTransfers++;
+        return;
+    }
+    nTransfers++;
+    transferredBytes += bytes;
+    transferMs = qMax(transferMs, elapsedMs);// They run in parallel
+}
+
+
+/*!
+ * \brief LoadStatistics::percentile
+ * \param samples
+ * \param fraction (0.0 - 1.0)
+ * \return The requested percentile (-1 with no samples)
+ */
+qint64
+LoadStatistics::percentile(QVector<qint64> samples, double fraction) {
+    if(samples.isEmpty())
+        return -1;
+    std::sort(samples.begin(), samples.end());
+    int i = qMin(samples.count()-1, int(fraction*samples.count()));
+    return samples.at(i);
+}
+
+
+/*!
+ * \brief LoadStatistics::report Write the results
+ * \param out
+ * \param elapsedMs The test duration
+ */
+void
+LoadStatistics::report(QTextStream& out, qint64 elapsedMs) {
+    out << "Panels:                 " << nPanels << " (" << nConnected << " connected at the end)\n";
+    out << "Score updates received: " << nMessages;
+    if(elapsedMs > 0)
+        out << " (" << (nMessages*1000)/elapsedMs << " msg/s)";
+    out << "\n";
+    out << "Update latency (us):    p50 " << percentile(latencyUs, 0.50)
+        << "  p90 "  << percentile(latencyUs, 0.90)
+        << "  p99 "  << percentile(latencyUs, 0.99)
+        << "  max "  << percentile(latencyUs, 1.00) << "\n";
+    out << "Ping RTT (ms):          p50 " << percentile(rttMs, 0.50)
+        << "  p99 "  << percentile(rttMs, 0.99) << "\n";
+    out << "Connections accepted:   " << nAccepts
+        << " (peak " << peakAcceptsPerSecond << "/s)\n";
+    out << "Restarts recovered:     " << recoveryMs.count();
+    if(bRecovering)
+        out << " (+1 not recovered)";
+    out << "\n";
+    if(!recoveryMs.isEmpty()) {
+        out << "All Panels back (ms):   p50 " << percentile(recoveryMs, 0.50)
+            << "  max " << percentile(recoveryMs, 1.00) << "\n";
+    }
+    out << "Transfers:              " << nTransfers << " ok, " << nFailedTransfers << " failed\n";
+    if(transferMs > 0) {
+        out << "Transfer throughput:    "
+            << QString::number(double(transferredBytes)/1048576.0/(double(transferMs)/1000.0), 'f', 1)
+            << " MB/s aggregate\n";
+    }
+    out.flush();
+}
@@ -0,0 +1,66 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef LOADSTATISTICS_H
+#define LOADSTATISTICS_H
+
+#include <QObject>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QTextStream>
+
+
+class LoadStatistics
+{
+public:
+    LoadStatistics(int nPanels);
+    static qint64 nowUs();
+    void messageReceived(qint64 sentUs);
+    void pongReceived(qint64 rttMs);
+    void panelConnected();
+    void panelDisconnected();
+    void connectionAccepted();
+    void controllerRestarted();
+    void transferDone(qint64 bytes, qint64 elapsedMs, bool bOk);
+    void report(QTextStream& out, qint64 elapsedMs);
+
+private:
+    static qint64 percentile(QVector<qint64> samples, double fraction);
+
+private:
+    int             nPanels;
+    int             nConnected;
+    qint64          nMessages;
+    QVector<qint64> latencyUs;
+    QVector<qint64> rttMs;
+    // Reconnect storms
+    qint64          restartUs;
+    bool            bRecovering;
+    QVector<qint64> recoveryMs;
+    qint64          bucketStartUs;
+    int             bucketAccepts;
+    int             peakAcceptsPerSecond;
+    qint64          nAccepts;
+    // Transfers
+    qint64          transferredBytes;
+    qint64          transferMs;
+    int             nTransfers;
+    int             nFailedTransfers;
+};
+
+#endif // LOADSTATISTICS_H
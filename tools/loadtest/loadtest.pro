@@ -0,0 +1,48 @@
+# Load generator: many simulated Panels against a local stand-in controller
+# Build with: qmake && make   (no widgets needed)
+
+QT += core
+QT += gui          # QImageReader (media probe of the received files)
+QT += network
+QT += websockets
+QT -= widgets
+
+CONFIG += c++11
+CONFIG += console
+CONFIG -= app_bundle
+
+TARGET = loadtest
+TEMPLATE = app
+
+DEFINES += QT_DEPRECATED_WARNINGS
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+INCLUDEPATH += ../..
+
+SOURCES += main.cpp
+SOURCES += loadrunner.cpp
+SOURCES += loadstatistics.cpp
+SOURCES += stubcontroller.cpp
+SOURCES += simulatedpanel.cpp
+SOURCES += ../../fileupdater.cpp
+SOURCES += ../../mediaprobe.cpp
+SOURCES += ../../metrics.cpp
+SOURCES += ../../panelsession.cpp
+SOURCES += ../../scoremodel.cpp
+SOURCES += ../../utility.cpp
+SOURCES += ../../asynclogger.cpp
+SOURCES += ../../binarylog.cpp
+
+HEADERS += loadrunner.h
+HEADERS += loadstatistics.h
+HEADERS += stubcontroller.h
+HEADERS += simulatedpanel.h
+HEADERS += ../../fileupdater.h
+HEADERS += ../../mediaprobe.h
+HEADERS += ../../metrics.h
+HEADERS += ../../panelsession.h
+HEADERS += ../../scoremodel.h
+HEADERS += ../../utility.h
+HEADERS += ../../asynclogger.h
+HEADERS += ../../binarylog.h
+HEADERS += ../../sessionpolicy.h
@@ -0,0 +1,114 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QMutex>
+#include <QTextStream>
+
+#include "loadrunner.h"
+
+
+static QFile  logFile;
+static QMutex logMutex;
+
+
+/*!
+ * \brief messageHandler Keeps FileUpdater and qDebug() output out of the report
+ */
+static void
+messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &sMessage) {
+    Q_UNUSED(type)
+    Q_UNUSED(context)
+    QMutexLocker locker(&logMutex);
+    if(!logFile.isOpen())
+        return;
+    logFile.write(sMessage.toUtf8());
+    logFile.write("\n");
+}
+
+
+/*!
+ * \brief main The controller side load test
+ *
+ * It simulates many Panels (with the same session policy of the
+ * real ones) against a local stand-in controller, restarting the
+ * controller periodically and running concurrent file transfers.
+ * The latency percentiles, the reconnect storms and the transfer
+ * throughput are printed at the end.
+ *
+ * <pre>./loadtest --panels 300 --duration 60 --restart-every 15</pre>
+ */
+int
+main(int argc, char *argv[]) {
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("loadtest");
+    QCoreApplication::setApplicationVersion("1.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Score Panel load generator");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    QCommandLineOption panelsOption("panels", "Simulated Panels.", "n", "100");
+    QCommandLineOption durationOption("duration", "Test duration (s).", "s", "30");
+    QCommandLineOption intervalOption("interval", "Score update period (ms).", "ms", "200");
+    QCommandLineOption restartOption("restart-every", "Controller restart period (s), 0 = never.", "s", "10");
+    QCommandLineOption downOption("restart-down", "Controller down time (ms).", "ms", "1000");
+    QCommandLineOption transfersOption("transfers", "Concurrent file transfers.", "n", "4");
+    QCommandLineOption filesOption("files", "Files per transfer.", "n", "3");
+    QCommandLineOption sizeOption("file-size", "File size (KB).", "KB", "4096");
+    QCommandLineOption portOption("port", "Stub controller port.", "port", "45454");
+    parser.addOption(panelsOption);
+    parser.addOption(durationOption);
+    parser.addOption(intervalOption);
+    parser.addOption(restartOption);
+    parser.addOption(downOption);
+    parser.addOption(transfersOption);
+    parser.addOption(filesOption);
+    parser.addOption(sizeOption);
+    parser.addOption(portOption);
+    parser.process(a);
+
+    loadParameters parameters;
+    parameters.nPanels      = qMax(1, parser.value(panelsOption).toInt());
+    parameters.durationS    = qMax(1, parser.value(durationOption).toInt());
+    parameters.pushInterval = qMax(10, parser.value(intervalOption).toInt());
+    parameters.restartEvery = qMax(0, parser.value(restartOption).toInt());
+    parameters.restartDown  = qMax(0, parser.value(downOption).toInt());
+    parameters.nTransfers   = qMax(0, parser.value(transfersOption).toInt());
+    parameters.nFiles       = qMax(1, parser.value(filesOption).toInt());
+    parameters.fileSizeKB   = qMax(1, parser.value(sizeOption).toInt());
+    parameters.port         = quint16(parser.value(portOption).toUInt());
+
+    logFile.setFileName("loadtest.log");
+    if(!logFile.open(QIODevice::WriteOnly|QIODevice::Text)) {
+        QTextStream(stderr) << "Unable to open loadtest.log" << Qt::endl;
+    }
+    qInstallMessageHandler(messageHandler);
+
+    LoadRunner runner(parameters);
+    if(!runner.start()) {
+        QTextStream(stderr) << "Unable to start the stub controller on port "
+                            << parameters.port << Qt::endl;
+        return 1;
+    }
+    int result = a.exec();
+    qInstallMessageHandler(Q_NULLPTR);
+    return result;
+}
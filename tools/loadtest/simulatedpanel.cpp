@@ -0,0 +1,179 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QThread>
+#include <QDir>
+
+#include "simulatedpanel.h"
+#include "loadstatistics.h"
+#include "fileupdater.h"
+#include "panelsession.h"
+#include "scoremodel.h"
+#include "utility.h"
+
+
+/*!
+ * \brief SimulatedPanel::SimulatedPanel A Panel without widgets
+ * \param myId The Panel number
+ * \param myServerUrl The (stand-in) controller URL
+ * \param pStatistics Where to record the results
+ * \param parent
+ *
+ * Its session is the PanelSession of the real Panels: snapshot
+ * request on connection, ping based liveness and background
+ * reconnection with backoff.
+ */
+SimulatedPanel::SimulatedPanel(int myId, QString myServerUrl, LoadStatistics *pStatistics, QObject *parent)
+    : QObject(parent)
+    , id(myId)
+    , sServerUrl(myServerUrl)
+    , pStats(pStatistics)
+    , bConnected(false)
+    , pUpdaterThread(Q_NULLPTR)
+    , pUpdater(Q_NULLPTR)
+{
+    pScoreModel = new ScoreModel(VOLLEY_PANEL, this);
+    pSession = new PanelSession(sServerUrl, QString("panel%1").arg(id), Q_NULLPTR, this);
+    connect(pSession->socket(), SIGNAL(textMessageReceived(QString)),
+            this, SLOT(onTextMessageReceived(QString)));
+    connect(pSession, SIGNAL(sessionStarted(bool)),
+            this, SLOT(onSessionStarted(bool)));
+    connect(pSession, SIGNAL(sessionSuspended()),
+            this, SLOT(onSessionSuspended()));
+    connect(pSession, SIGNAL(sessionLost()),
+            this, SLOT(onSessionLost()));
+    connect(pSession, SIGNAL(pongReceived(qint64)),
+            this, SLOT(onPong(qint64)));
+}
+
+
+/*!
+ * \brief SimulatedPanel::~SimulatedPanel
+ */
+SimulatedPanel::~SimulatedPanel() {
+    pSession->close();
+    if(pUpdaterThread) {
+        pUpdaterThread->disconnect(this);
+        pUpdaterThread->requestInterruption();
+        pUpdaterThread->quit();
+        pUpdaterThread->wait(5000);
+        delete pUpdater;
+        delete pUpdaterThread;
+    }
+}
+
+
+/*!
+ * \brief SimulatedPanel::start Connect to the controller
+ */
+void
+SimulatedPanel::start() {
+    pSession->open();
+}
+
+
+/*!
+ * \brief SimulatedPanel::onSessionStarted The snapshot has been asked
+ * \param bResumed Unused
+ */
+void
+SimulatedPanel::onSessionStarted(bool bResumed) {
+    Q_UNUSED(bResumed)
+    bConnected = true;
+    pStats->panelConnected();
+}
+
+
+/*!
+ * \brief SimulatedPanel::onSessionSuspended The session is being resumed
+ */
+void
+SimulatedPanel::onSessionSuspended() {
+    if(bConnected) {
+        bConnected = false;
+        pStats->panelDisconnected();
+    }
+}
+
+
+/*!
+ * \brief SimulatedPanel::onSessionLost Start again, as a Panel does after a new discovery
+ */
+void
+SimulatedPanel::onSessionLost() {
+    pSession->open();
+}
+
+
+/*!
+ * \brief SimulatedPanel::onPong
+ * \param rtt The round trip time (ms)
+ */
+void
+SimulatedPanel::onPong(qint64 rtt) {
+    pStats->pongReceived(rtt);
+}
+
+
+/*!
+ * \brief SimulatedPanel::onTextMessageReceived Parse the update as a Panel does
+ */
+void
+SimulatedPanel::onTextMessageReceived(QString sMessage) {
+    QString sNoData = QString("NoData");
+    // The same parsing work of a real Panel
+    pScoreModel->update(sMessage);
+    QString sToken = XML_Parse(sMessage, "loadtestStamp");
+    if(sToken != sNoData)
+        pStats->messageReceived(sToken.toLongLong());
+}
+
+
+/*!
+ * \brief SimulatedPanel::startTransfer Download all the files with a FileUpdater
+ * \param sFileServerUrl
+ */
+void
+SimulatedPanel::startTransfer(QString sFileServerUrl) {
+    if(pUpdaterThread || !destinationDir.isValid())
+        return;
+    pUpdaterThread = new QThread();
+    pUpdater = new FileUpdater(QString("Updater%1").arg(id), QUrl(sFileServerUrl));
+    pUpdater->setDestination(destinationDir.path()+QString("/"), QString("*.bin"));
+    pUpdater->moveToThread(pUpdaterThread);
+    connect(pUpdaterThread, SIGNAL(started()),
+            pUpdater, SLOT(startUpdate()));
+    connect(pUpdaterThread, SIGNAL(finished()),
+            this, SLOT(onTransferDone()));
+    transferTime.start();
+    pUpdaterThread->start();
+}
+
+
+/*!
+ * \brief SimulatedPanel::onTransferDone Invoked when the FileUpdater thread exits
+ */
+void
+SimulatedPanel::onTransferDone() {
+    qint64 elapsed = transferTime.elapsed();
+    qint64 bytes = 0;
+    QFileInfoList fileList = QDir(destinationDir.path()).entryInfoList(QStringList() << "*.bin", QDir::Files);
+    for(int i=0; i<fileList.count(); i++)
+        bytes += fileList.at(i).size();
+    pStats->transferDone(bytes, elapsed, pUpdater->returnCode == FileUpdater::TRANSFER_DONE);
+}
@@ -0,0 +1,66 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef SIMULATEDPANEL_H
+#define SIMULATEDPANEL_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+
+
+QT_FORWARD_DECLARE_CLASS(QThread)
+class FileUpdater;
+class ScoreModel;
+class PanelSession;
+class LoadStatistics;
+
+
+class SimulatedPanel : public QObject
+{
+    Q_OBJECT
+
+public:
+    SimulatedPanel(int myId, QString myServerUrl, LoadStatistics *pStatistics, QObject *parent = Q_NULLPTR);
+    ~SimulatedPanel();
+    void start();
+    void startTransfer(QString sFileServerUrl);
+
+private slots:
+    void onSessionStarted(bool bResumed);
+    void onSessionSuspended();
+    void onSessionLost();
+    void onTextMessageReceived(QString sMessage);
+    void onPong(qint64 rtt);
+    void onTransferDone();
+
+private:
+    int             id;
+    QString         sServerUrl;
+    LoadStatistics* pStats;
+    ScoreModel*     pScoreModel;
+    PanelSession*   pSession;
+    bool            bConnected;
+    // File transfer
+    QThread*        pUpdaterThread;
+    FileUpdater*    pUpdater;
+    QTemporaryDir   destinationDir;
+    QElapsedTimer   transferTime;
+};
+
+#endif // SIMULATEDPANEL_H
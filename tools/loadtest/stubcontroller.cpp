@@ -0,0 +1,275 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QWebSocketServer>
+#include <QWebSocket>
+#include <QHostAddress>
+
+#include "stubcontroller.h"
+#include "loadstatistics.h"
+#include "utility.h"
+
+
+#define FILE_HEADER_SIZE 1024 // As expected by FileUpdater
+
+
+/*!
+ * \brief StubController::StubController A stand-in for the Score Controller
+ * \param myPort The Panel Server port (the file server uses the next one)
+ * \param myPushInterval ms between two score updates
+ * \param pStatistics Where to record the results
+ * \param parent
+ *
+ * It speaks the same protocol of the real controller: the status
+ * on <getStatus>, a score update pushed to all the Panels every
+ * pushInterval ms and the file transfers of FileUpdater.
+ * Each update carries the time it has been sent, so the Panels
+ * can measure the delivery latency.
+ */
+StubController::StubController(quint16 myPort, int myPushInterval, LoadStatistics *pStatistics, QObject *parent)
+    : QObject(parent)
+    , pStats(pStatistics)
+    , port(myPort)
+    , pushInterval(myPushInterval)
+    , pScoreServer(Q_NULLPTR)
+    , pFileServer(Q_NULLPTR)
+    , iScore(0)
+{
+    connect(&pushTimer, SIGNAL(timeout()),
+            this, SLOT(onTimeToPushScore()));
+}
+
+
+/*!
+ * \brief StubController::~StubController
+ */
+StubController::~StubController() {
+    shutDown();
+}
+
+
+/*!
+ * \brief StubController::listen Start (or restart) serving the Panels
+ * \return false if the ports are not available
+ */
+bool
+StubController::listen() {
+    pScoreServer = new QWebSocketServer(QString("Stub Controller"), QWebSocketServer::NonSecureMode, this);
+    pFileServer  = new QWebSocketServer(QString("Stub File Server"), QWebSocketServer::NonSecureMode, this);
+    if(!pScoreServer->listen(QHostAddress::LocalHost, port) ||
+       !pFileServer->listen(QHostAddress::LocalHost, port+1))
+    {
+        logMessage(Q_NULLPTR,
+                   Q_FUNC_INFO,
+                   QString("Unable to listen on ports %1-%2").arg(port).arg(port+1));
+        shutDown();
+        return false;
+    }
+    connect(pScoreServer, SIGNAL(newConnection()),
+            this, SLOT(onNewConnection()));
+    connect(pFileServer, SIGNAL(newConnection()),
+            this, SLOT(onNewFileConnection()));
+    if(pushInterval > 0)
+        pushTimer.start(pushInterval);
+    return true;
+}
+
+
+/*!
+ * \brief StubController::shutDown Drop all the Panels, as a controller restart does
+ */
+void
+StubController::shutDown() {
+    pushTimer.stop();
+    for(int i=0; i<clients.count(); i++) {
+        clients.at(i)->disconnect(this);
+        clients.at(i)->abort();
+        clients.at(i)->deleteLater();
+    }
+    clients.clear();
+    for(int i=0; i<fileClients.count(); i++) {
+        fileClients.at(i)->disconnect(this);
+        fileClients.at(i)->abort();
+        fileClients.at(i)->deleteLater();
+    }
+    fileClients.clear();
+    if(pScoreServer) {
+        pScoreServer->close();
+        pScoreServer->deleteLater();
+        pScoreServer = Q_NULLPTR;
+    }
+    if(pFileServer) {
+        pFileServer->close();
+        pFileServer->deleteLater();
+        pFileServer = Q_NULLPTR;
+    }
+}
+
+
+/*!
+ * \brief StubController::addFile Add a (synthetic) file to transfer
+ * \param sName The file name
+ * \param size Its size in bytes
+ */
+void
+StubController::addFile(QString sName, qint64 size) {
+    QByteArray content(int(size), Qt::Uninitialized);
+    for(int i=0; i<content.size(); i++)
+        content[i] = char(i*31 + 7);
+    files.insert(sName, content);
+}
+
+
+/*!
+ * \brief StubController::fileServerUrl
+ * \return The URL to give to FileUpdater
+ */
+QString
+StubController::fileServerUrl() {
+    return QString("ws://127.0.0.1:%1").arg(port+1);
+}
+
+
+/*!
+ * \brief StubController::statusMessage
+ * \return A score update stamped with the present time
+ */
+QString
+StubController::statusMessage() {
+    return QString("<team0>Locali</team0><team1>Ospiti</team1>"
+                   "<score0>%1</score0><score1>%2</score1>"
+                   "<loadtestStamp>%3</loadtestStamp>")
+            .arg(iScore)
+            .arg(iScore/2)
+            .arg(LoadStatistics::nowUs());
+}
+
+
+/*!
+ * \brief StubController::onNewConnection A Panel connected
+ */
+void
+StubController::onNewConnection() {
+    while(pScoreServer->hasPendingConnections()) {
+        QWebSocket* pClient = pScoreServer->nextPendingConnection();
+        connect(pClient, SIGNAL(textMessageReceived(QString)),
+                this, SLOT(onClientTextMessage(QString)));
+        connect(pClient, SIGNAL(disconnected()),
+                this, SLOT(onClientDisconnected()));
+        clients.append(pClient);
+        pStats->connectionAccepted();
+    }
+}
+
+
+/*!
+ * \brief StubController::onClientTextMessage The only request handled is <getStatus>
+ */
+void
+StubController::onClientTextMessage(QString sMessage) {
+    QWebSocket* pClient = qobject_cast<QWebSocket*>(sender());
+    if(XML_Parse(sMessage, "getStatus") != QString("NoData"))
+        pClient->sendTextMessage(statusMessage());
+}
+
+
+/*!
+ * \brief StubController::onClientDisconnected
+ */
+void
+StubController::onClientDisconnected() {
+    QWebSocket* pClient = qobject_cast<QWebSocket*>(sender());
+    clients.removeAll(pClient);
+    pClient->deleteLater();
+}
+
+
+/*!
+ * \brief StubController::onTimeToPushScore Push a new score to all the Panels
+ */
+void
+StubController::onTimeToPushScore() {
+    iScore++;
+    for(int i=0; i<clients.count(); i++)
+        clients.at(i)->sendTextMessage(statusMessage());
+}
+
+
+/*!
+ * \brief StubController::onNewFileConnection A FileUpdater connected
+ */
+void
+StubController::onNewFileConnection() {
+    while(pFileServer->hasPendingConnections()) {
+        QWebSocket* pClient = pFileServer->nextPendingConnection();
+        connect(pClient, SIGNAL(textMessageReceived(QString)),
+                this, SLOT(onFileRequest(QString)));
+        connect(pClient, SIGNAL(disconnected()),
+                this, SLOT(onFileClientDisconnected()));
+        fileClients.append(pClient);
+    }
+}
+
+
+/*!
+ * \brief StubController::onFileRequest Serve the FileUpdater requests
+ *
+ * <send_file_list> gets the list of "name;size" and <get>name,offset,chunk</get>
+ * a chunk of the file (preceded by the header if offset is 0).
+ */
+void
+StubController::onFileRequest(QString sMessage) {
+    QWebSocket* pClient = qobject_cast<QWebSocket*>(sender());
+    QString sNoData = QString("NoData");
+    if(XML_Parse(sMessage, "send_file_list") != sNoData) {
+        QStringList fileList;
+        for(QMap<QString,QByteArray>::const_iterator it=files.constBegin(); it!=files.constEnd(); ++it)
+            fileList.append(QString("%1;%2").arg(it.key()).arg(it.value().size()));
+        pClient->sendTextMessage(QString("<file_list>%1</file_list>").arg(fileList.join(",")));
+        return;
+    }
+    QString sToken = XML_Parse(sMessage, "get");
+    if(sToken == sNoData)
+        return;
+    QStringList arguments = sToken.split(",", Qt::SkipEmptyParts);
+    if(arguments.count() < 3 || !files.contains(arguments.at(0)))
+        return;
+    const QByteArray& content = files[arguments.at(0)];
+    int offset = arguments.at(1).toInt();
+    int chunk  = arguments.at(2).toInt();
+    QByteArray message;
+    if(offset == 0) {
+        QByteArray header = QString("%1,%2").arg(arguments.at(0)).arg(content.size()).toUtf8();
+        header.append('\0');
+        header = header.leftJustified(FILE_HEADER_SIZE, '\0', true);
+        message = header;
+    }
+    message.append(content.mid(offset, chunk));
+    pClient->sendBinaryMessage(message);
+}
+
+
+/*!
+ * \brief StubController::onFileClientDisconnected
+ */
+void
+StubController::onFileClientDisconnected() {
+    QWebSocket* pClient = qobject_cast<QWebSocket*>(sender());
+    fileClients.removeAll(pClient);
+    pClient->deleteLater();
+}
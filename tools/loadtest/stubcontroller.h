@@ -0,0 +1,70 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef STUBCONTROLLER_H
+#define STUBCONTROLLER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QMap>
+#include <QList>
+
+
+QT_FORWARD_DECLARE_CLASS(QWebSocketServer)
+QT_FORWARD_DECLARE_CLASS(QWebSocket)
+class LoadStatistics;
+
+
+class StubController : public QObject
+{
+    Q_OBJECT
+
+public:
+    StubController(quint16 myPort, int myPushInterval, LoadStatistics *pStatistics, QObject *parent = Q_NULLPTR);
+    ~StubController();
+    bool listen();
+    void shutDown();
+    void addFile(QString sName, qint64 size);
+    QString fileServerUrl();
+
+private slots:
+    void onNewConnection();
+    void onNewFileConnection();
+    void onClientTextMessage(QString sMessage);
+    void onClientDisconnected();
+    void onFileRequest(QString sMessage);
+    void onFileClientDisconnected();
+    void onTimeToPushScore();
+
+private:
+    QString statusMessage();
+
+private:
+    LoadStatistics*          pStats;
+    quint16                  port;
+    int                      pushInterval;
+    QWebSocketServer*        pScoreServer;
+    QWebSocketServer*        pFileServer;
+    QList<QWebSocket*>       clients;
+    QList<QWebSocket*>       fileClients;
+    QMap<QString,QByteArray> files;
+    QTimer                   pushTimer;
+    int                      iScore;
+};
+
+#endif // STUBCONTROLLER_H
@@ -0,0 +1,22 @@
+# Decodes the binary log (see BinaryLog) written by the Panel
+# when built with LOG_BINARY defined, and the flight recorder dumps.
+# Build with: qmake && make
+
+QT -= gui
+
+CONFIG += c++11
+CONFIG += console
+CONFIG -= app_bundle
+
+TARGET = logdecode
+TEMPLATE = app
+
+DEFINES += QT_DEPRECATED_WARNINGS
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+INCLUDEPATH += ../..
+
+SOURCES += main.cpp
+SOURCES += ../../binarylog.cpp
+
+HEADERS += ../../binarylog.h
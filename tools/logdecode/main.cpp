@@ -0,0 +1,160 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QDateTime>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+#include <algorithm>
+#include <cstring>
+
+#include "binarylog.h"
+
+
+/*!
+ * \brief bySequence The records in the order they were written
+ */
+static bool
+bySequence(const BinaryLog::logRecord& first, const BinaryLog::logRecord& second) {
+    return first.seq < second.seq;
+}
+
+
+/*!
+ * \brief readStrings The interned strings stored after the file header
+ */
+static QStringList
+readStrings(const QByteArray& baTable) {
+    QStringList sStrings;
+    int pos = 0;
+    quint16 len;
+    while(pos+int(sizeof(len)) <= baTable.size()) {
+        memcpy(&len, baTable.constData()+pos, sizeof(len));
+        if(len == 0)
+            break;
+        pos += int(sizeof(len));
+        sStrings.append(QString::fromUtf8(baTable.mid(pos, len)));
+        pos += len;
+    }
+    return sStrings;
+}
+
+
+/*!
+ * \brief argument The text of an argument, according to its type
+ */
+static QString
+argument(BinaryLog::argType type, qint64 value, const QStringList& sStrings) {
+    if(type == BinaryLog::String) {
+        if(value >= 0 && value < sStrings.count())
+            return sStrings.at(int(value));
+        return QString("#%1").arg(value);
+    }
+    return QString::number(value);
+}
+
+
+/*!
+ * \brief main Decodes a BinaryLog file in the format of the text log
+ *
+ * <pre>./logdecode [--last n] [--us] score_panel_log.bin</pre>
+ * The flight recorder dumps (score_panel_flight.bin) have the same format.
+ */
+int
+main(int argc, char *argv[]) {
+    QCoreApplication a(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Score Panel binary log decoder");
+    parser.addHelpOption();
+    QCommandLineOption lastOption("last", "Decode only the last n records.", "n", "0");
+    QCommandLineOption usOption("us", "Show the time in microseconds since the Panel start.");
+    parser.addOption(lastOption);
+    parser.addOption(usOption);
+    parser.addPositionalArgument("log", "The binary log file.");
+    parser.process(a);
+    if(parser.positionalArguments().count() != 1)
+        parser.showHelp(1);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    QString sFileName = parser.positionalArguments().at(0);
+    QFile logFile(sFileName);
+    if(!logFile.open(QIODevice::ReadOnly)) {
+        err << "Unable to open " << sFileName << ": " << logFile.errorString() << Qt::endl;
+        return 1;
+    }
+    BinaryLog::fileHeader header;
+    if(logFile.read(reinterpret_cast<char*>(&header), sizeof(header)) != qint64(sizeof(header)) ||
+       header.magic != BinaryLog::magic)
+    {
+        err << sFileName << " is not a Score Panel binary log" << Qt::endl;
+        return 1;
+    }
+    if(header.version != BinaryLog::version ||
+       header.recordSize != sizeof(BinaryLog::logRecord))
+    {
+        err << "Unsupported version " << header.version
+            << " (record size " << header.recordSize << ")" << Qt::endl;
+        return 1;
+    }
+    logFile.seek(BinaryLog::headerSize);
+    QStringList sStrings = readStrings(logFile.read(header.tableSize));
+
+    // The ring is read all at once: the oldest records may be anywhere
+    QVector<BinaryLog::logRecord> records;
+    records.reserve(int(header.capacity));
+    BinaryLog::logRecord record;
+    for(quint32 i=0; i<header.capacity; i++) {
+        if(logFile.read(reinterpret_cast<char*>(&record), sizeof(record)) != qint64(sizeof(record)))
+            break;
+        if(record.seq != 0)// Empty or partially written
+            records.append(record);
+    }
+    std::sort(records.begin(), records.end(), bySequence);
+
+    int first = 0;
+    int nLast = parser.value(lastOption).toInt();
+    if(nLast > 0 && nLast < records.count())
+        first = records.count()-nLast;
+    bool bMicroseconds = parser.isSet(usOption);
+    quint32 lostRecords = 0;
+    for(int i=first; i<records.count(); i++) {
+        const BinaryLog::logRecord& current = records.at(i);
+        if(i > first && current.seq != records.at(i-1).seq+1)
+            lostRecords += current.seq-records.at(i-1).seq-1;
+        const BinaryLog::eventInfo& info = BinaryLog::info(current.event);
+        QString sMessage = QString(info.sFormat);
+        for(int j=0; j<2; j++) {
+            if(info.types[j] != BinaryLog::NoArg)
+                sMessage = sMessage.arg(argument(info.types[j], current.args[j], sStrings));
+        }
+        QString sTime;
+        if(bMicroseconds)
+            sTime = QString::number(current.timeUs);
+        else
+            sTime = QDateTime::fromMSecsSinceEpoch(header.startMs + current.timeUs/1000).toString();
+        out << sTime << " - " << info.sSource << " - " << sMessage << "\n";
+    }
+    out.flush();
+    if(lostRecords > 0)
+        err << lostRecords << " records missing (partially written)" << Qt::endl;
+    return 0;
+}
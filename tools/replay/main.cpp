@@ -0,0 +1,75 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <cstring>
+
+#include "replayer.h"
+
+
+/*!
+ * \brief main Replay a capture of the Server messages
+ *
+ * <pre>./replay [--fast] [--loops n] [--onscreen] score_panel_capture.bin</pre>
+ *
+ * Without --fast the original timing is kept; with it the messages
+ * are given to the Panel as fast as it can process and paint them,
+ * which makes it a parse/dispatch/render throughput benchmark.
+ * The Panel runs offscreen (unless --onscreen) and with empty
+ * settings, so the results do not depend on the machine.
+ */
+int
+main(int argc, char *argv[]) {
+    bool bOnScreen = false;
+    for(int i=1; i<argc; i++) {
+        if(!strcmp(argv[i], "--onscreen"))
+            bOnScreen = true;
+    }
+    if(!bOnScreen)
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    // Keep the user settings untouched (and out of the measures)
+    QTemporaryDir settingsDir;
+    if(settingsDir.isValid())
+        qputenv("XDG_CONFIG_HOME", settingsDir.path().toUtf8());
+
+    QApplication a(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Score Panel capture replay");
+    parser.addHelpOption();
+    QCommandLineOption fastOption("fast", "Replay as fast as possible.");
+    QCommandLineOption loopsOption("loops", "Replay the capture n times.", "n", "1");
+    QCommandLineOption onScreenOption("onscreen", "Show the Panel on the display.");
+    parser.addOption(fastOption);
+    parser.addOption(loopsOption);
+    parser.addOption(onScreenOption);
+    parser.addPositionalArgument("capture", "The capture file.");
+    parser.process(a);
+    if(parser.positionalArguments().count() != 1)
+        parser.showHelp(1);
+
+    Replayer replayer(parser.isSet(fastOption), parser.value(loopsOption).toInt());
+    if(!replayer.start(parser.positionalArguments().at(0))) {
+        QTextStream(stderr) << "Unable to replay "
+                            << parser.positionalArguments().at(0) << Qt::endl;
+        return 1;
+    }
+    return a.exec();
+}
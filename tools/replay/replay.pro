@@ -0,0 +1,19 @@
+# Replays a capture of the Server messages (see ProtocolCapture)
+# through the real Segnapunti Panels.
+# Build with: qmake && make
+
+CONFIG += c++11
+CONFIG -= app_bundle
+
+TARGET = replay
+TEMPLATE = app
+
+DEFINES += QT_DEPRECATED_WARNINGS
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+include(../../scorepanel.pri)
+
+SOURCES += main.cpp
+SOURCES += replayer.cpp
+
+HEADERS += replayer.h
@@ -0,0 +1,259 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QWebSocketServer>
+#include <QWebSocket>
+#include <QApplication>
+#include <QTextStream>
+#include <QRegularExpression>
+#include <algorithm>
+
+#include "replayer.h"
+#include "segnapuntivolley.h"
+#include "segnapuntibasket.h"
+#include "segnapuntihandball.h"
+#include "utility.h"
+
+
+// Commands that would halt the machine, start media players or
+// processes, move the camera or write files: not part of a replay
+static const char *sideEffectTags[] = {
+    "kill", "endspot", "spotloop", "endspotloop",
+    "slideshow", "endslideshow", "live", "endlive",
+    "pan", "tilt", "capture", "saveTrace", "dumpTrace"
+};
+
+
+/*!
+ * \brief Replayer::Replayer Feeds a capture to a real Segnapunti Panel
+ * \param bAsFastAsPossible false to keep the original timing
+ * \param nLoops How many times the capture is replayed
+ * \param parent
+ *
+ * The Panel connects to a silent local stand-in for the Server, so
+ * that its session stays up, while the captured messages are given
+ * directly to its handlers. Every message is timed from the handler
+ * call to the end of the repaint it causes.
+ * The commands with side effects (halt, processes, media players)
+ * are stripped from the capture: see stripSideEffects().
+ */
+Replayer::Replayer(bool bAsFastAsPossible, int nLoops, QObject *parent)
+    : QObject(parent)
+    , bFast(bAsFastAsPossible)
+    , loops(qMax(1, nLoops))
+    , iLoop(0)
+    , iNext(0)
+    , pServer(Q_NULLPTR)
+    , pPanel(Q_NULLPTR)
+    , loopStartUs(0)
+    , nStripped(0)
+{
+    feedTimer.setSingleShot(true);
+    connect(&feedTimer, SIGNAL(timeout()),
+            this, SLOT(onTimeToFeed()));
+}
+
+
+/*!
+ * \brief Replayer::~Replayer
+ */
+Replayer::~Replayer() {
+    feedTimer.stop();
+    delete pPanel;
+    for(int i=0; i<clients.count(); i++)
+        delete clients.at(i);
+    delete pServer;
+}
+
+
+/*!
+ * \brief Replayer::start Load the capture, build the Panel and start feeding it
+ * \param sCaptureFile
+ * \return false if the capture can't be used
+ */
+bool
+Replayer::start(QString sCaptureFile) {
+    ProtocolCapture capture;
+    if(!capture.open(sCaptureFile))
+        return false;
+    captureRecord record;
+    while(capture.next(record)) {
+        if(record.kind == ProtocolCapture::TextMessage) {
+            QString sMessage = QString::fromUtf8(record.payload);
+            if(stripSideEffects(sMessage)) {
+                nStripped++;
+                if(sMessage.trimmed().isEmpty())
+                    continue;
+                record.payload = sMessage.toUtf8();
+            }
+        }
+        records.append(record);
+    }
+    if(nStripped > 0) {
+        logMessage(Q_NULLPTR,
+                   Q_FUNC_INFO,
+                   QString("%1 messages with process, media or halt commands stripped")
+                   .arg(nStripped));
+    }
+    if(records.isEmpty()) {
+        logMessage(Q_NULLPTR,
+                   Q_FUNC_INFO,
+                   QString("No messages in %1").arg(sCaptureFile));
+        return false;
+    }
+
+    pServer = new QWebSocketServer(QString("Replay"), QWebSocketServer::NonSecureMode, this);
+    if(!pServer->listen(QHostAddress::LocalHost, 0)) {
+        logMessage(Q_NULLPTR,
+                   Q_FUNC_INFO,
+                   QString("Unable to start the stand-in Server"));
+        return false;
+    }
+    connect(pServer, SIGNAL(newConnection()),
+            this, SLOT(onNewConnection()));
+    QString sServerUrl = QString("ws://127.0.0.1:%1").arg(pServer->serverPort());
+
+    if(capture.panelType() == VOLLEY_PANEL)
+        pPanel = new SegnapuntiVolley(sServerUrl, Q_NULLPTR);
+    else if(capture.panelType() == BASKET_PANEL)
+        pPanel = new SegnapuntiBasket(sServerUrl, Q_NULLPTR);
+    else if(capture.panelType() == HANDBALL_PANEL)
+        pPanel = new SegnapuntiHandball(sServerUrl, Q_NULLPTR);
+    else {
+        logMessage(Q_NULLPTR,
+                   Q_FUNC_INFO,
+                   QString("Unknown panel type %1").arg(capture.panelType()));
+        return false;
+    }
+    pPanel->showFullScreen();
+
+    messageUs.reserve(records.count()*loops);
+    replayTime.start();
+    loopStartUs = 0;
+    feedTimer.start(0);
+    return true;
+}
+
+
+/*!
+ * \brief Replayer::stripSideEffects Remove the commands listed in sideEffectTags
+ * \param sMessage The message to clean (modified in place)
+ * \return true if something has been removed
+ */
+bool
+Replayer::stripSideEffects(QString& sMessage) {
+    bool bStripped = false;
+    for(size_t i=0; i<sizeof(sideEffectTags)/sizeof(sideEffectTags[0]); i++) {
+        QString sTag = QString(sideEffectTags[i]);
+        QRegularExpression command(QString("<%1>.*?</%1>").arg(sTag),
+                                   QRegularExpression::DotMatchesEverythingOption);
+        int length = sMessage.length();
+        sMessage.remove(command);
+        if(sMessage.length() != length)
+            bStripped = true;
+    }
+    return bStripped;
+}
+
+
+/*!
+ * \brief Replayer::onNewConnection The stand-in Server accepts and ignores the Panel
+ */
+void
+Replayer::onNewConnection() {
+    QWebSocket *pClient = pServer->nextPendingConnection();
+    if(pClient)
+        clients.append(pClient);
+}
+
+
+/*!
+ * \brief Replayer::onTimeToFeed Give the Panel the next message(s)
+ */
+void
+Replayer::onTimeToFeed() {
+    for(;;) {
+        feed(records.at(iNext));
+        iNext++;
+        if(iNext >= records.count()) {
+            iNext = 0;
+            iLoop++;
+            if(iLoop >= loops) {
+                finish();
+                return;
+            }
+            loopStartUs = replayTime.nsecsElapsed()/1000;
+        }
+        if(bFast)
+            continue;
+        qint64 dueUs = loopStartUs + records.at(iNext).timeUs - records.at(0).timeUs;
+        qint64 waitUs = dueUs - replayTime.nsecsElapsed()/1000;
+        feedTimer.start(int(qMax(qint64(0), waitUs/1000)));
+        return;
+    }
+}
+
+
+/*!
+ * \brief Replayer::feed Run a message through the Panel handlers (and the repaint)
+ */
+void
+Replayer::feed(const captureRecord& record) {
+    QElapsedTimer messageTime;
+    messageTime.start();
+    if(record.kind == ProtocolCapture::TextMessage) {
+        QString sMessage = QString::fromUtf8(record.payload);
+        QMetaObject::invokeMethod(pPanel, "onMessageArrived", Qt::DirectConnection,
+                                  Q_ARG(QString, sMessage));
+        QMetaObject::invokeMethod(pPanel, "onTextMessageReceived", Qt::DirectConnection,
+                                  Q_ARG(QString, sMessage));
+    }
+    else {
+        QMetaObject::invokeMethod(pPanel, "onBinaryMessageArrived", Qt::DirectConnection,
+                                  Q_ARG(QByteArray, record.payload));
+        QMetaObject::invokeMethod(pPanel, "onBinaryMessageReceived", Qt::DirectConnection,
+                                  Q_ARG(QByteArray, record.payload));
+    }
+    // The repaint (an UpdateRequest posted to the Panel window)
+    QCoreApplication::processEvents();
+    messageUs.append(messageTime.nsecsElapsed()/1000);
+}
+
+
+/*!
+ * \brief Replayer::finish Print the results and quit
+ */
+void
+Replayer::finish() {
+    qint64 elapsedMs = replayTime.elapsed();
+    QVector<qint64> samples = messageUs;
+    std::sort(samples.begin(), samples.end());
+    int n = samples.count();
+    QTextStream out(stdout);
+    out << "messages:     " << n << Qt::endl;
+    out << "elapsed ms:   " << elapsedMs << Qt::endl;
+    if(elapsedMs > 0)
+        out << "messages/s:   " << double(n)*1000.0/double(elapsedMs) << Qt::endl;
+    if(n > 0) {
+        out << "message us p50/p99/max: "
+            << samples.at((n-1)*50/100) << "/"
+            << samples.at((n-1)*99/100) << "/"
+            << samples.at(n-1) << Qt::endl;
+    }
+    QCoreApplication::quit();
+}
@@ -0,0 +1,70 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef REPLAYER_H
+#define REPLAYER_H
+
+#include <QObject>
+#include <QVector>
+#include <QList>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include "protocolcapture.h"
+
+
+QT_FORWARD_DECLARE_CLASS(QWebSocketServer)
+QT_FORWARD_DECLARE_CLASS(QWebSocket)
+QT_FORWARD_DECLARE_CLASS(ScorePanel)
+
+
+class Replayer : public QObject
+{
+    Q_OBJECT
+
+public:
+    Replayer(bool bAsFastAsPossible, int nLoops, QObject *parent = Q_NULLPTR);
+    ~Replayer();
+    bool start(QString sCaptureFile);
+
+private slots:
+    void onNewConnection();
+    void onTimeToFeed();
+
+private:
+    bool stripSideEffects(QString& sMessage);
+    void feed(const captureRecord& record);
+    void finish();
+
+private:
+    bool                   bFast;
+    int                    loops;
+    int                    iLoop;
+    int                    iNext;
+    QVector<captureRecord> records;
+    QWebSocketServer*      pServer;
+    QList<QWebSocket*>     clients;
+    ScorePanel*            pPanel;
+    QTimer                 feedTimer;
+    QElapsedTimer          replayTime;
+    qint64                 loopStartUs;
+    QVector<qint64>        messageUs;
+    int                    nStripped;
+};
+
+#endif // REPLAYER_H
@@ -0,0 +1,210 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QSaveFile>
+#include <QCoreApplication>
+#include <algorithm>
+
+#include "tracer.h"
+#include "utility.h"
+#include "metrics.h"
+
+
+/*!
+ * \brief Tracer::Tracer Timestamps every score update along its way to the screen
+ * \param myLogFile
+ * \param myCapacity The number of updates kept (the oldest are overwritten)
+ *
+ * An update starts when the message leaves the socket and ends when
+ * the window holding the new score has been repainted. The last
+ * updates can be saved as a Chrome trace (chrome://tracing or
+ * ui.perfetto.dev) and their latency percentiles reported.
+ */
+Tracer::Tracer(QFile *myLogFile, int myCapacity)
+    : logFile(myLogFile)
+    , capacity(qMax(1, myCapacity))
+    , iNext(0)
+    , bPending(false)
+{
+    updates.reserve(capacity);
+    clock.start();
+}
+
+
+/*!
+ * \brief Tracer::nowUs
+ * \return Microseconds since the Tracer creation (monotonic)
+ */
+qint64
+Tracer::nowUs() {
+    return clock.nsecsElapsed()/1000;
+}
+
+
+/*!
+ * \brief Tracer::begin A new message has been received
+ *
+ * A previous update that did not cause a repaint is kept
+ * without the Painted stage.
+ */
+void
+Tracer::begin() {
+    if(bPending)
+        close();
+    for(int i=0; i<nStages; i++)
+        pending.timeUs[i] = -1;
+    pending.timeUs[Received] = nowUs();
+    bPending = true;
+}
+
+
+/*!
+ * \brief Tracer::mark The present update reached a stage
+ */
+void
+Tracer::mark(traceStage stage) {
+    if(bPending)
+        pending.timeUs[stage] = nowUs();
+}
+
+
+/*!
+ * \brief Tracer::painted Invoked when the Panel window has been repainted
+ */
+void
+Tracer::painted() {
+    if(!bPending || pending.timeUs[Dispatched] < 0)
+        return;
+    pending.timeUs[Painted] = nowUs();
+    close();
+}
+
+
+/*!
+ * \brief Tracer::notPainted The present update didn't require a repaint
+ *
+ * It is stored without the Painted stage, so that
+ * a later unrelated repaint is not charged to it.
+ */
+void
+Tracer::notPainted() {
+    if(!bPending || pending.timeUs[Dispatched] < 0)
+        return;
+    close();
+}
+
+
+/*!
+ * \brief Tracer::close Store the pending update (and feed the Metrics histograms)
+ */
+void
+Tracer::close() {
+    bPending = false;
+    if(pending.timeUs[Parsed] >= 0)
+        Metrics::sample(Metrics::ParseTime, pending.timeUs[Parsed]-pending.timeUs[Received]);
+    if(pending.timeUs[Painted] >= 0)
+        Metrics::sample(Metrics::PaintTime, pending.timeUs[Painted]-pending.timeUs[Dispatched]);
+    if(updates.count() < capacity)
+        updates.append(pending);
+    else
+        updates[iNext] = pending;
+    iNext = (iNext+1) % capacity;
+}
+
+
+/*!
+ * \brief Tracer::latencyReport
+ * \return "count,p50,p99,max" of the receive to paint latency in us
+ */
+QString
+Tracer::latencyReport() {
+    QVector<qint64> samples;
+    samples.reserve(updates.count());
+    for(int i=0; i<updates.count(); i++) {
+        const traceUpdate& update = updates.at(i);
+        if(update.timeUs[Painted] >= 0)
+            samples.append(update.timeUs[Painted]-update.timeUs[Received]);
+    }
+    if(samples.isEmpty())
+        return QString("0,0,0,0");
+    std::sort(samples.begin(), samples.end());
+    int n = samples.count();
+    return QString("%1,%2,%3,%4")
+            .arg(n)
+            .arg(samples.at((n-1)*50/100))
+            .arg(samples.at((n-1)*99/100))
+            .arg(samples.at(n-1));
+}
+
+
+/*!
+ * \brief Tracer::save Write the stored updates as a Chrome trace (JSON)
+ * \param sFileName
+ * \return true on success
+ */
+bool
+Tracer::save(QString sFileName) {
+    static const char* stageName[nStages] = {
+        "score update", "parse", "widget update", "dispatch", "paint"
+    };
+    QSaveFile file(sFileName);
+    if(!file.open(QIODevice::WriteOnly)) {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Unable to open %1: %2")
+                   .arg(sFileName, file.errorString()));
+        return false;
+    }
+    qint64 pid = QCoreApplication::applicationPid();
+    QString sEvent("{\"name\":\"%1\",\"ph\":\"X\",\"pid\":%2,\"tid\":1,\"ts\":%3,\"dur\":%4}");
+    QByteArray baTrace("{\"traceEvents\":[\n");
+    bool bFirst = true;
+    // From the oldest to the newest
+    int iFirst = updates.count() < capacity ? 0 : iNext;
+    for(int n=0; n<updates.count(); n++) {
+        const traceUpdate& update = updates.at((iFirst+n) % updates.count());
+        qint64 lastUs = update.timeUs[Received];
+        qint64 endUs = lastUs;
+        for(int i=Parsed; i<nStages; i++) {
+            if(update.timeUs[i] < 0)
+                continue;
+            if(!bFirst) baTrace += ",\n";
+            baTrace += sEvent.arg(stageName[i])
+                             .arg(pid)
+                             .arg(lastUs)
+                             .arg(update.timeUs[i]-lastUs).toUtf8();
+            bFirst = false;
+            lastUs = endUs = update.timeUs[i];
+        }
+        if(!bFirst) baTrace += ",\n";
+        baTrace += sEvent.arg(stageName[Received])
+                         .arg(pid)
+                         .arg(update.timeUs[Received])
+                         .arg(endUs-update.timeUs[Received]).toUtf8();
+        bFirst = false;
+    }
+    baTrace += "\n]}\n";
+    file.write(baTrace);
+    if(!file.commit()) {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Unable to write %1").arg(sFileName));
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,71 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QVector>
+#include <QElapsedTimer>
+#include <QString>
+
+
+QT_FORWARD_DECLARE_CLASS(QFile)
+
+
+class Tracer
+{
+public:
+    /*!
+     * \brief The traceStage enum The steps of a score update
+     */
+    enum traceStage {
+        Received,  /*!< The message came out of the socket */
+        Parsed,    /*!< The score model has been updated */
+        Updated,   /*!< The widgets have been updated */
+        Dispatched,/*!< The commands in the message have been executed */
+        Painted,   /*!< The window has been repainted and flushed */
+        nStages
+    };
+
+public:
+    Tracer(QFile *myLogFile, int myCapacity = 4096);
+    qint64 nowUs();
+    void begin();
+    void mark(traceStage stage);
+    void painted();
+    void notPainted();
+    QString latencyReport();
+    bool save(QString sFileName);
+
+private:
+    void close();
+
+private:
+    struct traceUpdate {
+        qint64 timeUs[nStages];
+    };
+    QFile*               logFile;
+    QElapsedTimer        clock;
+    QVector<traceUpdate> updates;
+    int                  capacity;
+    int                  iNext;
+    bool                 bPending;
+    traceUpdate          pending;
+};
+
+#endif // TRACER_H
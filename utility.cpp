@@ -19,8 +19,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QTextStream>
 #include <QDateTime>
 #include <QDebug>
+#include <QMutex>
+#include <QMutexLocker>
 
 #include "utility.h"
+#include "asynclogger.h"
+
+
+// Serializes the synchronous writes (when there is no AsyncLogger)
+static QMutex logMutex;
 
 
 /*!
@@ -60,9 +67,14 @@ XML_Parse(QString input_string, QString token) {
  * \param logFile The file where to write the log
  * \param sFunctionName The Function which requested to write the message
  * \param sMessage The informative message
+ *
+ * When an AsyncLogger has been started on logFile the message is only
+ * queued: the writer thread will write and flush it.
  */
 void
 logMessage(QFile *logFile, QString sFunctionName, QString sMessage) {
+    if(AsyncLogger::post(logFile, sFunctionName, sMessage))
+        return;
     QDateTime dateTime;
     QString sDebugMessage = dateTime.currentDateTime().toString() +
                             QString(" - ") +
@@ -70,6 +82,7 @@ logMessage(QFile *logFile, QString sFunctionName, QString sMessage) {
                             QString(" - ") +
                             sMessage;
     if(logFile) {
+        QMutexLocker locker(&logMutex);
         if(logFile->isOpen()) {
             logFile->write(sDebugMessage.toUtf8().data());
             logFile->write("\n");
@@ -25,6 +25,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //#define LOG_MESG
 //#define LOG_VERBOSE
 //#define LOG_VERBOSE_VERBOSE
+//#define LOG_BINARY // The hot path messages go to a BinaryLog file instead of the flight recorder
 
 #define VOLLEY_PANEL   0
 #define FIRST_PANEL  VOLLEY_PANEL
@@ -0,0 +1,399 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#include <QSocketNotifier>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <linux/videodev2.h>
+
+#include "v4l2capture.h"
+#include "utility.h"
+
+
+#define CAPTURE_BUFFERS 3 // Few buffers: a long queue means old frames
+
+
+/*!
+ * \brief xioctl ioctl() restarted if interrupted by a signal
+ */
+static int
+xioctl(int fd, unsigned long request, void *arg) {
+    int iResult;
+    do {
+        iResult = ioctl(fd, request, arg);
+    } while(iResult == -1 && errno == EINTR);
+    return iResult;
+}
+
+
+/*!
+ * \brief V4L2Capture::V4L2Capture Video capture with memory mapped driver buffers
+ * \param myLogFile The File for message logging (if any)
+ * \param parent
+ *
+ * The frames are handed out wrapping the driver buffers (no copy)
+ * whenever the device can produce an RGB format.
+ * Only the newest frame is shown: older ones are given back
+ * to the driver immediately.
+ */
+V4L2Capture::V4L2Capture(QFile *myLogFile, QObject *parent)
+    : QObject(parent)
+    , logFile(myLogFile)
+    , fd(-1)
+    , pNotifier(Q_NULLPTR)
+    , iHeldBuffer(-1)
+    , pixelFormat(0)
+    , frameWidth(0)
+    , frameHeight(0)
+    , bytesPerLine(0)
+{
+}
+
+
+/*!
+ * \brief V4L2Capture::~V4L2Capture
+ */
+V4L2Capture::~V4L2Capture() {
+    close();
+}
+
+
+/*!
+ * \brief V4L2Capture::monotonicUs
+ * \return The CLOCK_MONOTONIC time in us (the clock of the V4L2 timestamps)
+ */
+qint64
+V4L2Capture::monotonicUs() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return qint64(now.tv_sec)*1000000 + now.tv_nsec/1000;
+}
+
+
+/*!
+ * \brief V4L2Capture::isOpen
+ * \return true if the device is streaming
+ */
+bool
+V4L2Capture::isOpen() {
+    return fd >= 0;
+}
+
+
+/*!
+ * \brief V4L2Capture::open Open the device and start streaming
+ * \param sNewDevice The device (e.g. /dev/video0)
+ * \param preferredSize The frame size to ask for
+ * \return false if the device can't be used
+ */
+bool
+V4L2Capture::open(QString sNewDevice, QSize preferredSize) {
+    close();
+    sDevice = sNewDevice;
+    fd = ::open(sDevice.toLocal8Bit().constData(), O_RDWR | O_NONBLOCK);
+    if(fd < 0) {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Unable to open %1: %2").arg(sDevice, strerror(errno)));
+        return false;
+    }
+    struct v4l2_capability capability;
+    memset(&capability, 0, sizeof(capability));
+    if(xioctl(fd, VIDIOC_QUERYCAP, &capability) < 0 ||
+       !(capability.capabilities & V4L2_CAP_VIDEO_CAPTURE) ||
+       !(capability.capabilities & V4L2_CAP_STREAMING))
+    {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("%1 is not a streaming capture device").arg(sDevice));
+        close();
+        return false;
+    }
+    if(!setFormat(preferredSize) || !mapBuffers()) {
+        close();
+        return false;
+    }
+    enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if(xioctl(fd, VIDIOC_STREAMON, &type) < 0) {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("Unable to start streaming: %1").arg(strerror(errno)));
+        close();
+        return false;
+    }
+    pNotifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(pNotifier, SIGNAL(activated(QSocketDescriptor,QSocketNotifier::Type)),
+            this, SLOT(onFrameAvailable()));
+    logMessage(logFile,
+               Q_FUNC_INFO,
+               QString("%1: %2x%3 format %4")
+               .arg(sDevice)
+               .arg(frameWidth)
+               .arg(frameHeight)
+               .arg(QString::fromLatin1(reinterpret_cast<const char*>(&pixelFormat), 4)));
+    return true;
+}
+
+
+/*!
+ * \brief V4L2Capture::setFormat Negotiate the pixel format
+ * \param preferredSize
+ * \return false if no usable format is available
+ *
+ * The formats that can be shown without conversion come first.
+ */
+bool
+V4L2Capture::setFormat(QSize preferredSize) {
+    const quint32 formats[] = {
+        V4L2_PIX_FMT_BGR32, // Shown as QImage::Format_RGB32
+        V4L2_PIX_FMT_RGB24, // Shown as QImage::Format_RGB888
+        V4L2_PIX_FMT_BGR24, // Shown as QImage::Format_BGR888
+        V4L2_PIX_FMT_YUYV   // Converted
+    };
+    for(size_t i=0; i<sizeof(formats)/sizeof(formats[0]); i++) {
+        struct v4l2_format format;
+        memset(&format, 0, sizeof(format));
+        format.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        format.fmt.pix.width       = preferredSize.width();
+        format.fmt.pix.height      = preferredSize.height();
+        format.fmt.pix.pixelformat = formats[i];
+        format.fmt.pix.field       = V4L2_FIELD_NONE;
+        if(xioctl(fd, VIDIOC_S_FMT, &format) < 0)
+            continue;
+        if(format.fmt.pix.pixelformat != formats[i])
+            continue;// The driver proposed something else
+        pixelFormat  = format.fmt.pix.pixelformat;
+        frameWidth   = int(format.fmt.pix.width);
+        frameHeight  = int(format.fmt.pix.height);
+        bytesPerLine = int(format.fmt.pix.bytesperline);
+        if(bytesPerLine == 0)
+            bytesPerLine = frameWidth * (pixelFormat == V4L2_PIX_FMT_BGR32 ? 4 :
+                                         pixelFormat == V4L2_PIX_FMT_YUYV  ? 2 : 3);
+        return true;
+    }
+    logMessage(logFile,
+               Q_FUNC_INFO,
+               QString("%1: no supported pixel format").arg(sDevice));
+    return false;
+}
+
+
+/*!
+ * \brief V4L2Capture::mapBuffers Ask the driver for its buffers and map them
+ * \return false on failure
+ */
+bool
+V4L2Capture::mapBuffers() {
+    struct v4l2_requestbuffers request;
+    memset(&request, 0, sizeof(request));
+    request.count  = CAPTURE_BUFFERS;
+    request.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    request.memory = V4L2_MEMORY_MMAP;
+    if(xioctl(fd, VIDIOC_REQBUFS, &request) < 0 || request.count < 2) {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("%1: no memory mapped buffers").arg(sDevice));
+        return false;
+    }
+    for(quint32 i=0; i<request.count; i++) {
+        struct v4l2_buffer buffer;
+        memset(&buffer, 0, sizeof(buffer));
+        buffer.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buffer.memory = V4L2_MEMORY_MMAP;
+        buffer.index  = i;
+        if(xioctl(fd, VIDIOC_QUERYBUF, &buffer) < 0)
+            return false;
+        mappedBuffer mapped;
+        mapped.length = buffer.length;
+        mapped.start  = mmap(Q_NULLPTR, buffer.length,
+                             PROT_READ | PROT_WRITE, MAP_SHARED,
+                             fd, buffer.m.offset);
+        if(mapped.start == MAP_FAILED) {
+            logMessage(logFile,
+                       Q_FUNC_INFO,
+                       QString("mmap failed: %1").arg(strerror(errno)));
+            return false;
+        }
+        buffers.append(mapped);
+        if(!queueBuffer(int(i)))
+            return false;
+    }
+    return true;
+}
+
+
+/*!
+ * \brief V4L2Capture::unmapBuffers
+ */
+void
+V4L2Capture::unmapBuffers() {
+    for(int i=0; i<buffers.count(); i++)
+        munmap(buffers.at(i).start, buffers.at(i).length);
+    buffers.clear();
+}
+
+
+/*!
+ * \brief V4L2Capture::queueBuffer Give a buffer back to the driver
+ * \param index
+ * \return false on failure
+ */
+bool
+V4L2Capture::queueBuffer(int index) {
+    struct v4l2_buffer buffer;
+    memset(&buffer, 0, sizeof(buffer));
+    buffer.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buffer.memory = V4L2_MEMORY_MMAP;
+    buffer.index  = quint32(index);
+    if(xioctl(fd, VIDIOC_QBUF, &buffer) < 0) {
+        logMessage(logFile,
+                   Q_FUNC_INFO,
+                   QString("VIDIOC_QBUF failed: %1").arg(strerror(errno)));
+        return false;
+    }
+    return true;
+}
+
+
+/*!
+ * \brief V4L2Capture::close Stop streaming and release the device
+ */
+void
+V4L2Capture::close() {
+    if(pNotifier) {
+        pNotifier->setEnabled(false);
+        pNotifier->deleteLater();
+        pNotifier = Q_NULLPTR;
+    }
+    if(fd >= 0) {
+        enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        xioctl(fd, VIDIOC_STREAMOFF, &type);
+    }
+    convertedFrame = QImage();
+    unmapBuffers();
+    iHeldBuffer = -1;
+    if(fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+
+/*!
+ * \brief V4L2Capture::frameImage The image of a dequeued buffer
+ * \param index The buffer
+ * \param bytesUsed The bytes filled by the driver
+ * \return The image (wrapping the buffer memory for the RGB formats)
+ */
+QImage
+V4L2Capture::frameImage(int index, quint32 bytesUsed) {
+    if(bytesUsed < quint32(bytesPerLine*frameHeight))
+        return QImage();// Incomplete frame
+    const uchar* pData = static_cast<const uchar*>(buffers.at(index).start);
+    switch(pixelFormat) {
+    case V4L2_PIX_FMT_BGR32:
+        return QImage(pData, frameWidth, frameHeight, bytesPerLine, QImage::Format_RGB32);
+    case V4L2_PIX_FMT_RGB24:
+        return QImage(pData, frameWidth, frameHeight, bytesPerLine, QImage::Format_RGB888);
+    case V4L2_PIX_FMT_BGR24:
+        return QImage(pData, frameWidth, frameHeight, bytesPerLine, QImage::Format_BGR888);
+    default:
+        break;
+    }
+    // YUYV: one conversion into a reused image
+    if(convertedFrame.size() != QSize(frameWidth, frameHeight))
+        convertedFrame = QImage(frameWidth, frameHeight, QImage::Format_RGB32);
+    for(int y=0; y<frameHeight; y++) {
+        const uchar* pIn = pData + y*bytesPerLine;
+        QRgb* pOut = reinterpret_cast<QRgb*>(convertedFrame.scanLine(y));
+        for(int x=0; x<frameWidth; x+=2, pIn+=4) {
+            int u = pIn[1] - 128;
+            int v = pIn[3] - 128;
+            int r = (359*v) >> 8;
+            int g = (88*u + 183*v) >> 8;
+            int b = (454*u) >> 8;
+            for(int k=0; k<2 && x+k<frameWidth; k++) {
+                int luma = pIn[2*k];
+                pOut[x+k] = qRgb(qBound(0, luma+r, 255),
+                                 qBound(0, luma-g, 255),
+                                 qBound(0, luma+b, 255));
+            }
+        }
+    }
+    return convertedFrame;
+}
+
+
+/*!
+ * \brief V4L2Capture::onFrameAvailable Dequeue all the ready buffers and show the newest
+ */
+void
+V4L2Capture::onFrameAvailable() {
+    int iNewest = -1;
+    quint32 bytesUsed = 0;
+    qint64 captureTimeUs = 0;
+    for(;;) {
+        struct v4l2_buffer buffer;
+        memset(&buffer, 0, sizeof(buffer));
+        buffer.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buffer.memory = V4L2_MEMORY_MMAP;
+        if(xioctl(fd, VIDIOC_DQBUF, &buffer) < 0) {
+            if(errno == EAGAIN)
+                break;// No more frames
+            // The device is gone (e.g. ENODEV when unplugged) or broken:
+            // the notifier would fire again and again
+            QString sError = QString("VIDIOC_DQBUF failed on %1: %2").arg(sDevice, strerror(errno));
+            logMessage(logFile,
+                       Q_FUNC_INFO,
+                       sError);
+            close();
+            emit captureError(sError);
+            return;
+        }
+        if(iNewest >= 0)
+            queueBuffer(iNewest);// Stale frame: drop it
+        iNewest   = int(buffer.index);
+        bytesUsed = buffer.bytesused;
+        if(buffer.flags & V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC)
+            captureTimeUs = qint64(buffer.timestamp.tv_sec)*1000000 + buffer.timestamp.tv_usec;
+        else
+            captureTimeUs = monotonicUs();// Best we can do
+    }
+    if(iNewest < 0)
+        return;
+    QImage frame = frameImage(iNewest, bytesUsed);
+    if(frame.isNull()) {
+        queueBuffer(iNewest);
+        return;
+    }
+    emit frameReady(frame, captureTimeUs);
+    // The previous frame has been replaced: its buffer can go back to the driver
+    if(iHeldBuffer >= 0)
+        queueBuffer(iHeldBuffer);
+    iHeldBuffer = iNewest;
+    if(pixelFormat == V4L2_PIX_FMT_YUYV) {// Already copied
+        queueBuffer(iHeldBuffer);
+        iHeldBuffer = -1;
+    }
+}
@@ -0,0 +1,80 @@
+/*
+ *
+Copyright (C) 2016  Gabriele Salvato
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+#ifndef V4L2CAPTURE_H
+#define V4L2CAPTURE_H
+
+#include <QObject>
+#include <QImage>
+#include <QSize>
+#include <QVector>
+
+
+QT_FORWARD_DECLARE_CLASS(QFile)
+QT_FORWARD_DECLARE_CLASS(QSocketNotifier)
+
+
+class V4L2Capture : public QObject
+{
+    Q_OBJECT
+
+public:
+    V4L2Capture(QFile *myLogFile = Q_NULLPTR, QObject *parent = Q_NULLPTR);
+    ~V4L2Capture();
+    bool open(QString sDevice, QSize preferredSize);
+    void close();
+    bool isOpen();
+    static qint64 monotonicUs();
+
+signals:
+    void frameReady(QImage frame, qint64 captureTimeUs);/*!< The frame is valid until the next frameReady() */
+    void captureError(QString sError);/*!< The device can't be used anymore: it has been already closed */
+
+private slots:
+    void onFrameAvailable();
+
+private:
+    bool setFormat(QSize preferredSize);
+    bool mapBuffers();
+    void unmapBuffers();
+    bool queueBuffer(int index);
+    QImage frameImage(int index, quint32 bytesUsed);
+
+private:
+    /*!
+     * \brief The mappedBuffer struct A driver buffer mapped in our memory
+     */
+    struct mappedBuffer {
+        void*  start;
+        size_t length;
+    };
+
+    QFile*               logFile;
+    QString              sDevice;
+    int                  fd;
+    QSocketNotifier*     pNotifier;
+    QVector<mappedBuffer> buffers;
+    int                  iHeldBuffer;
+    quint32              pixelFormat;
+    int                  frameWidth;
+    int                  frameHeight;
+    int                  bytesPerLine;
+    QImage               convertedFrame;
+};
+
+#endif // V4L2CAPTURE_H